@@ -209,7 +209,7 @@ void loop()
             char cLon[12];
 
             PRINTF(dbgColor_none, "Location Information\r");
-            PRINTF(dbgColor_info, "Lat=%f, Lon=%f \r", location.lat.val, location.lon.val);
+            PRINTF(dbgColor_info, "Lat=%f, Lon=%f \r", gnss_toDegrees(location.lat.val), gnss_toDegrees(location.lon.val));
         }
         else
             PRINTF(dbgColor_warn, "Location is not available (GNSS not fixed)\r");
@@ -229,11 +229,12 @@ void loop()
         double envH = bmeSensor.readFloatHumidity();
         double envP = bmeSensor.readFloatPressure() / 3386.4;     // as in Hg
 
-        // convert from meters to feet, then factor altitude (1 inch Hg/1000 feet)
-        double envPc = envP + (location.altitude * 3.281 / 1000);
+        // convert altitude from centimeters to feet, then factor altitude (1 inch Hg/1000 feet)
+        double altitudeFt = gnss_fromCenti(location.altitude) * 3.281;
+        double envPc = envP + (altitudeFt / 1000);
 
         snprintf(msgBody, BODY_SZ, "{\"temperature\":%3.1f, \"humidity\":%3.1f,\"barPressure\":%3.2f,\"barPressureCSL\":%3.2f,\"latitude\":%4.6f,\"longitude\":%4.6f,\"altitude\":%5.1f}"
-            , envT, envH, envP, envPc, location.lat.val, location.lon.val, location.altitude * 3.281);
+            , envT, envH, envP, envPc, gnss_toDegrees(location.lat.val), gnss_toDegrees(location.lon.val), altitudeFt);
 
         PRINTF(dbgColor_info, "%s\r", msgBody);
 
@@ -30,6 +30,7 @@
 
 #define ASCII_cCR '\r'
 #define ASCII_sCR "\r"
+#define ASCII_cLF '\n'
 #define ASCII_cCOMMA ','
 #define ASCII_cNULL '\0'
 #define ASCII_cESC (char)0x1B
@@ -48,6 +49,7 @@
 // ltem1c uses macros and the action_result_t typedef
 
 #define RESULT_CODE_SUCCESS       200
+#define RESULT_CODE_ACCEPTED      202               ///< request accepted for later completion (ex: MQTT publish queued to outbox)
 
 #define RESULT_CODE_BADREQUEST    400
 #define RESULT_CODE_FORBIDDEN     403
@@ -111,12 +113,20 @@ typedef enum ltemNotifType_tag
     ltemNotifType__NETWORK = 100,
     // transport (101-109)
     ltemNotifType_pdpDeactivate = 101,
+    ltemNotifType_psmEnter = 102,
+    ltemNotifType_psmExit = 103,
+    ltemNotifType_networkReady = 104,
     // protocols (111-129)
     ltemNotifType_scktInfo = 111,
     ltemNotifType_scktError = 112,
     ltemNotifType_mqttInfo = 113,
     ltemNotifType_mqttError = 114,
-    // services (131-149)  -  NA to LTEm1c
+    ltemNotifType_mqttConnect = 115,
+    ltemNotifType_mqttDisconnect = 116,
+    // services (131-149)
+    ltemNotifType_gnssFirstFix = 131,
+    ltemNotifType_geofenceEnter = 132,
+    ltemNotifType_geofenceExit = 133,
 
     ltemNotifType__CATASTROPHIC = 200,
     ltemNotifType_memoryAllocFault = 201,
@@ -45,10 +45,13 @@
 #define ACTION_LOCKRETRIES             3        ///< Number of attemps to acquire action lock
 #define ACTION_LOCKRETRY_INTERVALml   50        ///< Millis to wait between action lock acquisition attempts
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define FNV1A_OFFSET          2166136261u       ///< FNV-1a 32-bit hash parameters
+#define FNV1A_PRIME             16777619u
 
 // Local scoped function declarations
 static void s_atcmdInit(const char *cmdStr);
 static void s_copyToDiagnostics();
+static uint32_t s_hashUpdate(uint32_t hash, const char *data, uint16_t dataSz);
 
 
 /**
@@ -84,21 +87,161 @@ bool atcmd_tryInvoke(const char *cmdStr)
  *  \return True if action was invoked, false if not
  */
 bool atcmd_tryInvokeAdv(const char *cmdStr, uint16_t timeout, uint16_t (*taskCompleteParser)(const char *response, char **endptr))
+{
+    if (!atcmd_tryInvokeStart(cmdStr, timeout, taskCompleteParser))
+        return false;
+
+    atcmd_invokeSend();
+    return true;
+}
+
+
+
+/**
+ *	\brief Starts a BGx AT command built in parts. The command is locked and the initial part queued to the TX buffer, but not sent.
+ *
+ *  Complete the command with any number of atcmd_invokeAppend() calls followed by atcmd_invokeSend(). This allows a command to be 
+ *  assembled directly in the TX buffer from preformatted fragments, without formatting into an intermediate command string.
+ * 
+ *	\param cmdStr [in] The first part of the command string to send to the BG96 module.
+ *  \param timeout [in] Number of milliseconds the action can take. Use system default ACTION_TIMEOUTml or your value.
+ *  \param taskCompleteParser [in] Custom command response parser to signal result is complete. NULL for std parser.
+ * 
+ *  \return True if action was started, false if not (action lock not available)
+ */
+bool atcmd_tryInvokeStart(const char *cmdStr, uint16_t timeout, uint16_t (*taskCompleteParser)(const char *response, char **endptr))
 {
     if ( !atcmd__acquireLock(cmdStr, ACTION_LOCKRETRIES) )
         return false;
 
+    if (g_ltem->pwrWake_func != NULL && !g_ltem->pwrWake_func())     // BGx may be sleeping (PSM), wake transparently
+    {
+        atcmd_close();
+        return false;
+    }
+
     g_ltem->atcmd->timeoutMillis = timeout;
     g_ltem->atcmd->invokedAt = lMillis();
     g_ltem->atcmd->taskCompleteParser_func = taskCompleteParser == NULL ? atcmd_okResultParser : taskCompleteParser;
 
     iop_txSend(cmdStr, strlen(cmdStr), false);
+    return true;
+}
+
+
+
+/**
+ *	\brief Appends a part to an AT command started with atcmd_tryInvokeStart().
+ *
+ *	\param cmdPart [in] The command fragment to append.
+ *  \param partSz [in] Size of the command fragment.
+ */
+void atcmd_invokeAppend(const char *cmdPart, uint16_t partSz)
+{
+    g_ltem->atcmd->cmdHash = s_hashUpdate(g_ltem->atcmd->cmdHash, cmdPart, partSz);
+    iop_txSend(cmdPart, partSz, false);
+}
+
+
+
+/**
+ *	\brief Completes an AT command started with atcmd_tryInvokeStart(), the command is terminated and sent to BGx.
+ */
+void atcmd_invokeSend()
+{
     iop_txSend(ASCII_sCR, 1, true);
+}
+
+
+
+/**
+ *	\brief Initialize (reset) an AT command batch.
+ *
+ *	\param batch [in] The application owned batch struct.
+ */
+void atcmd_batchInit(atcmdBatch_t *batch)
+{
+    batch->cmdLine[0] = ASCII_cNULL;
+    batch->cmdCnt = 0;
+    batch->lastExtended = false;
+    batch->failedIndx = ATCMD_BATCH_NOFAIL;
+    batch->replayOnError = true;
+}
+
+
+
+/**
+ *	\brief Add an AT command to a batch. Commands are concatenated into one command line: the "AT" prefix is dropped from
+ *  all but the first command, extended (+) commands are separated by ';'.
+ *
+ *  Only batch commands that can be replayed (settings or queries), on error the batch is replayed command by command to find the failing command.
+ * 
+ *	\param batch [in] The batch being built.
+ *	\param cmdStr [in] The AT command (with AT prefix). The string is referenced, not copied, and must remain valid until the batch is invoked.
+ * 
+ *  \return True if added, false if the batch command line or command count limit would be exceeded.
+ */
+bool atcmd_batchAdd(atcmdBatch_t *batch, const char *cmdStr)
+{
+    const char *cmdBody = (batch->cmdCnt > 0 && strncmp(cmdStr, "AT", 2) == 0) ? cmdStr + 2 : cmdStr;
+    uint16_t lineSz = strlen(batch->cmdLine);
+
+    if (batch->cmdCnt == ATCMD_BATCH_CMDMAX || 
+        lineSz + strlen(cmdBody) + (batch->lastExtended ? 1 : 0) >= ATCMD_BATCH_LINESZ)
+        return false;
+
+    if (batch->lastExtended)
+        strcat(batch->cmdLine, ";");
+    strcat(batch->cmdLine, cmdBody);
+
+    batch->cmds[batch->cmdCnt++] = cmdStr;
+    batch->lastExtended = cmdStr[2] == '+';
     return true;
 }
 
 
 
+/**
+ *	\brief Invoke an AT command batch and wait for the combined result. The BGx stops processing the command line at the first failing command.
+ *
+ *	\param batch [in] The batch to send, batch->failedIndx is set on return.
+ *  \param timeout [in] Number of milliseconds the batch can take (combined for all commands).
+ *  \param closeAction [in] Close the action on result. If false, caller parses the combined response and closes the action.
+ * 
+ *  \return Action result. On error, the result of the failing command (replayed alone, unless batch->replayOnError is cleared) 
+ *  and the action is closed.
+ */
+atcmdResult_t atcmd_batchInvoke(atcmdBatch_t *batch, uint16_t timeout, bool closeAction)
+{
+    atcmdResult_t atResult = {.statusCode = RESULT_CODE_CONFLICT, .response = NULL};
+    batch->failedIndx = ATCMD_BATCH_NOFAIL;
+
+    if (!atcmd_tryInvokeAdv(batch->cmdLine, timeout, atcmd_okResultParser))
+        return atResult;
+
+    atResult = atcmd_awaitResult(closeAction);
+    if (atResult.statusCode == RESULT_CODE_SUCCESS || !batch->replayOnError)
+        return atResult;
+
+    // batch failed: replay commands individually to attribute the error
+    for (size_t i = 0; i < batch->cmdCnt; i++)
+    {
+        if (!atcmd_tryInvokeAdv(batch->cmds[i], timeout, atcmd_okResultParser))
+            break;
+
+        atcmdResult_t cmdResult = atcmd_awaitResult(true);
+        if (cmdResult.statusCode != RESULT_CODE_SUCCESS)
+        {
+            batch->failedIndx = i;
+            PRINTF(DBGCOLOR_warn, "Batch failed @%d: %s\r", i, batch->cmds[i]);
+            return cmdResult;
+        }
+    }
+    return atResult;                                    // error not reproduced individually, return batch error
+}
+
+
+
 /**
  *	\brief Performs data transfer (send) sub-action.
 
@@ -115,6 +258,8 @@ void atcmd_sendRaw(const char *data, uint16_t dataSz, uint16_t timeoutMillis, ui
         g_ltem->atcmd->taskCompleteParser_func = atcmd_okResultParser;
     else 
         g_ltem->atcmd->taskCompleteParser_func = taskCompleteParser_func;
+    g_ltem->atcmd->resultCode = RESULT_CODE_PENDING;                   // sub-action: prompt result is consumed, await the send result
+    g_ltem->atcmd->invokedAt = lMillis();                               // timeout applies to this send
 
     iop_txSend(data, dataSz, true);
 }
@@ -138,6 +283,8 @@ void atcmd_sendRawWithEOTs(const char *data, uint16_t dataSz, const char *eotPhr
         g_ltem->atcmd->taskCompleteParser_func = taskCompleteParser_func;
     else
         g_ltem->atcmd->taskCompleteParser_func = atcmd_okResultParser;
+    g_ltem->atcmd->resultCode = RESULT_CODE_PENDING;                   // sub-action: prompt result is consumed, await the send result
+    g_ltem->atcmd->invokedAt = lMillis();
         
     iop_txSend(data, dataSz, false);
     iop_txSend(eotPhrase, strlen(eotPhrase), true);
@@ -233,6 +380,25 @@ atcmdResult_t atcmd_getResult(bool closeAction)
 }
 
 
+/**
+ *	\brief Get a failed action record from the diagnostics history.
+ *
+ *  \param depth [in] - History depth, 0 is the most recent failure, up to ATCMD_HISTORY_CNT-1.
+ * 
+ *  \return Pointer to the failed action record, NULL if no failure recorded at depth.
+ */
+const atcmdHistory_t *atcmd_getHistory(uint8_t depth)
+{
+    if (depth >= ATCMD_HISTORY_CNT)
+        return NULL;
+
+    uint8_t indx = (g_ltem->atcmd->historyNext + ATCMD_HISTORY_CNT - 1 - depth) % ATCMD_HISTORY_CNT;
+    if (g_ltem->atcmd->history[indx].statusCode == 0)               // slot not used yet
+        return NULL;
+    return &g_ltem->atcmd->history[indx];
+}
+
+
 /**
  *	\brief Sends ESC character to ensure BGx is not in text mode (> prompt awaiting ^Z/ESC).
  */
@@ -291,7 +457,7 @@ resultCode_t atcmd_defaultResultParser(const char *response, const char *preambl
     char *preambleAt = NULL;
     char *terminatorAt = NULL;
 
-    uint8_t preambleSz = strlen(preamble);
+    uint8_t preambleSz = (preamble == NULL) ? 0 : strlen(preamble);
     if (preambleSz)                                                 // process preamble requirements
     {
         preambleAt = strstr(response, preamble);
@@ -315,7 +481,7 @@ resultCode_t atcmd_defaultResultParser(const char *response, const char *preambl
         {
             *endptr = terminatorAt + 4;         // + strlen(OK_COMPLETED_STRING)
         }
-        else if (!terminatorAt)                                              
+        if (!terminatorAt)                                              
         {
             terminatorAt = strstr(termSearchAt, CME_PREABLE);                  // no explicit terminator, look for extended CME errors
             if (terminatorAt)
@@ -325,7 +491,7 @@ resultCode_t atcmd_defaultResultParser(const char *response, const char *preambl
                 return cmeVal;
             }
         }
-        else if (!terminatorAt)
+        if (!terminatorAt)
         {
             terminatorAt = strstr(termSearchAt, ERROR_COMPLETED_STRING);        // no explicit terminator, look for ERROR
             if (terminatorAt)
@@ -334,7 +500,7 @@ resultCode_t atcmd_defaultResultParser(const char *response, const char *preambl
                 return RESULT_CODE_ERROR;
             }
         }
-        else if (!terminatorAt)
+        if (!terminatorAt)
         {
             terminatorAt = strstr(termSearchAt, FAIL_COMPLETED_STRING);         // no explicit terminator, look for FAIL
             if (terminatorAt)
@@ -489,12 +655,10 @@ char *atcmd_strToken(char *source, int delimiter, char *token, uint8_t tokenMax)
  */
 static void s_atcmdInit(const char *cmdStr)
 {
-    /* clearing req/resp buffers now for debug clarity, future likely just insert starting \0 */
-
     // request side of action
     g_ltem->atcmd->isOpen = true;
-    memset(g_ltem->atcmd->cmdStr, 0, IOP_TX_BUFFER_SZ);
-    strncpy(g_ltem->atcmd->cmdStr, cmdStr, MIN(strlen(cmdStr), IOP_TX_BUFFER_SZ));
+    strncpy(g_ltem->atcmd->cmdPrefix, cmdStr, ATCMD_CMDPREFIX_SZ - 1);           // command is not copied, only prefix and hash retained
+    g_ltem->atcmd->cmdHash = s_hashUpdate(FNV1A_OFFSET, cmdStr, strlen(cmdStr));
     g_ltem->atcmd->timeoutMillis = 0;
     g_ltem->atcmd->resultCode = RESULT_CODE_PENDING;
     g_ltem->atcmd->invokedAt = 0;
@@ -507,16 +671,33 @@ static void s_atcmdInit(const char *cmdStr)
 
 
 /**
- *	\brief Copies response\result information at action conclusion. Designed as a diagnostic aid for failed AT actions.
+ *	\brief Copies response\result information at action conclusion into the history ring. Designed as a diagnostic aid for failed AT actions.
  */
 static void s_copyToDiagnostics()
 {
-    memset(g_ltem->atcmd->lastActionError->cmdStr, 0, ACTION_HISTRESPBUF_SZ);
-    strncpy(g_ltem->atcmd->lastActionError->cmdStr, g_ltem->atcmd->cmdStr, ACTION_HISTRESPBUF_SZ-1);
-    memset(g_ltem->atcmd->lastActionError->response, 0, ACTION_HISTRESPBUF_SZ);
-    strncpy(g_ltem->atcmd->lastActionError->response, g_ltem->atcmd->response, ACTION_HISTRESPBUF_SZ-1);
-    g_ltem->atcmd->lastActionError->statusCode = g_ltem->atcmd->resultCode;
-    g_ltem->atcmd->lastActionError->duration = lMillis() - g_ltem->atcmd->invokedAt;
+    atcmdHistory_t *history = &g_ltem->atcmd->history[g_ltem->atcmd->historyNext];
+    g_ltem->atcmd->historyNext = (g_ltem->atcmd->historyNext + 1) % ATCMD_HISTORY_CNT;
+
+    memcpy(history->cmdPrefix, g_ltem->atcmd->cmdPrefix, ATCMD_CMDPREFIX_SZ);
+    history->cmdHash = g_ltem->atcmd->cmdHash;
+    strncpy(history->response, g_ltem->iop->rxCmdBuf->buffer, ATCMD_HISTRESP_SZ - 1);
+    history->response[ATCMD_HISTRESP_SZ - 1] = ASCII_cNULL;
+    history->statusCode = g_ltem->atcmd->resultCode;
+    history->duration = lMillis() - g_ltem->atcmd->invokedAt;
+}
+
+
+/**
+ *	\brief FNV-1a hash update, hash a command in parts by passing the prior result as hash.
+ */
+static uint32_t s_hashUpdate(uint32_t hash, const char *data, uint16_t dataSz)
+{
+    for (uint16_t i = 0; i < dataSz; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
 }
 
 
@@ -34,16 +34,19 @@
 #define RESULT_CODE_PENDING       0xFFFF        ///< Value returned from response parsers indicating a pattern match has not yet been detected
 
 // structure sizing
-#define ACTION_HISTRESPBUF_SZ        240        ///< Size of response captured by action history (action error diagnostics)
+#define ATCMD_CMDPREFIX_SZ            28        ///< Size of the command prefix retained for diagnostics (includes null terminator)
+#define ATCMD_HISTRESP_SZ             48        ///< Size of response captured by action history (action error diagnostics)
+#define ATCMD_HISTORY_CNT              4        ///< Number of failed actions retained in the history ring
 
 
 /** 
- *  \brief Record of last action, NOTE: only set on action NON-SUCCESS.
+ *  \brief Record of a failed action, NOTE: only set on action NON-SUCCESS.
 */
 typedef struct atcmdHistory_tag
 {
-    char cmdStr[IOP_TX_BUFFER_SZ];              ///< AT command string to be passed to the BGx module.
-    char response[ACTION_HISTRESPBUF_SZ];       ///< The char c-string containing the full response from the BGx.
+    char cmdPrefix[ATCMD_CMDPREFIX_SZ];         ///< Leading chars of the AT command (truncated).
+    uint32_t cmdHash;                           ///< FNV-1a hash of the full AT command, distinguishes commands with the same prefix.
+    char response[ATCMD_HISTRESP_SZ];           ///< Leading chars of the response from the BGx (truncated).
     uint32_t duration;                          ///< Duration from AT invoke to action complete (or timeout)
     resultCode_t statusCode;                    ///< The HTML style status code, indicates the sucess or failure (type) for the command's invocation.
 } atcmdHistory_t;
@@ -54,17 +57,37 @@ typedef struct atcmdHistory_tag
 */
 typedef struct atcmd_tag
 {
-    char cmdStr[IOP_TX_BUFFER_SZ];      ///< AT command string to be passed to the BGx module.
+    char cmdPrefix[ATCMD_CMDPREFIX_SZ]; ///< Leading chars of the AT command passed to the BGx module (command is not copied).
+    uint32_t cmdHash;                   ///< FNV-1a hash of the full AT command (including parts appended with atcmd_invokeAppend).
     bool isOpen;                        ///< True if the command is still open, AT commands are single threaded and this blocks a new cmd initiation.
     uint32_t invokedAt;                 ///< Tick value at the command invocation, used for timeout detection.
     uint16_t resultCode;                ///< HTML type response code, 0 is special "pending" status, see ACTION_RESULT_* codes.
-    char *response;                     ///< The response to the command received from the BGx.
     uint16_t timeoutMillis;             ///< Timout in milliseconds for the command, defaults to 300mS. BGx documentation indicates cmds with longer timeout.
-    atcmdHistory_t *lastActionError;   ///< Struct containing information on last action response\result. NOTE: only set on NON-SUCCESS.
+    atcmdHistory_t history[ATCMD_HISTORY_CNT];  ///< Ring of the most recent failed actions. NOTE: only set on NON-SUCCESS.
+    uint8_t historyNext;                ///< Index in history of the next failure record (oldest entry when full).
     uint16_t (*taskCompleteParser_func)(const char *response, char **endptr);  ///< Function to parse the response looking for completion.
 } atcmd_t;
 
 
+#define ATCMD_BATCH_LINESZ           200        ///< Max batched command line, combined response must also fit IOP command buffer (256)
+#define ATCMD_BATCH_CMDMAX             8        ///< Max number of commands in a batch
+#define ATCMD_BATCH_NOFAIL           255        ///< Batch failedIndx value if no command failed
+
+
+/** 
+ *  \brief Structure to build a batch of AT commands sent to the BGx as a single command line (ex: AT+CMEE=2;+QCFG="band"...)
+*/
+typedef struct atcmdBatch_tag
+{
+    char cmdLine[ATCMD_BATCH_LINESZ];           ///< Concatenated command line.
+    const char *cmds[ATCMD_BATCH_CMDMAX];       ///< The individual commands in the batch, used to attribute an error to a command.
+    uint8_t cmdCnt;                             ///< Number of commands in the batch.
+    bool lastExtended;                          ///< Last command added is an extended (+) command, needs ';' separator before next.
+    uint8_t failedIndx;                         ///< After invoke, index of the failing command (ATCMD_BATCH_NOFAIL if none).
+    bool replayOnError;                         ///< On error, replay commands individually to set failedIndx (default true).
+} atcmdBatch_t;
+
+
 /** 
  *  \brief Result structure returned from a action request (await or get).
 */
@@ -83,13 +106,21 @@ extern "C" {
 
 bool atcmd_tryInvoke(const char *cmdStr);
 bool atcmd_tryInvokeAdv(const char *cmdStr, uint16_t timeout, uint16_t (*customCmdCompleteParser_func)(const char *response, char **endptr));
+bool atcmd_tryInvokeStart(const char *cmdStr, uint16_t timeout, uint16_t (*customCmdCompleteParser_func)(const char *response, char **endptr));
+void atcmd_invokeAppend(const char *cmdPart, uint16_t partSz);
+void atcmd_invokeSend();
 void atcmd_sendRaw(const char *data, uint16_t dataSz, uint16_t timeoutMillis, uint16_t (*customCmdCompleteParser_func)(const char *response, char **endptr));
 void atcmd_sendRawWithEOTs(const char *data, uint16_t dataSz, const char* eotPhrase, uint16_t timeoutMillis, uint16_t (*customCmdCompleteParser_func)(const char *response, char **endptr));
 
+void atcmd_batchInit(atcmdBatch_t *batch);
+bool atcmd_batchAdd(atcmdBatch_t *batch, const char *cmdStr);
+atcmdResult_t atcmd_batchInvoke(atcmdBatch_t *batch, uint16_t timeout, bool closeAction);
+
 atcmdResult_t atcmd_awaitResult(bool closeAction);
 atcmdResult_t atcmd_getResult(bool closeAction);
 bool actn_acquireLock(const char *cmdStr, uint8_t retries);
 void atcmd_close();
+const atcmdHistory_t *atcmd_getHistory(uint8_t depth);
 
 void atcmd_exitTextMode();
 void atcmd_exitDataMode();
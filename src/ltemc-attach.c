@@ -0,0 +1,213 @@
+/******************************************************************************
+ *  \file ltemc-attach.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ ******************************************************************************
+ * Startup orchestration: network attach and GNSS first fix in parallel, each
+ * signaled to the application independently as it completes.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-attach.h"
+
+
+static attach_t attachState;
+
+
+// private local declarations
+static void s_ntwkWork();
+static void s_gnssWork();
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Start network attach and (optionally) GNSS first fix together. Progress is advanced by ltem_doWork(), the application 
+ *  is notified as each completes: ltemNotifType_networkReady and ltemNotifType_gnssFirstFix.
+ *
+ *  BGx registers with the network on its own following power on, attach is tracked by the +CEREG URC and completed by activating 
+ *  the data context (g_ltem->dataContext) if not already active. GNSS searches for satellites while the BGx is attaching.
+ * 
+ *  \param gnssFix [in] - Start GNSS and track first fix.
+ *  \param ntwkTimeoutSec [in] - Seconds to wait for network ready.
+ *  \param gnssTimeoutSec [in] - Seconds to wait for GNSS first fix.
+ */
+void attach_start(bool gnssFix, uint16_t ntwkTimeoutSec, uint16_t gnssTimeoutSec)
+{
+    memset(&attachState, 0, sizeof(attach_t));
+    attachState.startAt = lMillis();
+    attachState.ntwkTimeout = PERIOD_FROM_SECONDS((uint32_t)ntwkTimeoutSec);
+    attachState.gnssTimeout = PERIOD_FROM_SECONDS((uint32_t)gnssTimeoutSec);
+
+    if (gnssFix)                                                            // GNSS first, satellite search overlaps attach
+    {
+        resultCode_t rslt = gnss_on();
+        if (rslt == RESULT_CODE_SUCCESS || rslt == GNSS_RESULT_SESSIONACTIVE)
+        {
+            attachState.gnssState = attachGnssState_searching;
+            attachState.gnssPolledAt = attachState.startAt;
+        }
+    }
+
+    ntwk_awaitOperator(0);                                                  // no wait: single check, registration may predate URC reporting
+    attachState.ntwkState = attachNtwkState_registering;
+    g_ltem->attachWork_func = &attach_doWork;
+}
+
+
+
+/**
+ *	\brief Get network attach progress.
+ */
+attachNtwkState_t attach_getNtwkState()
+{
+    return attachState.ntwkState;
+}
+
+
+
+/**
+ *	\brief Get GNSS first fix progress.
+ */
+attachGnssState_t attach_getGnssState()
+{
+    return attachState.gnssState;
+}
+
+
+
+/**
+ *	\brief Get orchestration status, including durations to network ready and first fix and the first fix location.
+ */
+const attach_t *attach_getStatus()
+{
+    return &attachState;
+}
+
+
+
+/**
+ *	\brief Background work, advances network attach and GNSS first fix. Invoked by ltem_doWork() once attach_start() is called.
+ */
+void attach_doWork()
+{
+    if (attachState.ntwkState == attachNtwkState_registering)
+        s_ntwkWork();
+
+    if (attachState.gnssState == attachGnssState_searching)
+        s_gnssWork();
+
+    if (attachState.ntwkState != attachNtwkState_registering && attachState.gnssState != attachGnssState_searching)
+        g_ltem->attachWork_func = NULL;                                     // orchestration complete
+}
+
+
+#pragma endregion
+
+
+/* private functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief Network ready when registered (cached from +CEREG) and the data context is active.
+ * 
+ *  Activation is requested without waiting (AT+QIACT can take many seconds), the result is collected on a later pass; the AT 
+ *  action lock is only held briefly (NTWK_ACTIVATE_HOLDml). A failed attempt is retried after ATTACH_ACTIVATERETRYml.
+ */
+static void s_ntwkWork()
+{
+    if (attachState.activating)
+    {
+        resultCode_t rslt = ntwk_getActivateResult();
+        if (rslt == RESULT_CODE_ACCEPTED)
+            return;
+        attachState.activating = false;
+        PRINTF((rslt == RESULT_CODE_SUCCESS) ? dbgColor_info : dbgColor_warn, "Context activate=%d\r", rslt);
+    }
+
+    if (ntwk_isRegistered())
+    {
+        if (ntwk_getPdpCntxt(g_ltem->dataContext) == NULL)                 // other contexts may be active, data context is required
+        {
+            if ((attachState.activateAt == 0 || lTimerExpired(attachState.activateAt, ATTACH_ACTIVATERETRYml)) && !g_ltem->atcmd->isOpen)
+            {
+                attachState.activateAt = lMillis();
+                attachState.activating = (ntwk_activatePdpContextAsync(g_ltem->dataContext) == RESULT_CODE_ACCEPTED);
+            }
+        }
+        else
+        {
+            attachState.ntwkState = attachNtwkState_ready;
+            attachState.ntwkReadyDuration = lMillis() - attachState.startAt;
+            PRINTF(dbgColor_info, "Network ready @%lums\r", attachState.ntwkReadyDuration);
+            ltem_notifyApp(ltemNotifType_networkReady, "Network ready");
+            return;
+        }
+    }
+    if (lTimerExpired(attachState.startAt, attachState.ntwkTimeout))
+        attachState.ntwkState = attachNtwkState_timeout;
+}
+
+
+/**
+ *	\brief Non-blocking GNSS fix check (one AT+QGPSLOC per poll interval), skipped if the command channel is busy.
+ */
+static void s_gnssWork()
+{
+    if (!lTimerExpired(attachState.gnssPolledAt, ATTACH_GNSSPOLLml) || g_ltem->atcmd->isOpen)
+        return;
+    attachState.gnssPolledAt = lMillis();
+
+    gnssLocation_t location = gnss_getLocation();
+    if (location.statusCode == RESULT_CODE_SUCCESS)
+    {
+        attachState.gnssState = attachGnssState_fixed;
+        attachState.gnssFixDuration = lMillis() - attachState.startAt;
+        attachState.firstFix = location;
+        PRINTF(dbgColor_info, "GNSS first fix @%lums\r", attachState.gnssFixDuration);
+        ltem_notifyApp(ltemNotifType_gnssFirstFix, "GNSS first fix");
+    }
+    else if (lTimerExpired(attachState.startAt, attachState.gnssTimeout))
+        attachState.gnssState = attachGnssState_timeout;
+}
+
+#pragma endregion
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *  \file ltemc-attach.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ ******************************************************************************
+ * Startup orchestration: network attach and GNSS first fix in parallel, each
+ * signaled to the application independently as it completes.
+ *****************************************************************************/
+
+#ifndef __LTEMC_ATTACH_H__
+#define __LTEMC_ATTACH_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ATTACH_GNSSPOLLml 2000U             ///< GNSS fix check interval, until first fix
+#define ATTACH_ACTIVATERETRYml 10000U       ///< Data context activation retry interval, following a failed attempt
+
+
+/** 
+ *  \brief Enum describing progress of the network attach.
+*/
+typedef enum attachNtwkState_tag
+{
+    attachNtwkState_idle = 0,               ///< Not started
+    attachNtwkState_registering = 1,        ///< Waiting for network registration (+CEREG URC)
+    attachNtwkState_ready = 2,              ///< Registered and PDP context active, ltemNotifType_networkReady signaled
+    attachNtwkState_timeout = 3             ///< Not ready within timeout
+} attachNtwkState_t;
+
+
+/** 
+ *  \brief Enum describing progress of the GNSS first fix.
+*/
+typedef enum attachGnssState_tag
+{
+    attachGnssState_off = 0,                ///< Not requested (or GNSS failed to start)
+    attachGnssState_searching = 1,          ///< GNSS on, waiting for fix
+    attachGnssState_fixed = 2,              ///< First fix obtained, ltemNotifType_gnssFirstFix signaled
+    attachGnssState_timeout = 3             ///< No fix within timeout
+} attachGnssState_t;
+
+
+/** 
+ *  \brief Struct for the startup orchestration state.
+*/
+typedef struct attach_tag
+{
+    attachNtwkState_t ntwkState;            ///< Network attach progress
+    attachGnssState_t gnssState;            ///< GNSS first fix progress
+    uint32_t startAt;                       ///< Time (millis) orchestration started
+    uint32_t ntwkTimeout;                   ///< Network attach timeout (millis)
+    uint32_t gnssTimeout;                   ///< GNSS first fix timeout (millis)
+    uint32_t ntwkReadyDuration;             ///< Time to network ready (millis), 0 until ready
+    uint32_t gnssFixDuration;               ///< Time to first fix (millis), 0 until fixed
+    uint32_t gnssPolledAt;                  ///< Time (millis) of last GNSS fix check
+    uint32_t activateAt;                    ///< Time (millis) of last data context activation attempt
+    bool activating;                        ///< Data context activation requested, result pending
+    gnssLocation_t firstFix;                ///< GNSS first fix location
+} attach_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void attach_start(bool gnssFix, uint16_t ntwkTimeoutSec, uint16_t gnssTimeoutSec);
+attachNtwkState_t attach_getNtwkState();
+attachGnssState_t attach_getGnssState();
+const attach_t *attach_getStatus();
+
+void attach_doWork();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_ATTACH_H__
@@ -0,0 +1,338 @@
+/******************************************************************************
+ *  \file ltemc-dns.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * DNS resolver (BGx QIDNSGIP) with a small LRU cache honoring record TTL.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-dns.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define DNS_CMD_SZ (DNS_HOSTSZ + 24)
+#define DNS_URC_LANDMARK "+QIURC: \"dnsgip\","
+#define DNS_URC_LANDMARKSZ 17
+
+static dnsCacheEntry_t dnsCache[DNS_CACHE_CNT];
+static dnsLookup_t lookup;
+
+
+// private local declarations
+static void s_lookupComplete(resultCode_t resultCode);
+static void s_cacheInsert(const char *host, const char *addr, uint32_t ttlSeconds);
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Resolve a host name to an IP address, from cache if the cached entry has not reached its TTL, otherwise by a BGx 
+ *  DNS lookup (blocking until the result URC arrives). Resolved addresses are cached.
+ *
+ *  \param host [in] - Host name (an IP address is returned as is).
+ *  \param addr [out] - Char buffer (DNS_ADDRSZ) to receive the IP address.
+ * 
+ *  \return 200 if resolved, otherwise error code: 408 timeout, 409 lookup in progress, BGx DNS errors (565 etc.).
+ */
+resultCode_t dns_resolve(const char *host, char *addr)
+{
+    if (dns__isIpAddress(host))
+    {
+        if (strlen(host) >= DNS_ADDRSZ)
+            return RESULT_CODE_BADREQUEST;
+        strcpy(addr, host);
+        return RESULT_CODE_SUCCESS;
+    }
+    if (dns_getCached(host, addr))
+        return RESULT_CODE_SUCCESS;
+
+    resultCode_t rslt = dns_resolveAsync(host);
+    if (rslt != RESULT_CODE_ACCEPTED)
+        return rslt;
+
+    while ((rslt = dns_getResult(addr)) == RESULT_CODE_ACCEPTED)
+    {
+        lYield();
+    }
+    return rslt;
+}
+
+
+/**
+ *	\brief Request a BGx DNS lookup, the result arrives by URC and is collected with dns_getResult(). The cache is not consulted.
+ *
+ *  \param host [in] - Host name.
+ * 
+ *  \return 202 if lookup requested, otherwise error code: 400 host too long, 409 lookup in progress or AT action busy.
+ */
+resultCode_t dns_resolveAsync(const char *host)
+{
+    char dnsCmd[DNS_CMD_SZ] = {0};
+
+    if (strlen(host) >= DNS_HOSTSZ)
+        return RESULT_CODE_BADREQUEST;
+    if (lookup.pending && !lTimerExpired(lookup.startAt, PERIOD_FROM_SECONDS(DNS_TIMEOUTsec)))
+        return RESULT_CODE_CONFLICT;
+
+    memset(&lookup, 0, sizeof(dnsLookup_t));
+    strcpy(lookup.host, host);
+    lookup.startAt = lMillis();
+    lookup.pending = true;
+    ((iop_t *)g_ltem->iop)->peerTypeMap.dnsLookup = 1;
+
+    snprintf(dnsCmd, DNS_CMD_SZ, "AT+QIDNSGIP=%d,\"%s\"", g_ltem->dataContext, host);
+    if (!atcmd_tryInvoke(dnsCmd))
+    {
+        s_lookupComplete(RESULT_CODE_CONFLICT);
+        return RESULT_CODE_CONFLICT;
+    }
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+    if (atResult.statusCode == RESULT_CODE_SUCCESS)                     // fast (cached by BGx) result may arrive with OK
+        dns__urcDnsgip(atResult.response, strlen(atResult.response));
+    atcmd_close();
+
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+    {
+        s_lookupComplete(atResult.statusCode);
+        return atResult.statusCode;
+    }
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief Get the result of the last lookup (dns_resolveAsync).
+ *
+ *  \param addr [out] - Char buffer (DNS_ADDRSZ) to receive the IP address, if resolved. Can be NULL.
+ * 
+ *  \return 200 if resolved, 202 if lookup pending, 404 if no lookup requested, otherwise lookup error (408 timeout, BGx DNS error).
+ */
+resultCode_t dns_getResult(char *addr)
+{
+    if (lookup.pending)
+    {
+        if (!lTimerExpired(lookup.startAt, PERIOD_FROM_SECONDS(DNS_TIMEOUTsec)))
+            return RESULT_CODE_ACCEPTED;
+        s_lookupComplete(RESULT_CODE_TIMEOUT);
+    }
+    if (lookup.resultCode == 0)
+        return RESULT_CODE_NOTFOUND;
+    if (lookup.resultCode == RESULT_CODE_SUCCESS && addr != NULL)
+        strcpy(addr, lookup.addr);
+    return lookup.resultCode;
+}
+
+
+/**
+ *	\brief Get the cached address for a host, entries past their TTL are removed.
+ *
+ *  \param host [in] - Host name.
+ *  \param addr [out] - Char buffer (DNS_ADDRSZ) to receive the IP address.
+ * 
+ *  \return True if a current cache entry was found.
+ */
+bool dns_getCached(const char *host, char *addr)
+{
+    for (size_t i = 0; i < DNS_CACHE_CNT; i++)
+    {
+        if (dnsCache[i].host[0] != ASCII_cNULL && strcmp(dnsCache[i].host, host) == 0)
+        {
+            if (lTimerExpired(dnsCache[i].resolvedAt, dnsCache[i].ttl))
+            {
+                dnsCache[i].host[0] = ASCII_cNULL;
+                return false;
+            }
+            dnsCache[i].lastUsed = lMillis();
+            strcpy(addr, dnsCache[i].addr);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ *	\brief Remove a host from the cache, ex: when a connection to the cached address fails.
+ */
+void dns_invalidate(const char *host)
+{
+    for (size_t i = 0; i < DNS_CACHE_CNT; i++)
+    {
+        if (strcmp(dnsCache[i].host, host) == 0)
+            dnsCache[i].host[0] = ASCII_cNULL;
+    }
+}
+
+
+/**
+ *	\brief Remove all entries from the cache.
+ */
+void dns_flush()
+{
+    memset(dnsCache, 0, sizeof(dnsCache));
+}
+
+
+/**
+ *	\brief Test if a host is given as an IP address (IPv4 dotted or IPv6), no lookup required.
+ */
+bool dns__isIpAddress(const char *host)
+{
+    if (strchr(host, ':') != NULL)
+        return true;
+    for (const char *ptr = host; *ptr != ASCII_cNULL; ptr++)
+    {
+        if (*ptr != '.' && (*ptr < '0' || *ptr > '9'))
+            return false;
+    }
+    return *host != ASCII_cNULL;
+}
+
+
+/**
+ *	\brief URC handler (ISR context) for lookup results, a chunk can hold several result lines:
+ *      +QIURC: "dnsgip",<err>,<addrCnt>,<ttl>
+ *      +QIURC: "dnsgip","<addr>"           (addrCnt lines)
+ *
+ *  \param urcData [in] - Received chunk.
+ *  \param dataSz [in] - Size of chunk.
+ */
+void dns__urcDnsgip(const char *urcData, uint16_t dataSz)
+{
+    const char *dataEnd = urcData + dataSz;
+
+    for (const char *urcAt = urcData; lookup.pending && urcAt + DNS_URC_LANDMARKSZ < dataEnd; urcAt++)
+    {
+        if (*urcAt != '+' || memcmp(urcAt, DNS_URC_LANDMARK, DNS_URC_LANDMARKSZ) != 0)
+            continue;
+
+        urcAt += DNS_URC_LANDMARKSZ;
+        if (*urcAt == ASCII_cDBLQUOTE)                                  // address line
+        {
+            const char *addrEnd = memchr(urcAt + 1, ASCII_cDBLQUOTE, dataEnd - urcAt - 1);
+            if (addrEnd == NULL)
+                return;
+            uint8_t addrSz = addrEnd - urcAt - 1;
+            if (lookup.addrRecvd == 0 && addrSz < DNS_ADDRSZ)
+            {
+                memcpy(lookup.addr, urcAt + 1, addrSz);
+                lookup.addr[addrSz] = ASCII_cNULL;
+            }
+            lookup.addrRecvd++;
+        }
+        else                                                            // result header line
+        {
+            char *endPtr;
+            uint16_t err = strtol(urcAt, &endPtr, 10);
+            if (err != 0)
+            {
+                s_lookupComplete(err);
+                return;
+            }
+            lookup.addrCnt = strtol(endPtr + 1, &endPtr, 10);
+            lookup.ttl = strtol(endPtr + 1, NULL, 10);
+        }
+
+        if (lookup.addrCnt > 0 && lookup.addrRecvd >= lookup.addrCnt)
+        {
+            if (lookup.addr[0] == ASCII_cNULL)
+            {
+                s_lookupComplete(RESULT_CODE_ERROR);
+                return;
+            }
+            s_cacheInsert(lookup.host, lookup.addr, lookup.ttl);
+            s_lookupComplete(RESULT_CODE_SUCCESS);
+        }
+    }
+}
+
+#pragma endregion
+
+
+/* private functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief [private] Close out the lookup, IOP stops checking for lookup URCs.
+ */
+static void s_lookupComplete(resultCode_t resultCode)
+{
+    PRINTF(dbgColor_info, "dns: %s rslt=%d addr=%s\r", lookup.host, resultCode, lookup.addr);
+    lookup.resultCode = resultCode;
+    lookup.pending = false;
+    ((iop_t *)g_ltem->iop)->peerTypeMap.dnsLookup = 0;
+}
+
+
+/**
+ *	\brief [private] Add (or refresh) a cache entry, replacing an empty or expired entry or the least recently used entry.
+ */
+static void s_cacheInsert(const char *host, const char *addr, uint32_t ttlSeconds)
+{
+    if (ttlSeconds == 0)                                                // record not cacheable
+        return;
+
+    uint32_t now = lMillis();
+    uint8_t slot = 0;
+    uint32_t slotAge = 0;
+
+    for (size_t i = 0; i < DNS_CACHE_CNT; i++)
+    {
+        if (dnsCache[i].host[0] == ASCII_cNULL || strcmp(dnsCache[i].host, host) == 0 || lTimerExpired(dnsCache[i].resolvedAt, dnsCache[i].ttl))
+        {
+            slot = i;
+            break;
+        }
+        if (now - dnsCache[i].lastUsed > slotAge)                       // least recently used
+        {
+            slot = i;
+            slotAge = now - dnsCache[i].lastUsed;
+        }
+    }
+    strcpy(dnsCache[slot].host, host);
+    strcpy(dnsCache[slot].addr, addr);
+    dnsCache[slot].resolvedAt = now;
+    dnsCache[slot].ttl = PERIOD_FROM_SECONDS(MIN(ttlSeconds, DNS_TTL_MAXsec));
+    dnsCache[slot].lastUsed = now;
+}
+
+#pragma endregion
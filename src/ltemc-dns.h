@@ -0,0 +1,89 @@
+/******************************************************************************
+ *  \file ltemc-dns.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * DNS resolver (BGx QIDNSGIP) with a small LRU cache honoring record TTL.
+ *****************************************************************************/
+
+#ifndef __LTEMC_DNS_H__
+#define __LTEMC_DNS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DNS_CACHE_CNT 4                     ///< Cached host entries, least recently used entry is replaced
+#define DNS_HOSTSZ 64                       ///< Max host name length (+1), longer names are not cached
+#define DNS_ADDRSZ 40                       ///< IP address string (IPv6 max 39 chars)
+#define DNS_TIMEOUTsec 60                   ///< BGx DNS lookup timeout
+#define DNS_TTL_MAXsec 86400                ///< Cap on cached TTL
+
+
+/** 
+ *  \brief Struct for a DNS cache entry.
+*/
+typedef struct dnsCacheEntry_tag
+{
+    char host[DNS_HOSTSZ];                  ///< Host name, empty if entry unused
+    char addr[DNS_ADDRSZ];                  ///< First address reported by BGx
+    uint32_t resolvedAt;                    ///< Millis when resolved
+    uint32_t ttl;                           ///< Record time-to-live (millis)
+    uint32_t lastUsed;                      ///< Millis of last cache hit (LRU)
+} dnsCacheEntry_t;
+
+
+/** 
+ *  \brief Struct for an in-progress lookup, filled by the +QIURC: "dnsgip" URC handler (ISR).
+*/
+typedef struct dnsLookup_tag
+{
+    char host[DNS_HOSTSZ];                  ///< Host being resolved
+    char addr[DNS_ADDRSZ];                  ///< First address reported
+    uint32_t startAt;                       ///< Millis when lookup requested
+    uint8_t addrCnt;                        ///< Address URCs expected
+    uint8_t addrRecvd;                      ///< Address URCs received
+    uint32_t ttl;                           ///< Reported TTL (seconds)
+    volatile bool pending;                  ///< Lookup requested, result not yet received
+    volatile resultCode_t resultCode;       ///< 200 if resolved, otherwise BGx DNS error (565 parse failed, etc.) or 408
+} dnsLookup_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+resultCode_t dns_resolve(const char *host, char *addr);
+resultCode_t dns_resolveAsync(const char *host);
+resultCode_t dns_getResult(char *addr);
+bool dns_getCached(const char *host, char *addr);
+void dns_invalidate(const char *host);
+void dns_flush();
+
+// semi-private functions, not intended for most application but not static for special needs
+bool dns__isIpAddress(const char *host);
+void dns__urcDnsgip(const char *urcData, uint16_t dataSz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_DNS_H__
@@ -34,16 +34,69 @@
 #define FILE_POS_DATAOFFSET     12      ///< +QFPOSITION: 
 #define FILE_OPEN_DATAOFFSET     9      ///< +QFOPEN: {filehandle}
 #define FILE_TIMEOUTml         800
+#define FILE_READ_OVRHDSZ       32      ///< read data header and trailer: \r\nCONNECT <readSz>\r\n<data>\r\nOK\r\n
+#define FILE_READ_CHUNKSZ  (IOP_RX_DATABUF_SZ - FILE_READ_OVRHDSZ)    ///< read data flows through an IOP data buffer (file data peer)
+#define FILE_LIST_DATAOFFSET    8       ///< +QFLST: 
+#define FILE_WRITE_CHUNKSZ    1024      ///< write data is queued in IOP TX buffer (1460 bytes) with the QFWRITE command
 
+#define FILE_XFER_TIMEOUTsec     5      ///< BGx upload receive timeout, BGx ends upload if data stalls
+#define FILE_RESULT_NOTFOUND   405      ///< BGx +CME ERROR: file not found
 
+#define FILE_RECVR_MAXCNT        4      ///< number of open files that can have a distinct receiver function
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+typedef resultCode_t (*fileDataParser_func_t)(iopBuffer_t *dataBuf);
+
+typedef struct fileRecvrEntry_tag
+{
+    uint16_t fileHandle;
+    fileReceiver_func_t fileRecvr_func;
+} fileRecvrEntry_t;
+
+// file scope variables
+static fileReceiver_func_t s_fileRecvr_func = NULL;             // default receiver for file read data
+static fileRecvrEntry_t s_fileRecvrs[FILE_RECVR_MAXCNT];        // receivers registered at open, by file handle
+static fileReceiver_func_t s_xferRecvr_func = NULL;             // download: application receiver
+static uint32_t s_xferSz;                                       // download: bytes delivered
+static uint16_t s_xferChecksum;                                 // download: checksum of bytes delivered
+
+// private local declarations
+static fileReceiver_func_t s_getRecvrFunc(uint16_t fileHandle);
+static void s_setRecvrFunc(uint16_t fileHandle, fileReceiver_func_t fileRecvr_func);
+static bool s_dataPeerInvoke(const char *fileCmd);
+static resultCode_t s_dataPeerAwait(fileDataParser_func_t dataParser, iopBuffer_t **dataBuf);
+static void s_dataPeerClose();
+static resultCode_t s_errorParser(const char *response);
+static resultCode_t s_readCompleteParser(iopBuffer_t *dataBuf);
+static resultCode_t s_listCompleteParser(iopBuffer_t *dataBuf);
+static resultCode_t s_writePromptParser(const char *response, char **endptr);
+static resultCode_t s_writeCompleteParser(const char *response, char **endptr);
+static resultCode_t s_uploadResume(const char* fileName, uint32_t fileSz, fileUploadResult_t *fileResult, fileSource_func_t source_func, fileProgress_func_t progress_func);
+static void s_downloadRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz);
+static resultCode_t s_uploadAckParser(const char *response, char **endptr);
+static resultCode_t s_uploadCompleteParser(const char *response, char **endptr);
+
+
+/**
+ *	\brief Set the application receiver function for file read data. Used for files opened without a receiver function.
+ *
+ *	\param fileRecvr_func [in] - Function to be invoked with data read from a file. Not required if file is write only access.
+ */
 void filsys_setRecvrFunc(fileReceiver_func_t fileRecvr_func)
 {
+    s_fileRecvr_func = fileRecvr_func;
 }
 
 
+/**
+ *	\brief Get file system (UFS) capacity and usage.
+ * 
+ *  \return Struct with the file system sizes and file count, resultCode=200 if successful.
+ */
 fileInfoResult_t filsys_info()
 {
-    fileInfoResult_t fileResult;
+    fileInfoResult_t fileResult = { 0, 0, 0, 0, RESULT_CODE_SUCCESS };
     char *continueAt;
 
     // first get file system info
@@ -86,15 +139,63 @@ fileInfoResult_t filsys_info()
         atcmd_close();
     }
     else
-    {
         fileResult.resultCode = RESULT_CODE_CONFLICT;
-        return fileResult;
-    }
+
+    return fileResult;
 }
 
 
-fileListResult_t filsys_list(const char* fileName)
+/**
+ *	\brief List files matching a name pattern. The response is received through the IOP file data peer, allowing for long listings.
+ *
+ *	\param namePattern [in] - "*" or filename pattern (wildcards * and ? allowed).
+ * 
+ *  \return Struct with up to FILE_LIST_MAXCNT files (name and size) and resultCode=200 if successful.
+ */
+fileListResult_t filsys_list(const char* namePattern)
 {
+    fileListResult_t fileResult = {0};
+    char fileCmd[FILE_CMD_SZ] = {0};
+    iopBuffer_t *dataBuf;
+
+    fileResult.namePattern = namePattern;
+    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFLST=\"%s\"", namePattern);
+
+    if (!s_dataPeerInvoke(fileCmd))
+    {
+        fileResult.resultCode = RESULT_CODE_CONFLICT;
+        return fileResult;
+    }
+    fileResult.resultCode = s_dataPeerAwait(s_listCompleteParser, &dataBuf);
+    if (fileResult.resultCode == RESULT_CODE_SUCCESS)
+    {
+        // parse response
+        // +QFLST: "<filename>",<file_size>\r\n  (repeated)
+        char *continueAt = strstr(dataBuf->buffer, "+QFLST: ");
+        while (continueAt != NULL && fileResult.fileCnt < FILE_LIST_MAXCNT)
+        {
+            fileListItem_t *listItem = &fileResult.fileList[fileResult.fileCnt];
+            char *nameAt = continueAt + FILE_LIST_DATAOFFSET + 1;                          // past opening quote
+            if (memcmp(nameAt, "UFS:", 4) == 0)
+                nameAt += 4;
+            char *nameEnd = strchr(nameAt, '"');
+            if (nameEnd == NULL)
+                break;
+
+            uint8_t nameSz = MIN(nameEnd - nameAt, FILE_LIST_NAMESZ - 1);
+            memcpy(listItem->filename, nameAt, nameSz);
+            listItem->filename[nameSz] = ASCII_cNULL;
+            listItem->fileSize = strtol(nameEnd + 2, &continueAt, 10);                      // past quote and comma
+            fileResult.fileCnt++;
+            continueAt = strstr(continueAt, "+QFLST: ");
+        }
+    }
+    else if (fileResult.resultCode == FILE_RESULT_NOTFOUND)
+    {
+        fileResult.resultCode = RESULT_CODE_SUCCESS;                                      // no matching files, empty list
+    }
+    s_dataPeerClose();
+    return fileResult;
 }
 
 
@@ -119,12 +220,162 @@ resultCode_t filsys_delete(const char* fileName)
 }
 
 
-// fileUploadResult_t filsys_upload(const char* fileName)
-// {
-// }
-// fileDownloadResult_t filsys_download(const char* fileName)
-// {
-// }
+/**
+ *	\brief Upload a file to the file system, content is pulled from the application source function in chunks.
+ *
+ *  A new upload streams through AT+QFUPL (BGx ack mode): the next chunk is sourced and checksummed while the previous chunk is
+ *  transmitted from the IOP TX buffer; BGx's reported checksum is verified on completion. If the upload is interrupted, the 
+ *  result holds the size and checksum of the acknowledged content, pass it as resumeFrom to continue (with AT+QFWRITE).
+ *  NOTE: QFWRITE does not report a checksum, a resumed upload is verified by size only; the returned checksum is computed from
+ *  the source content, compare to filsys_download() to verify the file.
+ * 
+ *	\param fileName [in] - Name of the file to create (an existing file is replaced, unless resuming).
+ *	\param fileSz [in] - Total size of the file.
+ *	\param resumeFrom [in] - Result of an interrupted upload, NULL for a new upload.
+ *	\param source_func [in] - Application function supplying file content.
+ *	\param progress_func [in] - Application function notified after each chunk, can be NULL.
+ * 
+ *  \return Struct with the size and checksum uploaded, resultCode=200 if complete and verified, 500 if checksum mismatch or
+ *  BGx upload result missing, 400 if source ended early.
+ */
+fileUploadResult_t filsys_upload(const char* fileName, uint32_t fileSz, const fileUploadResult_t *resumeFrom, fileSource_func_t source_func, fileProgress_func_t progress_func)
+{
+    fileUploadResult_t fileResult = { 0, 0, RESULT_CODE_SUCCESS };
+    char fileCmd[FILE_CMD_SZ] = {0};
+    char chunkBuf[FILE_XFER_CHUNKSZ];
+
+    if (resumeFrom != NULL && resumeFrom->size > 0)
+    {
+        fileResult.size = resumeFrom->size;
+        fileResult.checksum = resumeFrom->checksum;
+        fileResult.resultCode = s_uploadResume(fileName, fileSz, &fileResult, source_func, progress_func);
+        return fileResult;
+    }
+
+    filsys_delete(fileName);                                            // QFUPL will not replace
+    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFUPL=\"%s\",%lu,%d,1", fileName, (unsigned long)fileSz, FILE_XFER_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(fileCmd, FILE_TIMEOUTml, s_writePromptParser))
+    {
+        fileResult.resultCode = RESULT_CODE_CONFLICT;
+        return fileResult;
+    }
+    atcmdResult_t atResult = atcmd_awaitResult(false);                 // wait for CONNECT
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+    {
+        fileResult.resultCode = atResult.statusCode;
+        atcmd_close();
+        return fileResult;
+    }
+
+    uint16_t chunkSz = source_func(0, chunkBuf, MIN(fileSz, FILE_XFER_CHUNKSZ));
+    while (chunkSz > 0)
+    {
+        uint32_t sentSz = fileResult.size + chunkSz;
+        bool lastChunk = sentSz >= fileSz;
+
+        atcmd_sendRaw(chunkBuf, chunkSz, FILE_TIMEOUTml, lastChunk ? s_uploadCompleteParser : s_uploadAckParser);
+        uint16_t checksum = filsys__checksum(fileResult.checksum, fileResult.size, chunkBuf, chunkSz);
+
+        // TX buffer holds the chunk until sent, chunkBuf is free: pipeline next chunk while BGx receives this one
+        uint16_t nextSz = lastChunk ? 0 : source_func(sentSz, chunkBuf, MIN(fileSz - sentSz, FILE_XFER_CHUNKSZ));
+
+        atResult = atcmd_awaitResult(false);
+        if (atResult.statusCode != RESULT_CODE_SUCCESS)
+        {
+            fileResult.resultCode = atResult.statusCode;
+            atcmd_close();
+            return fileResult;                                          // size\checksum at last acknowledged chunk, can resume
+        }
+        fileResult.size = sentSz;
+        fileResult.checksum = checksum;
+        if (progress_func != NULL)
+            progress_func(fileResult.size, fileSz);
+        if (!lastChunk)
+            iop_resetCmdBuffer();                                       // ack parsed, BGx sends next ack only after next chunk
+        chunkSz = nextSz;
+    }
+
+    // parse response
+    // +QFUPL: <upload_size>,<checksum>
+    char *continueAt = strstr(atResult.response, "+QFUPL: ");
+    if (continueAt != NULL)
+    {
+        uint32_t uploadSz = strtol(continueAt + 8, &continueAt, 10);
+        uint16_t checksum = strtol(++continueAt, &continueAt, 16);
+        if (uploadSz != fileResult.size || checksum != fileResult.checksum)
+            fileResult.resultCode = RESULT_CODE_ERROR;
+    }
+    else                                                                // no BGx upload result, size\checksum unverified
+        fileResult.resultCode = (fileResult.size < fileSz) ? RESULT_CODE_BADREQUEST : RESULT_CODE_ERROR;  // source ended early: BGx waits for remaining data until timeout
+    atcmd_close();
+    return fileResult;
+}
+
+
+/**
+ *	\brief Download a file from the file system, content is delivered to the application receiver function in chunks.
+ *
+ *  The file is read with AT+QFREAD through the IOP file data peer (flow controlled, resumable at any offset), the checksum is 
+ *  computed as data is delivered. Compare to the checksum from filsys_upload() to verify the file.
+ * 
+ *	\param fileName [in] - Name of the file to download.
+ *	\param resumeFrom [in] - Result of an interrupted download, NULL to start at the beginning of the file.
+ *	\param fileRecvr_func [in] - Application function receiving file content.
+ *	\param progress_func [in] - Application function notified after each chunk, can be NULL.
+ * 
+ *  \return Struct with the size and checksum downloaded, resultCode=200 if complete, 500 if file is shorter than its reported size.
+ */
+fileDownloadResult_t filsys_download(const char* fileName, const fileDownloadResult_t *resumeFrom, fileReceiver_func_t fileRecvr_func, fileProgress_func_t progress_func)
+{
+    fileDownloadResult_t fileResult = { 0, 0, RESULT_CODE_SUCCESS };
+    if (resumeFrom != NULL)
+    {
+        fileResult.size = resumeFrom->size;
+        fileResult.checksum = resumeFrom->checksum;
+    }
+
+    fileOpenResult_t openResult = filsys_open(fileName, fileOpenMode_normalRdOnly, s_downloadRecvr);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+    {
+        fileResult.resultCode = openResult.resultCode;
+        return fileResult;
+    }
+
+    uint32_t fileSz = 0;
+    fileResult.resultCode = filsys_seek(openResult.fileHandle, 0, fileSeekMode_seekFromEnd);
+    if (fileResult.resultCode == RESULT_CODE_SUCCESS)
+    {
+        filePositionResult_t posResult = filsys_getPosition(openResult.fileHandle);
+        fileSz = posResult.fileOffset;
+        fileResult.resultCode = posResult.resultCode;
+    }
+    if (fileResult.resultCode == RESULT_CODE_SUCCESS)
+        fileResult.resultCode = filsys_seek(openResult.fileHandle, fileResult.size, fileSeekMode_seekFromBegin);
+
+    s_xferRecvr_func = fileRecvr_func;
+    while (fileResult.resultCode == RESULT_CODE_SUCCESS && fileResult.size < fileSz)
+    {
+        s_xferSz = fileResult.size;
+        s_xferChecksum = fileResult.checksum;
+        fileResult.resultCode = filsys_read(openResult.fileHandle, MIN(fileSz - fileResult.size, FILE_XFER_CHUNKSZ));
+        if (fileResult.resultCode != RESULT_CODE_SUCCESS)
+            break;
+        if (s_xferSz == fileResult.size)                                // no data, file truncated during download
+        {
+            fileResult.resultCode = RESULT_CODE_ERROR;
+            break;
+        }
+
+        fileResult.size = s_xferSz;
+        fileResult.checksum = s_xferChecksum;
+        if (progress_func != NULL)
+            progress_func(fileResult.size, fileSz);
+    }
+    s_xferRecvr_func = NULL;
+
+    filsys_close(openResult.fileHandle);
+    return fileResult;
+}
 
 
 fileOpenResult_t filsys_open(const char* fileName, fileOpenMode_t openMode, fileReceiver_func_t fileRecvr_func)
@@ -138,9 +389,8 @@ fileOpenResult_t filsys_open(const char* fileName, fileOpenMode_t openMode, file
         return fileResult;
     }
 
-    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFOPEN=%s,%d", fileName, openMode);
+    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFOPEN=\"%s\",%d", fileName, openMode);
 
-    // first get file system info
     if (atcmd_tryInvokeAdv(fileCmd, FILE_TIMEOUTml, NULL))
     {
         atcmdResult_t atResult = atcmd_awaitResult(false);
@@ -152,25 +402,133 @@ fileOpenResult_t filsys_open(const char* fileName, fileOpenMode_t openMode, file
         }
         // parse response
         // +QFOPEN: <filehandle>
-        continueAt = atResult.response + FILE_INFO_DATAOFFSET;      // skip past +QFLDS: 
-        fileResult.fileHandle = strtol(continueAt, &continueAt, 10);  
+        continueAt = strstr(atResult.response, "+QFOPEN: ");
+        if (continueAt != NULL)
+        {
+            fileResult.fileHandle = strtol(continueAt + FILE_OPEN_DATAOFFSET, &continueAt, 10);
+            fileResult.resultCode = RESULT_CODE_SUCCESS;
+            if (fileRecvr_func != NULL)
+                s_setRecvrFunc(fileResult.fileHandle, fileRecvr_func);
+        }
+        else
+            fileResult.resultCode = RESULT_CODE_ERROR;
         atcmd_close();
     }
     else
-    {
         fileResult.resultCode = RESULT_CODE_CONFLICT;
-        return fileResult;
-    }
+
+    return fileResult;
 }
 
 
+/**
+ *	\brief Read from a file, data is delivered to the file receiver function (set with filsys_open or filsys_setRecvrFunc).
+ *
+ *  Data is requested from BGx in chunks of up to FILE_READ_CHUNKSZ, received by IOP into a data buffer (file data peer) and 
+ *  delivered to the receiver in place (no copy). The receiver is invoked once for each chunk, data is valid only for the duration
+ *  of the receiver call. A short (or 0 length) chunk indicates the end-of-file was reached.
+ * 
+ *	\param [in] fileHandle - Numeric handle for the file to read from.
+ *	\param [in] readSz - Number of bytes to read.
+ * 
+ *  \return ResultCode=200 if successful, otherwise error code (HTTP status type).
+ */
 resultCode_t filsys_read(uint16_t fileHandle, uint16_t readSz)
 {
+    char fileCmd[FILE_CMD_SZ] = {0};
+    char *continueAt;
+    iopBuffer_t *dataBuf;
+    uint16_t remainingSz = readSz;
+    fileReceiver_func_t fileRecvr_func = s_getRecvrFunc(fileHandle);
+
+    while (remainingSz > 0)
+    {
+        uint16_t chunkSz = MIN(remainingSz, FILE_READ_CHUNKSZ);
+        snprintf(fileCmd, FILE_CMD_SZ, "AT+QFREAD=%d,%d", fileHandle, chunkSz);
+
+        if (!s_dataPeerInvoke(fileCmd))
+            return RESULT_CODE_CONFLICT;
+
+        resultCode_t rslt = s_dataPeerAwait(s_readCompleteParser, &dataBuf);
+        if (rslt != RESULT_CODE_SUCCESS)
+        {
+            s_dataPeerClose();
+            return rslt;
+        }
+        // parse response
+        // CONNECT <readSz>\r\n<data>\r\nOK\r\n
+        continueAt = strstr(dataBuf->buffer, "CONNECT ");
+        uint16_t dataSz = strtol(continueAt + 8, &continueAt, 10);
+        continueAt += 2;                                            // skip CRLF following the data size
+
+        if (fileRecvr_func != NULL)
+            fileRecvr_func(fileHandle, continueAt, dataSz);       // data remains in IOP data buffer, until peer closed
+        s_dataPeerClose();
+
+        if (dataSz < chunkSz)                                       // end-of-file
+            break;
+        remainingSz -= dataSz;
+    }
+    return RESULT_CODE_SUCCESS;
 }
 
 
+/**
+ *	\brief Write data to a file at the current file pointer position.
+ *
+ *	\param [in] fileHandle - Numeric handle for the file to write to.
+ *	\param [in] writeData - Pointer to the data to write, can be binary.
+ *	\param [in] writeSz - Number of bytes to write.
+ * 
+ *  \return Struct with the number of bytes written, the resulting file size and a resultCode=200 if successful.
+ */
 fileWriteResult_t filsys_write(uint16_t fileHandle, const char* writeData, uint16_t writeSz)
 {
+    fileWriteResult_t fileResult = { 0, 0, RESULT_CODE_SUCCESS };
+    char fileCmd[FILE_CMD_SZ] = {0};
+    char *continueAt;
+
+    while (fileResult.writtenSz < writeSz)
+    {
+        uint16_t chunkSz = MIN(writeSz - fileResult.writtenSz, FILE_WRITE_CHUNKSZ);
+        snprintf(fileCmd, FILE_CMD_SZ, "AT+QFWRITE=%d,%d", fileHandle, chunkSz);
+
+        if (!atcmd_tryInvokeAdv(fileCmd, FILE_TIMEOUTml, s_writePromptParser))
+        {
+            fileResult.resultCode = RESULT_CODE_CONFLICT;
+            return fileResult;
+        }
+
+        atcmdResult_t atResult = atcmd_awaitResult(false);         // wait for CONNECT prompt, leave action open to send data
+        if (atResult.statusCode == RESULT_CODE_SUCCESS)
+        {
+            atcmd_sendRaw(writeData + fileResult.writtenSz, chunkSz, FILE_TIMEOUTml, s_writeCompleteParser);
+            atResult = atcmd_awaitResult(false);
+        }
+        if (atResult.statusCode != RESULT_CODE_SUCCESS)
+        {
+            fileResult.resultCode = atResult.statusCode;
+            atcmd_close();
+            return fileResult;
+        }
+        // parse response
+        // +QFWRITE: <written_length>,<total_length>
+        continueAt = strstr(atResult.response, "+QFWRITE: ");
+        if (continueAt != NULL)
+        {
+            uint16_t chunkWritten = strtol(continueAt + 10, &continueAt, 10);
+            fileResult.writtenSz += chunkWritten;
+            fileResult.fileSz = strtol(++continueAt, &continueAt, 10);
+            if (chunkWritten == 0)                                  // no progress (ex: UFS full), don't retry forever
+                fileResult.resultCode = RESULT_CODE_ERROR;
+        }
+        else                                                        // no write result, chunk not confirmed
+            fileResult.resultCode = RESULT_CODE_ERROR;
+        atcmd_close();
+        if (fileResult.resultCode != RESULT_CODE_SUCCESS)
+            return fileResult;
+    }
+    return fileResult;
 }
 
 
@@ -187,7 +545,7 @@ resultCode_t filsys_seek(uint16_t fileHandle, uint32_t offset, fileSeekMode_t se
 {
     char fileCmd[FILE_CMD_SZ] = {0};
 
-    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFSEEK=%d,%d,%d", fileHandle, offset, seekFrom);
+    snprintf(fileCmd, FILE_CMD_SZ, "AT+QFSEEK=%d,%lu,%d", fileHandle, (unsigned long)offset, seekFrom);
 
     if (atcmd_tryInvokeAdv(fileCmd, FILE_TIMEOUTml, NULL))
     {
@@ -214,15 +572,20 @@ filePositionResult_t filsys_getPosition(uint16_t fileHandle)
             return fileResult;
         }
         // parse response
-        continueAt = atResult.response + FILE_POS_DATAOFFSET;           // skip past +QFPOSITION: 
-        fileResult.fileOffset = strtol(continueAt, &continueAt, 10);  
+        continueAt = strstr(atResult.response, "+QFPOSITION: ");
+        if (continueAt != NULL)
+        {
+            fileResult.fileOffset = strtol(continueAt + FILE_POS_DATAOFFSET, &continueAt, 10);
+            fileResult.resultCode = RESULT_CODE_SUCCESS;
+        }
+        else
+            fileResult.resultCode = RESULT_CODE_ERROR;
         atcmd_close();
     }
     else
-    {
         fileResult.resultCode = RESULT_CODE_CONFLICT;
-        return fileResult;
-    }
+
+    return fileResult;
 }
 
 
@@ -259,6 +622,7 @@ resultCode_t filsys_close(uint16_t fileHandle)
     char fileCmd[FILE_CMD_SZ] = {0};
 
     snprintf(fileCmd, FILE_CMD_SZ, "AT+QFCLOSE=%d", fileHandle);
+    s_setRecvrFunc(fileHandle, NULL);
 
     if (atcmd_tryInvokeAdv(fileCmd, FILE_TIMEOUTml, NULL))
     {
@@ -267,3 +631,292 @@ resultCode_t filsys_close(uint16_t fileHandle)
     return RESULT_CODE_CONFLICT;
 }
 
+
+
+/**
+ *	\brief Compute (continue) the BGx UFS checksum: 16-bit XOR of the file 2 bytes at a time, first byte high.
+ *
+ *	\param [in] checksum - Checksum of content preceding offset, 0 at start of file.
+ *	\param [in] offset - File offset of data, determines byte pairing.
+ *	\param [in] data - File content.
+ *	\param [in] dataSz - Size of data.
+ * 
+ *  \return Checksum of file content through offset + dataSz.
+ */
+uint16_t filsys__checksum(uint16_t checksum, uint32_t offset, const char *data, uint16_t dataSz)
+{
+    for (size_t i = 0; i < dataSz; i++)
+    {
+        checksum ^= ((offset + i) & 0x01) ? (uint8_t)data[i] : (uint8_t)data[i] << 8;
+    }
+    return checksum;
+}
+
+
+
+/* private (static) functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+/**
+ *	\brief [private] Get the receiver function for a file handle, the default receiver if none registered at open.
+ */
+static fileReceiver_func_t s_getRecvrFunc(uint16_t fileHandle)
+{
+    for (size_t i = 0; i < FILE_RECVR_MAXCNT; i++)
+    {
+        if (s_fileRecvrs[i].fileRecvr_func != NULL && s_fileRecvrs[i].fileHandle == fileHandle)
+            return s_fileRecvrs[i].fileRecvr_func;
+    }
+    return s_fileRecvr_func;
+}
+
+
+/**
+ *	\brief [private] Register (or with NULL release) a receiver function for a file handle.
+ */
+static void s_setRecvrFunc(uint16_t fileHandle, fileReceiver_func_t fileRecvr_func)
+{
+    for (size_t i = 0; i < FILE_RECVR_MAXCNT; i++)                     // release any existing entry for handle
+    {
+        if (s_fileRecvrs[i].fileRecvr_func != NULL && s_fileRecvrs[i].fileHandle == fileHandle)
+            s_fileRecvrs[i].fileRecvr_func = NULL;
+    }
+    if (fileRecvr_func == NULL)
+        return;
+
+    for (size_t i = 0; i < FILE_RECVR_MAXCNT; i++)
+    {
+        if (s_fileRecvrs[i].fileRecvr_func == NULL)
+        {
+            s_fileRecvrs[i].fileHandle = fileHandle;
+            s_fileRecvrs[i].fileRecvr_func = fileRecvr_func;
+            return;
+        }
+    }
+    s_fileRecvr_func = fileRecvr_func;                                  // table full, fallback to default receiver
+}
+
+
+/**
+ *	\brief [private] Invoke a file command with response routed to an IOP data buffer (file data peer), holds the action lock.
+ */
+static bool s_dataPeerInvoke(const char *fileCmd)
+{
+    if (!atcmd_tryInvokeStart(fileCmd, FILE_TIMEOUTml, NULL))
+        return false;
+
+    g_ltem->iop->rxDataPeer = iopDataPeer_FILE;                         // set before command is sent, response follows immediately
+    atcmd_invokeSend();
+    return true;
+}
+
+
+/**
+ *	\brief [private] Wait for the file data peer response to complete.
+ *
+ *  \param dataParser [in] Parser to test the data buffer for a complete response.
+ *  \param dataBuf [out] The IOP data buffer holding the response.
+ * 
+ *  \return HTTP style result code, 408 if response not complete within FILE_TIMEOUTml.
+ */
+static resultCode_t s_dataPeerAwait(fileDataParser_func_t dataParser, iopBuffer_t **dataBuf)
+{
+    uint32_t waitStart = lMillis();
+    resultCode_t rslt = RESULT_CODE_PENDING;
+
+    while (rslt == RESULT_CODE_PENDING)
+    {
+        uint8_t bufIndx = g_ltem->iop->rxDataBufIndx;
+        if (bufIndx != IOP_NO_BUFFER)
+        {
+            *dataBuf = g_ltem->iop->rxDataBufs[bufIndx];
+            rslt = dataParser(*dataBuf);
+        }
+        if (rslt == RESULT_CODE_PENDING)
+        {
+            if (lTimerExpired(waitStart, FILE_TIMEOUTml))
+                return RESULT_CODE_TIMEOUT;
+            lYield();
+        }
+    }
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Release the file data peer: IOP data buffer, return IOP to command mode and close action.
+ */
+static void s_dataPeerClose()
+{
+    iop_t *iopPtr = (iop_t *)g_ltem->iop;
+
+    iopPtr->rxDataPeer = iopDataPeer__NONE;
+    if (iopPtr->rxDataBufIndx != IOP_NO_BUFFER)
+    {
+        iop_resetDataBuffer(iopPtr->rxDataBufIndx);
+        iopPtr->rxDataBufIndx = IOP_NO_BUFFER;
+    }
+    atcmd_close();
+}
+
+
+/**
+ *	\brief [private] Test response for BGx error: +CME ERROR: <err> or ERROR.
+ */
+static resultCode_t s_errorParser(const char *response)
+{
+    char *cmeAt = strstr(response, "+CME ERROR: ");
+    if (cmeAt != NULL && strstr(cmeAt, ASCII_sCRLF) != NULL)
+        return strtol(cmeAt + 12, NULL, 10);
+    if (strstr(response, "ERROR\r\n") != NULL)
+        return RESULT_CODE_ERROR;
+    return RESULT_CODE_PENDING;
+}
+
+
+/**
+ *	\brief [private] File read response parser. Read data may be binary, so the data length is taken from the CONNECT header.
+ *
+ *  \param dataBuf [in] IOP data buffer receiving the response.
+ * 
+ *  \return HTTP style result code, RESULT_CODE_PENDING = not complete
+ */
+static resultCode_t s_readCompleteParser(iopBuffer_t *dataBuf)
+{
+    // CONNECT <readSz>\r\n<data>\r\nOK\r\n
+    char *connectAt = strstr(dataBuf->buffer, "CONNECT ");
+    if (connectAt == NULL)
+        return s_errorParser(dataBuf->buffer);
+
+    char *dataAt;
+    uint16_t dataSz = strtol(connectAt + 8, &dataAt, 10);
+    if (dataAt[0] != ASCII_cCR)                                         // data size not fully received yet
+        return RESULT_CODE_PENDING;
+    dataAt += 2;
+
+    if (dataBuf->head - (dataAt + dataSz) < 6)                          // wait for data plus "\r\nOK\r\n"
+        return RESULT_CODE_PENDING;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief [private] File list response parser, list is complete with OK.
+ */
+static resultCode_t s_listCompleteParser(iopBuffer_t *dataBuf)
+{
+    if (strstr(dataBuf->buffer, "OK\r\n") != NULL)
+        return RESULT_CODE_SUCCESS;
+    return s_errorParser(dataBuf->buffer);
+}
+
+
+/**
+ *	\brief [private] File write CONNECT prompt parser, BGx is ready to receive the write data.
+ */
+static resultCode_t s_writePromptParser(const char *response, char **endptr)
+{
+    char *connectAt = strstr(response, "CONNECT\r\n");
+    if (connectAt != NULL)
+    {
+        *endptr = connectAt + 9;
+        return RESULT_CODE_SUCCESS;
+    }
+    char *cmeAt = strstr(response, "+CME ERROR:");
+    if (cmeAt != NULL)
+        return strtol(cmeAt + 11, endptr, 10);
+    return RESULT_CODE_PENDING;
+}
+
+
+/**
+ *	\brief [private] Resume an interrupted upload: append remaining content with AT+QFWRITE.
+ */
+static resultCode_t s_uploadResume(const char* fileName, uint32_t fileSz, fileUploadResult_t *fileResult, fileSource_func_t source_func, fileProgress_func_t progress_func)
+{
+    char chunkBuf[FILE_XFER_CHUNKSZ];
+
+    fileOpenResult_t openResult = filsys_open(fileName, fileOpenMode_normalRdWr, NULL);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    resultCode_t rslt = filsys_seek(openResult.fileHandle, fileResult->size, fileSeekMode_seekFromBegin);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = filsys_truncate(openResult.fileHandle);                  // discard any unacknowledged content
+
+    while (rslt == RESULT_CODE_SUCCESS && fileResult->size < fileSz)
+    {
+        uint16_t chunkSz = source_func(fileResult->size, chunkBuf, MIN(fileSz - fileResult->size, FILE_XFER_CHUNKSZ));
+        if (chunkSz == 0)
+        {
+            rslt = RESULT_CODE_BADREQUEST;                              // source ended early
+            break;
+        }
+        fileWriteResult_t writeResult = filsys_write(openResult.fileHandle, chunkBuf, chunkSz);
+        rslt = writeResult.resultCode;
+        if (rslt == RESULT_CODE_SUCCESS)
+        {
+            fileResult->checksum = filsys__checksum(fileResult->checksum, fileResult->size, chunkBuf, writeResult.writtenSz);
+            fileResult->size += writeResult.writtenSz;
+            if (progress_func != NULL)
+                progress_func(fileResult->size, fileSz);
+        }
+    }
+    filsys_close(openResult.fileHandle);
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Download receiver, continues checksum and forwards data to the application receiver.
+ */
+static void s_downloadRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz)
+{
+    s_xferChecksum = filsys__checksum(s_xferChecksum, s_xferSz, fileData, dataSz);
+    s_xferSz += dataSz;
+    if (s_xferRecvr_func != NULL)
+        s_xferRecvr_func(fileHandle, fileData, dataSz);
+}
+
+
+/**
+ *	\brief [private] Upload chunk acknowledgement parser, BGx sends "A" after each 1K received.
+ */
+static resultCode_t s_uploadAckParser(const char *response, char **endptr)
+{
+    char *ackAt = strchr(response, 'A');
+    if (ackAt != NULL)
+    {
+        *endptr = ackAt + 1;
+        return RESULT_CODE_SUCCESS;
+    }
+    char *cmeAt = strstr(response, "+CME ERROR:");
+    if (cmeAt != NULL)
+        return strtol(cmeAt + 11, endptr, 10);
+    return RESULT_CODE_PENDING;
+}
+
+
+/**
+ *	\brief [private] Upload complete parser, final chunk is followed by +QFUPL: <upload_size>,<checksum> (not acknowledged).
+ */
+static resultCode_t s_uploadCompleteParser(const char *response, char **endptr)
+{
+    char *cmeAt = strstr(response, "+CME ERROR:");
+    if (cmeAt != NULL)
+        return strtol(cmeAt + 11, endptr, 10);
+    return atcmd_defaultResultParser(response, "+QFUPL: ", true, 2, ASCII_sOK, endptr);
+}
+
+
+/**
+ *	\brief [private] File write complete parser.
+ */
+static resultCode_t s_writeCompleteParser(const char *response, char **endptr)
+{
+    return atcmd_defaultResultParser(response, "+QFWRITE: ", true, 2, ASCII_sOK, endptr);
+}
+
+
+#pragma endregion
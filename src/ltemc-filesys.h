@@ -48,9 +48,13 @@ typedef struct fileInfoResult_tag
 } fileInfoResult_t;
 
 
+#define FILE_LIST_MAXCNT 10                 ///< Max files returned by filsys_list()
+#define FILE_LIST_NAMESZ 41                 ///< Filename size in list results, longer names are truncated
+
+
 typedef struct fileListItem_tag
 {
-    const char* filename;
+    char filename[FILE_LIST_NAMESZ];
     uint32_t fileSize;
 } fileListItem_t;
 
@@ -58,21 +62,32 @@ typedef struct fileListItem_tag
 typedef struct fileListResult_tag
 {
     const char* namePattern;
-    fileListItem_t fileList[10];
+    fileListItem_t fileList[FILE_LIST_MAXCNT];
+    uint8_t fileCnt;
     resultCode_t resultCode;
 } fileListResult_t;
 
+#define FILE_XFER_CHUNKSZ 1024             ///< Upload\download chunk, BGx acknowledges each 1K of upload data
+
+
+/** 
+ *  \brief Upload\download result. On interruption size and checksum reflect the data transferred, pass the result to resume.
+ * 
+ *  Checksum is the BGx UFS checksum: 16-bit XOR of the file taken 2 bytes at a time (first byte high), odd length padded with 0.
+*/
 typedef struct fileUploadResult_tag
 {
-    uint32_t size;
-    uint16_t checksum;
+    uint32_t size;                          ///< Bytes transferred (in file), includes any resumed portion
+    uint16_t checksum;                      ///< Checksum of size bytes
+    resultCode_t resultCode;
 } fileUploadResult_t;
 
 
 typedef struct fileDownloadResult_tag
 {
-    uint32_t size;
-    uint16_t checksum;
+    uint32_t size;                          ///< Bytes transferred, includes any resumed portion
+    uint16_t checksum;                      ///< Checksum of size bytes
+    resultCode_t resultCode;
 } fileDownloadResult_t;
 
 
@@ -109,7 +124,7 @@ typedef struct fileWriteResult_tag
 
 typedef struct filePositionResult_tag
 {
-    uint16_t fileOffset;
+    uint32_t fileOffset;
     resultCode_t resultCode;
 } filePositionResult_t;
 
@@ -118,6 +133,17 @@ typedef struct filePositionResult_tag
 */
 typedef void (*fileReceiver_func_t)(uint16_t fileHandle, void *fileData, uint16_t dataSz);
 
+/** 
+ *  \brief typedef for the upload data source function. Fills chunkBuf with file content starting at offset.
+ *  \return Number of bytes placed in chunkBuf, less than chunkSz only at end-of-file.
+*/
+typedef uint16_t (*fileSource_func_t)(uint32_t offset, char *chunkBuf, uint16_t chunkSz);
+
+/** 
+ *  \brief typedef for the upload\download progress function, invoked after each chunk.
+*/
+typedef void (*fileProgress_func_t)(uint32_t xferSz, uint32_t fileSz);
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -127,8 +153,8 @@ extern "C" {
 // set file read data receiver function (here or with filsys_open). Not required if file is write only access.
 void filsys_setRecvrFunc(fileReceiver_func_t fileRecvr_func);
 
-fileInfoResult_t filesys_info();
-fileListResult_t filsys_list(const char* fileName);
+fileInfoResult_t filsys_info();
+fileListResult_t filsys_list(const char* namePattern);
 resultCode_t filsys_delete(const char* fileName);
 fileOpenResult_t filsys_open(const char* fileName, fileOpenMode_t mode, fileReceiver_func_t fileRecvr_func);
 resultCode_t filsys_read(uint16_t fileHandle, uint16_t readSz);
@@ -138,9 +164,11 @@ filePositionResult_t filsys_getPosition(uint16_t fileHandle);
 resultCode_t filsys_truncate(uint16_t fileHandle);
 resultCode_t filsys_close(uint16_t fileHandle);
 
-/* future */
-// fileUploadResult_t filsys_upload(const char* fileName);
-// fileDownloadResult_t filsys_download(const char* fileName);
+fileUploadResult_t filsys_upload(const char* fileName, uint32_t fileSz, const fileUploadResult_t *resumeFrom, fileSource_func_t source_func, fileProgress_func_t progress_func);
+fileDownloadResult_t filsys_download(const char* fileName, const fileDownloadResult_t *resumeFrom, fileReceiver_func_t fileRecvr_func, fileProgress_func_t progress_func);
+
+// semi-private functions, not intended for most application but not static for special needs
+uint16_t filsys__checksum(uint16_t checksum, uint32_t offset, const char *data, uint16_t dataSz);
 
 
 #ifdef __cplusplus
@@ -31,8 +31,17 @@
 #include "ltemc.h"
 #include "ltemc-geo.h"
 
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+
+#define GEO_NOTIFMSG_SZ 20
+
+static geoFenceTable_t *fenceTblPtr = NULL;
+
 // private local declarations
 static resultCode_t geoQueryResponseParser(const char *response);
+static void s_fenceEvaluate(geoFence_t *fence, geoPoint_t point);
+static void s_fenceLocation(geoPoint_t point);
 
 
 /* public functions
@@ -127,6 +136,256 @@ geo_position_t geo_query(uint8_t geoId)
 
 
 
+
+/* Host (MCU) geo-fence engine: any number of polygon fences (within the table sizes), evaluated on each GNSS fix
+ * --------------------------------------------------------------------------------------------- */
+
+/**
+ *	\brief Create the host geo-fence table. Fences are evaluated in background (ltem_doWork), enter/exit are signaled with 
+ *  ltemNotifType_geofenceEnter\ltemNotifType_geofenceExit.
+ *
+ *  \param fenceMax [in] - Max number of fences.
+ *  \param vertexMax [in] - Max total vertices, all fences.
+ */
+void geo_fenceCreate(uint16_t fenceMax, uint16_t vertexMax)
+{
+    if (fenceTblPtr != NULL)                                        // replacing existing table
+    {
+        g_ltem->geoWork_func = NULL;
+        free(fenceTblPtr->fences);
+        free(fenceTblPtr->vertices);
+        free(fenceTblPtr);
+    }
+
+    fenceTblPtr = calloc(1, sizeof(geoFenceTable_t));
+    if (fenceTblPtr == NULL)
+    {
+        ltem_notifyApp(ltemNotifType_memoryAllocFault, "geo-could not alloc fence table");
+        return;
+    }
+    fenceTblPtr->fences = calloc(fenceMax, sizeof(geoFence_t));
+    fenceTblPtr->vertices = calloc(vertexMax, sizeof(geoPoint_t));
+    if (fenceTblPtr->fences == NULL || fenceTblPtr->vertices == NULL)
+    {
+        free(fenceTblPtr->fences);
+        free(fenceTblPtr->vertices);
+        free(fenceTblPtr);
+        fenceTblPtr = NULL;
+        ltem_notifyApp(ltemNotifType_memoryAllocFault, "geo-could not alloc fence table");
+        return;
+    }
+    fenceTblPtr->fenceMax = fenceMax;
+    fenceTblPtr->vertexMax = vertexMax;
+    g_ltem->geoWork_func = &geo_fenceDoWork;
+}
+
+
+
+/**
+ *	\brief Add a polygon fence. The polygon is closed (last vertex connects to first), edges must not cross.
+ *
+ *  \param fenceId [in] - Application ID for the fence.
+ *  \param vertices [in] - Polygon vertices (copied), fixed-point degrees.
+ *  \param vertexCnt [in] - Number of vertices, 3 or more.
+ * 
+ *  A fence added between evaluation passes is first evaluated with the next location received.
+ * 
+ *  \return 200 if added, 400 if polygon invalid, 409 if fenceId exists, 412 if no fence table (geo_fenceCreate), 503 if fence 
+ *  table or vertex pool is full.
+ */
+resultCode_t geo_fenceAdd(uint16_t fenceId, const geoPoint_t *vertices, uint8_t vertexCnt)
+{
+    if (fenceTblPtr == NULL)
+        return RESULT_CODE_PRECONDFAILED;
+    if (vertexCnt < 3)
+        return RESULT_CODE_BADREQUEST;
+    for (size_t i = 0; i < fenceTblPtr->fenceCnt; i++)
+    {
+        if (fenceTblPtr->fences[i].fenceId == fenceId)
+            return RESULT_CODE_CONFLICT;
+    }
+    if (fenceTblPtr->fenceCnt == fenceTblPtr->fenceMax || fenceTblPtr->vertexCnt + vertexCnt > fenceTblPtr->vertexMax)
+        return RESULT_CODE_UNAVAILABLE;
+
+    geoFence_t *fence = &fenceTblPtr->fences[fenceTblPtr->fenceCnt];
+    fence->fenceId = fenceId;
+    fence->vertexIndx = fenceTblPtr->vertexCnt;
+    fence->vertexCnt = vertexCnt;
+    fence->position = geo_position_unknown;
+    fence->pendingCnt = 0;
+    fence->boxMin = vertices[0];
+    fence->boxMax = vertices[0];
+
+    memcpy(&fenceTblPtr->vertices[fence->vertexIndx], vertices, vertexCnt * sizeof(geoPoint_t));
+    for (size_t i = 1; i < vertexCnt; i++)
+    {
+        fence->boxMin.lat = MIN(fence->boxMin.lat, vertices[i].lat);
+        fence->boxMin.lon = MIN(fence->boxMin.lon, vertices[i].lon);
+        fence->boxMax.lat = MAX(fence->boxMax.lat, vertices[i].lat);
+        fence->boxMax.lon = MAX(fence->boxMax.lon, vertices[i].lon);
+    }
+    bool passComplete = fenceTblPtr->evalIndx == fenceTblPtr->fenceCnt;
+    fenceTblPtr->vertexCnt += vertexCnt;
+    fenceTblPtr->fenceCnt++;
+    if (passComplete)                                               // evalPoint may be stale, wait for next location
+        fenceTblPtr->evalIndx = fenceTblPtr->fenceCnt;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+
+/**
+ *	\brief Remove a fence, the vertex pool is compacted.
+ *
+ *  \return 200 if removed, 404 if fenceId not found, 412 if no fence table (geo_fenceCreate).
+ */
+resultCode_t geo_fenceRemove(uint16_t fenceId)
+{
+    if (fenceTblPtr == NULL)
+        return RESULT_CODE_PRECONDFAILED;
+
+    for (size_t i = 0; i < fenceTblPtr->fenceCnt; i++)
+    {
+        if (fenceTblPtr->fences[i].fenceId != fenceId)
+            continue;
+
+        uint16_t vertexIndx = fenceTblPtr->fences[i].vertexIndx;
+        uint8_t vertexCnt = fenceTblPtr->fences[i].vertexCnt;
+
+        memmove(&fenceTblPtr->vertices[vertexIndx], &fenceTblPtr->vertices[vertexIndx + vertexCnt], 
+                (fenceTblPtr->vertexCnt - vertexIndx - vertexCnt) * sizeof(geoPoint_t));
+        fenceTblPtr->vertexCnt -= vertexCnt;
+
+        memmove(&fenceTblPtr->fences[i], &fenceTblPtr->fences[i + 1], (fenceTblPtr->fenceCnt - i - 1) * sizeof(geoFence_t));
+        fenceTblPtr->fenceCnt--;
+
+        for (size_t j = 0; j < fenceTblPtr->fenceCnt; j++)
+        {
+            if (fenceTblPtr->fences[j].vertexIndx > vertexIndx)
+                fenceTblPtr->fences[j].vertexIndx -= vertexCnt;
+        }
+        if (fenceTblPtr->evalIndx > i)
+            fenceTblPtr->evalIndx--;
+        return RESULT_CODE_SUCCESS;
+    }
+    return RESULT_CODE_NOTFOUND;
+}
+
+
+
+/**
+ *	\brief Remove all fences.
+ */
+void geo_fenceClear()
+{
+    if (fenceTblPtr == NULL)
+        return;
+
+    fenceTblPtr->fenceCnt = 0;
+    fenceTblPtr->vertexCnt = 0;
+    fenceTblPtr->evalIndx = 0;
+    fenceTblPtr->nextPending = false;
+}
+
+
+
+/**
+ *	\brief Supply a GNSS fix for evaluation. Not required while GNSS is streaming, streamed fixes are taken automatically.
+ */
+void geo_fenceUpdate(const gnssLocation_t *location)
+{
+    if (fenceTblPtr == NULL || location->statusCode != RESULT_CODE_SUCCESS)
+        return;
+
+    geoPoint_t point = { location->lat.val, location->lon.val };
+    s_fenceLocation(point);
+}
+
+
+
+/**
+ *	\brief Get a fence's current (signaled) position.
+ *
+ *  \return Inside or outside, unknown if not yet evaluated or fenceId not found.
+ */
+geo_position_t geo_fenceGetPosition(uint16_t fenceId)
+{
+    if (fenceTblPtr == NULL)
+        return geo_position_unknown;
+
+    for (size_t i = 0; i < fenceTblPtr->fenceCnt; i++)
+    {
+        if (fenceTblPtr->fences[i].fenceId == fenceId)
+            return (geo_position_t)fenceTblPtr->fences[i].position;
+    }
+    return geo_position_unknown;
+}
+
+
+
+/**
+ *	\brief Background work, evaluates up to GEO_FENCE_EVALBATCH fences against the current fix. Invoked by ltem_doWork().
+ * 
+ *  Nothing is evaluated until the first location is received.
+ */
+void geo_fenceDoWork()
+{
+    if (fenceTblPtr == NULL)
+        return;
+
+    if (gnss_isStreaming())
+    {
+        gnssLocation_t location = gnss_getLocation();
+        if (location.statusCode == RESULT_CODE_SUCCESS && strcmp(location.utc, fenceTblPtr->lastUtc) != 0)
+        {
+            strcpy(fenceTblPtr->lastUtc, location.utc);
+            geo_fenceUpdate(&location);
+        }
+    }
+
+    if (!fenceTblPtr->evalValid)
+        return;
+
+    uint16_t batchEnd = MIN(fenceTblPtr->evalIndx + GEO_FENCE_EVALBATCH, fenceTblPtr->fenceCnt);
+    for (; fenceTblPtr->evalIndx < batchEnd; fenceTblPtr->evalIndx++)
+    {
+        s_fenceEvaluate(&fenceTblPtr->fences[fenceTblPtr->evalIndx], fenceTblPtr->evalPoint);
+    }
+
+    if (fenceTblPtr->evalIndx == fenceTblPtr->fenceCnt && fenceTblPtr->nextPending)     // pass complete, start next fix
+    {
+        fenceTblPtr->nextPending = false;
+        fenceTblPtr->evalPoint = fenceTblPtr->nextPoint;
+        fenceTblPtr->evalIndx = 0;
+    }
+}
+
+
+
+/**
+ *	\brief Point in polygon test (ray casting), fixed-point. Polygons must span less than 90 degrees (64-bit intermediates).
+ */
+bool geo__pointInPolygon(geoPoint_t point, const geoPoint_t *vertices, uint8_t vertexCnt)
+{
+    bool inside = false;
+
+    for (uint8_t i = 0, j = vertexCnt - 1; i < vertexCnt; j = i++)
+    {
+        int64_t latI = vertices[i].lat;
+        int64_t latJ = vertices[j].lat;
+        if ((latI > point.lat) == (latJ > point.lat))                   // edge does not cross point's latitude
+            continue;
+
+        // crossing east of point: point.lon < lonI + (lonJ - lonI) * (point.lat - latI) / (latJ - latI), without the division
+        int64_t lhs = ((int64_t)point.lon - vertices[i].lon) * (latJ - latI);
+        int64_t rhs = ((int64_t)vertices[j].lon - vertices[i].lon) * ((int64_t)point.lat - latI);
+        if (latJ > latI ? lhs < rhs : lhs > rhs)
+            inside = !inside;
+    }
+    return inside;
+}
+
+
 #pragma endregion
 
 /* private (static) functions
@@ -142,4 +401,51 @@ static resultCode_t geoQueryResponseParser(const char *response)
 }
 
 
+
+/**
+ *	\brief Queue a location for evaluation, starts a pass if none in progress.
+ */
+static void s_fenceLocation(geoPoint_t point)
+{
+    if (fenceTblPtr->evalIndx < fenceTblPtr->fenceCnt)             // pass in progress, latest fix evaluated next
+    {
+        fenceTblPtr->nextPoint = point;
+        fenceTblPtr->nextPending = true;
+        return;
+    }
+    fenceTblPtr->evalPoint = point;
+    fenceTblPtr->evalValid = true;
+    fenceTblPtr->evalIndx = 0;
+}
+
+
+/**
+ *	\brief Evaluate a fence (bounding box prefilter, then polygon), with hysteresis before signaling a position change.
+ */
+static void s_fenceEvaluate(geoFence_t *fence, geoPoint_t point)
+{
+    bool inside = point.lat >= fence->boxMin.lat && point.lat <= fence->boxMax.lat &&
+                  point.lon >= fence->boxMin.lon && point.lon <= fence->boxMax.lon &&
+                  geo__pointInPolygon(point, &fenceTblPtr->vertices[fence->vertexIndx], fence->vertexCnt);
+    geo_position_t position = inside ? geo_position_inside : geo_position_outside;
+
+    if (position == fence->position)
+    {
+        fence->pendingCnt = 0;
+        return;
+    }
+    if (fence->position != geo_position_unknown && ++fence->pendingCnt < GEO_FENCE_HYSTERESIS)
+        return;
+
+    bool signal = fence->position != geo_position_unknown || position == geo_position_inside;       // initial outside is not an event
+    fence->position = position;
+    fence->pendingCnt = 0;
+    if (signal)
+    {
+        static char notifMsg[GEO_NOTIFMSG_SZ];
+        snprintf(notifMsg, GEO_NOTIFMSG_SZ, "fence=%u %s", fence->fenceId, inside ? "enter" : "exit");
+        ltem_notifyApp(inside ? ltemNotifType_geofenceEnter : ltemNotifType_geofenceExit, notifMsg);
+    }
+}
+
 #pragma endregion
@@ -29,6 +29,7 @@
 #define __LTEMC_GEO_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /** 
  *  \brief Enum indicating the device's relationship to a geo-fence.
@@ -73,6 +74,55 @@ typedef enum
 } geo_shape_t;
 
 
+#define GEO_FENCE_HYSTERESIS 3              ///< consecutive fixes agreeing on a new position before enter/exit is signaled
+#define GEO_FENCE_EVALBATCH 16              ///< max fences evaluated per doWork, spreads evaluation of large fence tables over loop cycles
+
+
+/** 
+ *  \brief Fixed-point coordinate, degrees x 1e7 (GNSS_DEGREES_SCALE): same scale as gnssLocation_t lat/lon.
+*/
+typedef struct geoPoint_tag
+{
+    int32_t lat;
+    int32_t lon;
+} geoPoint_t;
+
+
+/** 
+ *  \brief Host (MCU) geo-fence, a polygon with vertices in the fence table vertex pool and a bounding box prefilter.
+*/
+typedef struct geoFence_tag
+{
+    uint16_t fenceId;                       ///< Application fence ID, reported in events
+    uint16_t vertexIndx;                    ///< First vertex in vertex pool
+    uint8_t vertexCnt;                      ///< Number of polygon vertices (3 to 255)
+    uint8_t position;                       ///< Current (signaled) geo_position_t
+    uint8_t pendingCnt;                     ///< Consecutive fixes contradicting position (hysteresis)
+    geoPoint_t boxMin;                      ///< Bounding box, south-west corner
+    geoPoint_t boxMax;                      ///< Bounding box, north-east corner
+} geoFence_t;
+
+
+/** 
+ *  \brief Host (MCU) geo-fence table and evaluation state.
+*/
+typedef struct geoFenceTable_tag
+{
+    geoFence_t *fences;                     ///< Fence table
+    geoPoint_t *vertices;                   ///< Vertex pool, fences reference contiguous vertex ranges
+    uint16_t fenceMax;
+    uint16_t fenceCnt;
+    uint16_t vertexMax;
+    uint16_t vertexCnt;
+    geoPoint_t evalPoint;                   ///< Location being evaluated
+    bool evalValid;                         ///< A location has been received, evalPoint is set
+    uint16_t evalIndx;                      ///< Next fence to evaluate against evalPoint, fenceCnt when evaluation pass is complete
+    geoPoint_t nextPoint;                   ///< Location received during an evaluation pass, evaluated next
+    bool nextPending;
+    char lastUtc[11];                       ///< UTC of last streamed GNSS location taken for evaluation
+} geoFenceTable_t;
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -83,6 +133,18 @@ resultCode_t geo_delete(uint8_t geoId);
 
 geo_position_t geo_query(uint8_t geoId);
 
+void geo_fenceCreate(uint16_t fenceMax, uint16_t vertexMax);
+resultCode_t geo_fenceAdd(uint16_t fenceId, const geoPoint_t *vertices, uint8_t vertexCnt);
+resultCode_t geo_fenceRemove(uint16_t fenceId);
+void geo_fenceClear();
+void geo_fenceUpdate(const gnssLocation_t *location);
+geo_position_t geo_fenceGetPosition(uint16_t fenceId);
+
+void geo_fenceDoWork();
+
+// semi-private functions, not intended for most application but not static for special needs
+bool geo__pointInPolygon(geoPoint_t point, const geoPoint_t *vertices, uint8_t vertexCnt);
+
 
 #ifdef __cplusplus
 }
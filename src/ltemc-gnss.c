@@ -42,16 +42,26 @@
 #include "ltemc.h"
 #include "ltemc-gnss.h"
 
-#define GNSS_CMD_RESULTBUF_SZ 90
-#define GNSS_LOC_DATAOFFSET 12
+#define GNSS_LOC_PREFIXSZ 10             // "+QGPSLOC: "
 #define GNSS_LOC_EXPECTED_TOKENCOUNT 11
 #define GNSS_TIMEOUTml 800
 
+#define GNSS_NMEA_FIELDMAX 20
+
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
 
+static gnssStream_t *streamPtr = NULL;
+
+
 // private local declarations
 static resultCode_t gnssLocCompleteParser(const char *response, char **endptr);
+static void s_restoreNmeaSrc();
+static bool s_nmeaChecksumValid(const char *sentence);
+static void s_nmeaParse(char *sentence);
+static int32_t s_nmeaToDegrees(const char *nmeaVal, const char *hemisphere);
+static int32_t s_parseFixed(const char *source, uint8_t decimals, const char **endptr);
+static const char *s_copyField(const char *source, char *field, uint8_t fieldSz);
 
 
 /*
@@ -97,20 +107,18 @@ resultCode_t gnss_off()
 
 
 /**
- *	\brief Query BGx for current location/positioning information. 
+ *	\brief Query BGx for current location/positioning information. If streaming, the latest streamed location is returned (no AT command).
  *
  *  \return GNSS location struct, see gnss.h for details.
  */
 gnssLocation_t gnss_getLocation()
 {
-    #define TOKEN_BUF_SZ 12
+    if (gnss_isStreaming())
+        return streamPtr->location;
 
-    char tokenBuf[TOKEN_BUF_SZ] = {0};
-    char *continueAt;
-    gnssLocation_t gnssResult;
+    gnssLocation_t gnssResult = {0};
+    gnssResult.statusCode = RESULT_CODE_CONFLICT;                   // command lock not available
 
-    //atcmd_t *gnssCmd = atcmd_build("AT+QGPSLOC=2", GNSS_CMD_RESULTBUF_SZ, 500, gnssLocCompleteParser);
-    
     // result sz=86 >> +QGPSLOC: 121003.0,44.74769,-85.56535,1.1,189.0,2,95.45,0.0,0.0,250420,08  + lineEnds and OK
 
     if (atcmd_tryInvokeAdv("AT+QGPSLOC=2", ACTION_TIMEOUTml, gnssLocCompleteParser))
@@ -118,38 +126,234 @@ gnssLocation_t gnss_getLocation()
         atcmdResult_t atResult = atcmd_awaitResult(false);
 
         gnssResult.statusCode = atResult.statusCode;
-        if (atResult.statusCode != RESULT_CODE_SUCCESS)
+        if (atResult.statusCode == RESULT_CODE_SUCCESS)
         {
-            atcmd_close();
-            return gnssResult;
+            const char *locationAt = strstr(atResult.response, "+QGPSLOC: ");
+            if (locationAt != NULL)
+                gnss__parseLocation(locationAt + GNSS_LOC_PREFIXSZ, &gnssResult);
         }
-
-        PRINTF(DBGCOLOR_warn, "getLocation(): parse starting...\r");
-
-        continueAt = atResult.response + GNSS_LOC_DATAOFFSET;                           // skip past +QGPSLOC: 
-        continueAt = atcmd_strToken(continueAt, ASCII_cCOMMA, tokenBuf, TOKEN_BUF_SZ);        // grab 1st element as a string
-        if (continueAt != NULL)
-            strncpy(gnssResult.utc, tokenBuf, 11);
-        gnssResult.lat.val = strtof(continueAt, &continueAt);                           // grab a float
-        gnssResult.lat.dir = ASCII_cSPACE;
-        gnssResult.lon.val = strtof(++continueAt, &continueAt);                         // ++continueAt, pre-incr to skip previous comma
-        gnssResult.lon.dir = ASCII_cSPACE;
-        gnssResult.hdop = strtof(++continueAt, &continueAt);
-        gnssResult.altitude = strtof(++continueAt, &continueAt);
-        gnssResult.fixType = strtol(++continueAt, &continueAt, 10);                     // grab an integer
-        gnssResult.course = strtof(++continueAt, &continueAt);
-        gnssResult.speedkm = strtof(++continueAt, &continueAt);
-        gnssResult.speedkn = strtof(++continueAt, &continueAt);
-        continueAt = atcmd_strToken(continueAt + 1, ASCII_cCOMMA, tokenBuf, TOKEN_BUF_SZ);
-        if (continueAt != NULL)
-            strncpy(gnssResult.date, tokenBuf, 7);
-        gnssResult.nsat = strtol(continueAt, &continueAt, 10);
         atcmd_close();
     }
-    PRINTF(DBGCOLOR_warn, "getLocation(): parse completed\r");
+    return gnssResult;
+}
 
 
-    return gnssResult;
+
+
+/**
+ *	\brief Convert a fixed-point degrees value (lat/lon) to float degrees, for compatibility. Prefer the fixed-point value.
+ */
+float gnss_toDegrees(int32_t fixedDegrees)
+{
+    return (float)fixedDegrees / GNSS_DEGREES_SCALE;
+}
+
+
+
+/**
+ *	\brief Convert a centi-unit value (hdop, altitude, course, speed) to float, for compatibility. Prefer the fixed-point value.
+ */
+float gnss_fromCenti(int32_t centiValue)
+{
+    return (float)centiValue / GNSS_CENTI_SCALE;
+}
+
+
+
+/**
+ *	\brief Parse +QGPSLOC (format=2) content into a location, single pass in fixed-point (no float, no locale, no allocation).
+ *
+ *  \param locInfo [in] - Content following "+QGPSLOC: " 
+ *  \param location [out] - Location, statusCode is not changed.
+ */
+void gnss__parseLocation(const char *locInfo, gnssLocation_t *location)
+{
+    // <UTC>,<latitude>,<longitude>,<hdop>,<altitude>,<fix>,<cog>,<spkm>,<spkn>,<date>,<nsat>
+    const char *nextAt = s_copyField(locInfo, location->utc, sizeof(location->utc));
+    location->lat.val = s_parseFixed(nextAt, GNSS_DEGREES_DECIMALS, &nextAt);
+    location->lat.dir = ASCII_cSPACE;
+    location->lon.val = s_parseFixed(nextAt, GNSS_DEGREES_DECIMALS, &nextAt);
+    location->lon.dir = ASCII_cSPACE;
+    location->hdop = s_parseFixed(nextAt, 2, &nextAt);
+    location->altitude = s_parseFixed(nextAt, 2, &nextAt);
+    location->fixType = s_parseFixed(nextAt, 0, &nextAt);
+    location->course = s_parseFixed(nextAt, 2, &nextAt);
+    location->speedkm = s_parseFixed(nextAt, 2, &nextAt);
+    location->speedkn = s_parseFixed(nextAt, 2, &nextAt);
+    nextAt = s_copyField(nextAt, location->date, sizeof(location->date));
+    location->nsat = s_parseFixed(nextAt, 0, &nextAt);
+}
+
+
+
+/**
+ *	\brief Start GNSS NMEA streaming, sentences output by BGx are parsed in background (ltem_doWork) into the latest location. 
+ *
+ *  Requires GNSS on (gnss_on). Sentences are output to the host UART (GNSS_NMEA_OUTPORT) and captured by IOP as they arrive.
+ *
+ *  \return Result code representing status of operation, OK = 200.
+ */
+resultCode_t gnss_streamStart()
+{
+    if (streamPtr == NULL)
+    {
+        streamPtr = calloc(1, sizeof(gnssStream_t));
+        uint8_t *ringBuf = calloc(1, GNSS_NMEA_RINGSZ);
+        if (streamPtr == NULL || ringBuf == NULL)
+        {
+            free(ringBuf);
+            free(streamPtr);
+            streamPtr = NULL;
+            ltem_notifyApp(ltemNotifType_memoryAllocFault, "gnss-could not alloc NMEA stream");
+            return RESULT_CODE_ERROR;
+        }
+        streamPtr->nmeaRing.buffer = ringBuf;
+        streamPtr->nmeaRing.maxlen = GNSS_NMEA_RINGSZ;
+    }
+    streamPtr->nmeaRing.head = 0;
+    streamPtr->nmeaRing.tail = 0;
+    streamPtr->capturing = false;
+    streamPtr->lineOpen = false;
+    streamPtr->sentenceSz = 0;
+    memset(&streamPtr->location, 0, sizeof(gnssLocation_t));
+    streamPtr->location.statusCode = GNSS_RESULT_NOFIX;
+
+    if (!atcmd_tryInvokeAdv("AT+QGPSCFG=\"nmeasrc\",1", GNSS_TIMEOUTml, NULL))
+        return RESULT_CODE_CONFLICT;
+    resultCode_t rslt = atcmd_awaitResult(true).statusCode;
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    g_ltem->iop->peerTypeMap.gnssNmea = 1;                          // IOP captures sentences from here on
+    g_ltem->gnssWork_func = &gnss_doWork;
+
+    rslt = RESULT_CODE_CONFLICT;
+    if (atcmd_tryInvokeAdv("AT+QGPSCFG=\"outport\",\"" GNSS_NMEA_OUTPORT "\"", GNSS_TIMEOUTml, NULL))
+        rslt = atcmd_awaitResult(true).statusCode;
+    if (rslt != RESULT_CODE_SUCCESS)                                // not streaming: roll back capture and NMEA source
+    {
+        g_ltem->iop->peerTypeMap.gnssNmea = 0;
+        g_ltem->gnssWork_func = NULL;
+        s_restoreNmeaSrc();
+    }
+    return rslt;
+}
+
+
+
+/**
+ *	\brief Stop GNSS NMEA streaming, gnss_getLocation() reverts to AT+QGPSLOC. NMEA output and source are restored to BGx defaults.
+ */
+void gnss_streamStop()
+{
+    if (atcmd_tryInvokeAdv("AT+QGPSCFG=\"outport\",\"none\"", GNSS_TIMEOUTml, NULL))
+        atcmd_awaitResult(true);
+
+    g_ltem->iop->peerTypeMap.gnssNmea = 0;
+    g_ltem->gnssWork_func = NULL;
+    s_restoreNmeaSrc();
+}
+
+
+
+/**
+ *	\brief Test for GNSS NMEA streaming active.
+ */
+bool gnss_isStreaming()
+{
+    return streamPtr != NULL && g_ltem->iop->peerTypeMap.gnssNmea;
+}
+
+
+
+/**
+ *	\brief Background work, parses NMEA sentences captured by IOP. Invoked by ltem_doWork() while streaming.
+ */
+void gnss_doWork()
+{
+    uint8_t nmeaChar;
+
+    while (cbuf_pop(&streamPtr->nmeaRing, &nmeaChar))
+    {
+        if (nmeaChar != ASCII_cLF)
+        {
+            if (streamPtr->sentenceSz < GNSS_NMEA_SENTENCESZ - 1)
+                streamPtr->sentence[streamPtr->sentenceSz] = nmeaChar;
+            streamPtr->sentenceSz++;                                    // count past buffer end, rejected as overflow at LF
+            continue;
+        }
+
+        if (streamPtr->sentenceSz < GNSS_NMEA_SENTENCESZ)
+        {
+            streamPtr->sentence[streamPtr->sentenceSz] = ASCII_cNULL;
+            if (s_nmeaChecksumValid(streamPtr->sentence))
+            {
+                s_nmeaParse(streamPtr->sentence);
+                streamPtr->sentenceCnt++;
+            }
+            else
+                streamPtr->rejectCnt++;
+        }
+        else
+            streamPtr->rejectCnt++;
+        streamPtr->sentenceSz = 0;
+    }
+}
+
+
+
+/**
+ *	\brief Capture NMEA sentences from an IOP command RX chunk into the NMEA ring. Invoked from IOP ISR.
+ *
+ *  Every line in the chunk is checked, lines starting with '$' are captured and removed wherever they fall (before or after a 
+ *  command response or URC). Other lines are compacted in place for command processing. A line left partial at the chunk end 
+ *  (sentence or not) continues in the next chunk, blank line terminators ahead of a sentence are removed with it.
+ * 
+ *  \param chunk [in\out] - RX chunk, NMEA lines are removed.
+ *  \param chunkSz [in] - Size of the chunk.
+ *  \return Size of the chunk remaining for command processing.
+ */
+uint16_t gnss__nmeaCapture(char *chunk, uint16_t chunkSz)
+{
+    uint16_t keptSz = 0;
+    uint16_t blankAt = 0;                                               // kept blank line terminators from here, dropped if a sentence follows
+
+    for (uint16_t indx = 0; indx < chunkSz; indx++)
+    {
+        char rxChar = chunk[indx];
+
+        if (!streamPtr->capturing && !streamPtr->lineOpen)              // line start
+        {
+            if (rxChar == '$')
+            {
+                keptSz = blankAt;
+                streamPtr->capturing = true;
+            }
+            else if (rxChar != ASCII_cCR && rxChar != ASCII_cLF)
+                streamPtr->lineOpen = true;
+        }
+
+        if (streamPtr->capturing)
+        {
+            if (rxChar == ASCII_cCR)
+                continue;
+            cbuf_push(&streamPtr->nmeaRing, rxChar);                    // ring full: sentence corrupted, rejected by checksum
+            if (rxChar == ASCII_cLF)
+            {
+                streamPtr->capturing = false;
+                blankAt = keptSz;
+            }
+            continue;
+        }
+
+        chunk[keptSz++] = rxChar;
+        if (rxChar == ASCII_cLF && streamPtr->lineOpen)
+        {
+            streamPtr->lineOpen = false;
+            blankAt = keptSz;
+        }
+    }
+    return keptSz;
 }
 
 
@@ -172,4 +376,179 @@ static resultCode_t gnssLocCompleteParser(const char *response, char **endptr)
     return result;
 }
 
+
+
+/**
+ *	\brief Restore NMEA source to BGx default (disabled), best effort: streaming is stopped regardless.
+ */
+static void s_restoreNmeaSrc()
+{
+    if (atcmd_tryInvokeAdv("AT+QGPSCFG=\"nmeasrc\",0", GNSS_TIMEOUTml, NULL))
+        atcmd_awaitResult(true);
+}
+
+
+/**
+ *	\brief Validate NMEA sentence checksum: XOR of chars between $ and *.
+ */
+static bool s_nmeaChecksumValid(const char *sentence)
+{
+    if (sentence[0] != '$')
+        return false;
+
+    uint8_t checksum = 0;
+    const char *nmeaChar = sentence + 1;
+    while (*nmeaChar != ASCII_cNULL && *nmeaChar != '*')
+        checksum ^= *nmeaChar++;
+
+    if (*nmeaChar != '*')
+        return false;
+    return checksum == (uint8_t)strtol(nmeaChar + 1, NULL, 16);
+}
+
+
+/**
+ *	\brief Parse a (validated) NMEA sentence into the streamed location. Sentences are split in place on commas.
+ */
+static void s_nmeaParse(char *sentence)
+{
+    char *fields[GNSS_NMEA_FIELDMAX];
+    uint8_t fieldCnt = 0;
+    char *fieldAt = sentence;
+
+    *strchr(sentence, '*') = ASCII_cNULL;                               // drop checksum
+    while (fieldAt != NULL && fieldCnt < GNSS_NMEA_FIELDMAX)
+    {
+        fields[fieldCnt++] = fieldAt;
+        fieldAt = strchr(fieldAt, ASCII_cCOMMA);
+        if (fieldAt != NULL)
+            *fieldAt++ = ASCII_cNULL;
+    }
+    if (strlen(fields[0]) != 6)                                         // $ttsss: talker (GP,GN,GL...) + sentence type
+        return;
+
+    gnssLocation_t *location = &streamPtr->location;
+    const char *sentenceType = fields[0] + 3;
+
+    if (memcmp(sentenceType, "GGA", 3) == 0 && fieldCnt >= 10)          // time, position, fix quality, satellites, hdop, altitude
+    {
+        strncpy(location->utc, fields[1], sizeof(location->utc) - 1);
+        if (s_parseFixed(fields[6], 0, NULL) == 0)
+        {
+            location->statusCode = GNSS_RESULT_NOFIX;
+            return;
+        }
+        location->lat.val = s_nmeaToDegrees(fields[2], fields[3]);
+        location->lon.val = s_nmeaToDegrees(fields[4], fields[5]);
+        location->nsat = s_parseFixed(fields[7], 0, NULL);
+        location->hdop = s_parseFixed(fields[8], 2, NULL);
+        location->altitude = s_parseFixed(fields[9], 2, NULL);
+        location->statusCode = RESULT_CODE_SUCCESS;
+        streamPtr->locationAt = lMillis();
+    }
+    else if (memcmp(sentenceType, "RMC", 3) == 0 && fieldCnt >= 10)     // time, status, position, speed, course, date
+    {
+        strncpy(location->utc, fields[1], sizeof(location->utc) - 1);
+        strncpy(location->date, fields[9], sizeof(location->date) - 1);
+        if (fields[2][0] != 'A')
+        {
+            location->statusCode = GNSS_RESULT_NOFIX;
+            return;
+        }
+        location->lat.val = s_nmeaToDegrees(fields[3], fields[4]);
+        location->lon.val = s_nmeaToDegrees(fields[5], fields[6]);
+        location->speedkn = s_parseFixed(fields[7], 2, NULL);
+        location->course = s_parseFixed(fields[8], 2, NULL);
+        location->statusCode = RESULT_CODE_SUCCESS;
+        streamPtr->locationAt = lMillis();
+    }
+    else if (memcmp(sentenceType, "VTG", 3) == 0 && fieldCnt >= 8)      // course, speed
+    {
+        location->course = s_parseFixed(fields[1], 2, NULL);
+        location->speedkn = s_parseFixed(fields[5], 2, NULL);
+        location->speedkm = s_parseFixed(fields[7], 2, NULL);
+    }
+    else if (memcmp(sentenceType, "GSA", 3) == 0 && fieldCnt >= 17)     // fix type, dop
+    {
+        location->fixType = s_parseFixed(fields[2], 0, NULL);
+        location->hdop = s_parseFixed(fields[16], 2, NULL);
+    }
+}
+
+
+/**
+ *	\brief Convert NMEA (d)ddmm.mmmm + hemisphere to signed fixed-point degrees, the same format as AT+QGPSLOC=2.
+ */
+static int32_t s_nmeaToDegrees(const char *nmeaVal, const char *hemisphere)
+{
+    int32_t nmeaDegMin = s_parseFixed(nmeaVal, GNSS_NMEA_MINDECIMALS, NULL);         // (d)ddmm x 1e5
+    int32_t degrees = nmeaDegMin / GNSS_NMEA_DEGSCALE;
+    int32_t minutes = nmeaDegMin % GNSS_NMEA_DEGSCALE;                                   // minutes x 1e5
+    int32_t fixedDegrees = degrees * GNSS_DEGREES_SCALE + (minutes * (GNSS_DEGREES_SCALE / 100000)) / 60;
+    return (hemisphere[0] == 'S' || hemisphere[0] == 'W') ? -fixedDegrees : fixedDegrees;
+}
+
+
+/**
+ *	\brief Parse a decimal number to fixed-point, digits beyond decimals are truncated. Stops at the first char not part of the number.
+ *
+ *  \param source [in] - Number text.
+ *  \param decimals [in] - Fixed-point decimal places, result is value x 10^decimals.
+ *  \param endptr [out] - If not NULL, set to char following the number (and following comma delimiter, if present).
+ */
+static int32_t s_parseFixed(const char *source, uint8_t decimals, const char **endptr)
+{
+    bool negative = false;
+    bool inFraction = false;
+    uint8_t fractionSz = 0;
+    int32_t value = 0;
+
+    if (*source == ASCII_cHYPHEN)
+    {
+        negative = true;
+        source++;
+    }
+    for (;; source++)
+    {
+        if (*source >= '0' && *source <= '9')
+        {
+            if (!inFraction || fractionSz < decimals)
+            {
+                value = value * 10 + (*source - '0');
+                fractionSz += inFraction;
+            }
+        }
+        else if (*source == '.' && !inFraction)
+            inFraction = true;
+        else
+            break;
+    }
+    for (; fractionSz < decimals; fractionSz++)
+        value *= 10;
+
+    if (*source == ASCII_cCOMMA)
+        source++;
+    if (endptr != NULL)
+        *endptr = source;
+    return negative ? -value : value;
+}
+
+
+/**
+ *	\brief Copy a comma delimited text field, truncated to fieldSz - 1.
+ *
+ *  \return Pointer to the char following the field delimiter.
+ */
+static const char *s_copyField(const char *source, char *field, uint8_t fieldSz)
+{
+    uint8_t copySz = 0;
+    for (; *source != ASCII_cNULL && *source != ASCII_cCOMMA && *source != ASCII_cCR; source++)
+    {
+        if (copySz < fieldSz - 1)
+            field[copySz++] = *source;
+    }
+    field[copySz] = ASCII_cNULL;
+    return (*source == ASCII_cCOMMA) ? source + 1 : source;
+}
+
 #pragma endregion
@@ -28,6 +28,9 @@
 #ifndef __LTEMC_GNSS_H__
 #define __LTEMC_GNSS_H__
 
+#define GNSS_RESULT_SESSIONACTIVE 504       ///< BGx +CME ERROR: GNSS session is ongoing (already on)
+#define GNSS_RESULT_NOFIX 516               ///< BGx +CME ERROR: not fixed now
+
 
 /** 
  *  \brief Enum describing the output format for location data.
@@ -40,36 +43,65 @@ typedef enum
 } gnss_format_t;
 
 
+#define GNSS_DEGREES_SCALE 10000000L        ///< Fixed-point degrees: degrees x 1e7 (~1.1cm at equator)
+#define GNSS_DEGREES_DECIMALS 7
+#define GNSS_CENTI_SCALE 100                ///< Fixed-point centi-units: value x 100 (hdop, altitude, course, speed)
+#define GNSS_NMEA_MINDECIMALS 5             ///< NMEA (d)ddmm.mmmmm minutes precision
+#define GNSS_NMEA_DEGSCALE 10000000L        ///< NMEA (d)ddmm.mmmmm x 1e5, degrees divisor
+
+
 /** 
  *  \brief Struct containing both the location value (latitude or longitude) and a char indicating direction (char only for DMS formats).
 */
 typedef struct gnss_latlon_tag
 {
-    float val;                      ///< The decimal number indicating the value for the lat/lon
+    int32_t val;                    ///< Fixed-point degrees x 1e7 (GNSS_DEGREES_SCALE), negative for S/W. Float: gnss_toDegrees(val).
     char dir;                       ///< Char indicating direction, values are N/S (lat) or E/W (lon). Optional based on format.
 } gnss_latlon_t;
 
 
 /** 
- *  \brief Struct containing a GNSS location fix.
+ *  \brief Struct containing a GNSS location fix. Values are fixed-point, see gnss_toDegrees() and gnss_fromCenti() for float conversions.
 */
 typedef struct gnssLocation_tag
 {
     char utc[11];           ///< Universal time value when fixing position.
     gnss_latlon_t lat;      ///< Latitude value as a struct gnss_latlon_tag (Quoted from GPGGA sentence).
     gnss_latlon_t lon;      ///< Longitude value as a struct gnss_latlon_tag (Quoted from GPGGA sentence).
-    float hdop;             ///< Horizontal precision: 0.5-99.9 (Quoted from GPGGA sentence).
-    float altitude;         ///< The altitude of the antenna away from the sea level (unit: m), accurate to one decimal place (Quoted from GPGGA sentence).
+    uint16_t hdop;          ///< Horizontal precision x 100: 50-9990 (Quoted from GPGGA sentence).
+    int32_t altitude;       ///< The altitude of the antenna away from the sea level, in centimeters (Quoted from GPGGA sentence).
     uint16_t fixType;       ///< GNSS positioning mode (Quoted from GNGSA/GPGSA sentence). Values: 2=2D positioning. 3=3D positioning
-    float course;           ///< Course Over Ground based on true north. Format: ddd.mm (Quoted from GPVTG sentence). Values: ddd=000-359 (degree), mm 00-59 (minute).
-    float speedkm;          ///< Speed over ground (metric). Format: xxxx.x; unit: Km/h; accurate to one decimal place (Quoted from GPVTG sentence).
-    float speedkn;          ///< Speed over ground (nautical). Format: xxxx.x; unit: Knots/h; accurate to one decimal place (Quoted from GPVTG sentence).
+    uint16_t course;        ///< Course Over Ground based on true north, degrees x 100 (Quoted from GPVTG sentence).
+    uint16_t speedkm;       ///< Speed over ground (metric), Km/h x 100 (Quoted from GPVTG sentence).
+    uint16_t speedkn;       ///< Speed over ground (nautical), Knots x 100 (Quoted from GPVTG sentence).
     char date[7];           ///< UTC time when fixing position. Format: ddmmyy (Quoted from GPRMC sentence).
     uint16_t nsat;          ///< Number of satellites, from 00 (The first 0 should be retained) to 12 (Quoted from GPGGA sentence).
     uint16_t statusCode;    ///< Result code indicating get location status. 200 = success, otherwise error condition.
 } gnssLocation_t;
 
 
+#define GNSS_NMEA_RINGSZ 512                ///< NMEA ring (ISR to doWork), about 1 second of GGA+RMC+VTG+GSA sentences
+#define GNSS_NMEA_SENTENCESZ 83             ///< NMEA 0183 max sentence length (82) + \0
+#define GNSS_NMEA_OUTPORT "uartnmea"        ///< BGx NMEA output port routed to the host (main) UART
+
+
+/** 
+ *  \brief Struct for the GNSS NMEA streaming state. Sentences are captured by the IOP ISR into nmeaRing and parsed in doWork.
+*/
+typedef struct gnssStream_tag
+{
+    cbuf_t nmeaRing;                        ///< Captured sentences, \n terminated
+    volatile bool capturing;                ///< ISR: partial sentence captured, continues in next RX chunk
+    volatile bool lineOpen;                 ///< ISR: partial non-NMEA line left for command processing, continues in next RX chunk
+    char sentence[GNSS_NMEA_SENTENCESZ];    ///< doWork: sentence being assembled from ring
+    uint8_t sentenceSz;
+    gnssLocation_t location;                ///< Latest location, updated sentence by sentence
+    uint32_t locationAt;                    ///< Time (millis) location last updated
+    uint16_t sentenceCnt;                   ///< Sentences parsed
+    uint16_t rejectCnt;                     ///< Sentences rejected (checksum, overflow)
+} gnssStream_t;
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -78,6 +110,17 @@ resultCode_t gnss_on();          // AT+QGPS=1
 resultCode_t gnss_off();
 
 gnssLocation_t gnss_getLocation();
+float gnss_toDegrees(int32_t fixedDegrees);
+float gnss_fromCenti(int32_t centiValue);
+
+resultCode_t gnss_streamStart();
+void gnss_streamStop();
+bool gnss_isStreaming();
+void gnss_doWork();
+
+// semi-private functions, not intended for most application but not static for special needs
+uint16_t gnss__nmeaCapture(char *chunk, uint16_t chunkSz);
+void gnss__parseLocation(const char *locInfo, gnssLocation_t *location);
 
 // future geo-fence
 void gnss_geoAdd();
@@ -0,0 +1,1142 @@
+/******************************************************************************
+ *  \file ltemc-http.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * HTTP(s) protocol support: requests with BGx HTTP(S) AT commands, response
+ * bodies streamed to the application through the IOP HTTP data peer.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include <ctype.h>
+#include "ltemc.h"
+#include "ltemc-http.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define HTTP_CMD_SZ 81
+#define HTTP_TIMEOUTml (PERIOD_FROM_SECONDS(HTTP_TIMEOUTsec) + 2000)     ///< action timeout, BGx timeout plus margin
+#define HTTP_SEND_CHUNKSZ 1024          ///< request body is queued to IOP TX buffer (1460 bytes) in chunks
+
+static iop_t *iopPtr;
+static http_t *httpPtr;
+static httpReceiver_func_t s_fileBodyRecvr_func;           // body staged in UFS, application receiver
+
+
+// private local declarations
+static resultCode_t s_configure(const char *url);
+static resultCode_t s_parseRequestResult(const char *response, const char *landmark);
+static resultCode_t s_readBody(httpReceiver_func_t recvr_func);
+static resultCode_t s_readBodyStream(httpReceiver_func_t recvr_func);
+static resultCode_t s_readBodyFile(httpReceiver_func_t recvr_func);
+static resultCode_t s_readToFile(const char *filename);
+static bool s_readToFileStart(const char *filename);
+static resultCode_t s_readToFileResult(atcmdResult_t atResult);
+static uint8_t s_nextBodyBuffer();
+static void s_readClose();
+static void s_fileBodyRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz);
+static resultCode_t s_sendBody(const char *data, uint32_t dataSz);
+static resultCode_t s_connectPromptParser(const char *response, char **endptr);
+static resultCode_t s_requestCompleteParser(const char *response, const char *landmark, char **endptr);
+static resultCode_t s_getCompleteParser(const char *response, char **endptr);
+static resultCode_t s_getExCompleteParser(const char *response, char **endptr);
+static resultCode_t s_postCompleteParser(const char *response, char **endptr);
+static resultCode_t s_postFileCompleteParser(const char *response, char **endptr);
+static resultCode_t s_readFileCompleteParser(const char *response, char **endptr);
+static resultCode_t s_sessionConnect();
+static void s_sessionRecvr(socketId_t socketId, void *data, uint16_t dataSz);
+static void s_sessionLine(httpSession_t *session);
+static void s_sessionResponseDone(httpSession_t *session);
+static void s_sessionClosed(socketId_t socketId, socketHealth_t health);
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Allocate and initialize the HTTP(S) client.
+ */
+void http_create()
+{
+    httpPtr = calloc(1, sizeof(http_t));
+	if (httpPtr == NULL)
+	{
+        ltem_notifyApp(ltemNotifType_memoryAllocFault, "http-could not alloc HTTP struct");
+        return;
+	}
+    httpPtr->contextId = g_ltem->dataContext;
+    httpPtr->sslContextId = TLS_CONTEXT_NONE;                           // default context acquired on first request
+
+    // set global reference to this
+    g_ltem->http = httpPtr;
+    // reference IOP peer
+    iopPtr = (iop_t *)g_ltem->iop;
+}
+
+
+/**
+ *	\brief Set the default receiver function for response bodies. Used for requests without a receiver function.
+ */
+void http_setRecvrFunc(httpReceiver_func_t recvr_func)
+{
+    httpPtr->receiver_func = recvr_func;
+}
+
+
+/**
+ *	\brief Set the URL for following requests, the URL is retained by BGx until changed.
+ *
+ *	\param url [in] - URL with scheme: http:// or https://, HTTPS uses the SSL context set with http_setSslOptions().
+ * 
+ *  \return 200 if set, otherwise error code (HTTP status type).
+ */
+resultCode_t http_setServerUrl(const char* url)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+    uint16_t urlSz = strlen(url);
+
+    if (urlSz == 0 || urlSz > HTTP_URL_MAXSZ)
+        return RESULT_CODE_BADREQUEST;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPURL=%d,%d", urlSz, HTTP_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_connectPromptParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);                 // wait for CONNECT, leave action open to send URL
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+    {
+        atcmd_close();
+        return atResult.statusCode;
+    }
+    atcmd_sendRaw(url, urlSz, HTTP_TIMEOUTml, NULL);
+    return atcmd_awaitResult(true).statusCode;
+}
+
+
+/**
+ *	\brief Set the SSL context used for HTTPS requests.
+ *
+ *	\param sslContextId [in] - BGx SSL context from tls_acquireContext().
+ * 
+ *  \return 200 if set, otherwise error code (HTTP status type).
+ */
+resultCode_t http_setSslOptions(uint8_t sslContextId)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    httpPtr->sslContextId = sslContextId;
+    if (!httpPtr->sslConfigured)                                        // applied with configuration on first HTTPS request
+        return RESULT_CODE_SUCCESS;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPCFG=\"sslctxid\",%d", sslContextId);
+    if (atcmd_tryInvoke(httpCmd))
+        return atcmd_awaitResult(true).statusCode;
+    return RESULT_CODE_CONFLICT;
+}
+
+
+/**
+ *	\brief Perform a HTTP GET request, the response body is streamed to the receiver function in chunks of HTTP_RECV_CHUNKSZ.
+ *
+ *	\param url [in] - URL to request.
+ *	\param recvr_func [in] - Receiver for the response body, NULL to use the default receiver (http_setRecvrFunc).
+ * 
+ *  \return HTTP status from the server (ex: 200, 404), otherwise error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_get(const char* url, httpReceiver_func_t recvr_func)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    resultCode_t rslt = s_configure(url);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = http_setServerUrl(url);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPGET=%d", HTTP_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_getCompleteParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+    rslt = (atResult.statusCode == RESULT_CODE_SUCCESS) ? s_parseRequestResult(atResult.response, "+QHTTPGET: ") : atResult.statusCode;
+    atcmd_close();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = s_readBody(recvr_func != NULL ? recvr_func : httpPtr->receiver_func);
+    return (rslt == RESULT_CODE_SUCCESS) ? httpPtr->httpStatus : rslt;
+}
+
+
+/**
+ *	\brief Perform a HTTP GET request, the response body is saved by BGx to a file (UFS).
+ *
+ *	\param url [in] - URL to request.
+ *	\param filename [in] - File to receive the response body, replaced if exists.
+ * 
+ *  \return HTTP status from the server (ex: 200, 404), otherwise error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_getFile(const char* url, const char* filename)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    resultCode_t rslt = s_configure(url);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = http_setServerUrl(url);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPGET=%d", HTTP_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_getCompleteParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+    rslt = (atResult.statusCode == RESULT_CODE_SUCCESS) ? s_parseRequestResult(atResult.response, "+QHTTPGET: ") : atResult.statusCode;
+    atcmd_close();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = s_readToFile(filename);
+    return (rslt == RESULT_CODE_SUCCESS) ? httpPtr->httpStatus : rslt;
+}
+
+
+/**
+ *	\brief Perform a HTTP GET request for a byte range of the resource, the partial body is saved by BGx to a file (UFS).
+ *
+ *  Server must support range requests; a server ignoring the range returns 200 with the full resource, check for 206 (partial content).
+ *
+ *	\param url [in] - URL to request.
+ *	\param startPos [in] - Offset of the first byte of the range.
+ *	\param rangeSz [in] - Number of bytes requested, the server may return fewer at the end of the resource (see http_getContentLength).
+ *	\param filename [in] - File to receive the partial body, replaced if exists.
+ * 
+ *  \return HTTP status from the server (ex: 206, 416), otherwise error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_getRangeFile(const char* url, uint32_t startPos, uint32_t rangeSz, const char* filename)
+{
+    resultCode_t rslt = http_getRangeFileAsync(url, startPos, rangeSz, filename);
+    if (rslt != RESULT_CODE_ACCEPTED)
+        return rslt;
+
+    while ((rslt = http_getRangeFileResult()) == RESULT_CODE_ACCEPTED)
+    {
+        lYield();
+    }
+    return rslt;
+}
+
+
+/**
+ *	\brief Start a HTTP GET request for a byte range of the resource, returning once the request is sent (the URL is set first). 
+ *  The request and the save of the partial body to file are advanced by http_getRangeFileResult(), the AT command channel is held
+ *  until the result is collected.
+ *
+ *	\param url [in] - URL to request.
+ *	\param startPos [in] - Offset of the first byte of the range.
+ *	\param rangeSz [in] - Number of bytes requested.
+ *	\param filename [in] - File to receive the partial body, replaced if exists.
+ * 
+ *  \return 202 if request sent, otherwise error code: 400 file name too long, 409 AT action busy, URL\configuration errors.
+ */
+resultCode_t http_getRangeFileAsync(const char* url, uint32_t startPos, uint32_t rangeSz, const char* filename)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    if (strlen(filename) > HTTP_FILENAME_MAXSZ)
+        return RESULT_CODE_BADREQUEST;
+
+    resultCode_t rslt = s_configure(url);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = http_setServerUrl(url);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPGETEX=%d,%lu,%lu", HTTP_TIMEOUTsec, (unsigned long)startPos, (unsigned long)rangeSz);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_getExCompleteParser))
+        return RESULT_CODE_CONFLICT;
+
+    strcpy(httpPtr->asyncFile, filename);
+    httpPtr->asyncStep = httpAsyncStep_request;
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief Advance the request started by http_getRangeFileAsync(), returns immediately. Once the server response is received the
+ *  partial body is saved to file (AT+QHTTPREADFILE sent), the request is complete when the file is saved.
+ * 
+ *  \return HTTP status from the server (ex: 206, 416) when complete, 202 if in progress, 404 if no request started, otherwise 
+ *  error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_getRangeFileResult()
+{
+    if (httpPtr->asyncStep == httpAsyncStep_none)
+        return RESULT_CODE_NOTFOUND;
+
+    atcmdResult_t atResult = atcmd_getResult(false);
+    if (atResult.statusCode == RESULT_CODE_PENDING)
+        return RESULT_CODE_ACCEPTED;
+
+    if (httpPtr->asyncStep == httpAsyncStep_request)
+    {
+        resultCode_t rslt = (atResult.statusCode == RESULT_CODE_SUCCESS) ? s_parseRequestResult(atResult.response, "+QHTTPGETEX: ") : atResult.statusCode;
+        atcmd_close();
+        if (rslt == RESULT_CODE_SUCCESS)
+        {
+            filsys_delete(httpPtr->asyncFile);
+            if (s_readToFileStart(httpPtr->asyncFile))
+            {
+                httpPtr->asyncStep = httpAsyncStep_readFile;
+                return RESULT_CODE_ACCEPTED;
+            }
+            rslt = RESULT_CODE_CONFLICT;
+        }
+        httpPtr->asyncStep = httpAsyncStep_none;
+        return rslt;
+    }
+
+    httpPtr->asyncStep = httpAsyncStep_none;
+    resultCode_t rslt = s_readToFileResult(atResult);
+    return (rslt == RESULT_CODE_SUCCESS) ? httpPtr->httpStatus : rslt;
+}
+
+
+/**
+ *	\brief Perform a HTTP POST request, the request body is streamed from the caller's buffer (no copy of the body is made).
+ *
+ *	\param url [in] - URL to request.
+ *	\param postData [in] - Request body.
+ *	\param dataSz [in] - Size of the request body.
+ *	\param recvr_func [in] - Receiver for the response body, NULL to use the default receiver (http_setRecvrFunc).
+ * 
+ *  \return HTTP status from the server (ex: 200, 404), otherwise error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_post(const char* url, const char* postData, uint32_t dataSz, httpReceiver_func_t recvr_func)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    resultCode_t rslt = s_configure(url);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = http_setServerUrl(url);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPPOST=%lu,%d,%d", (unsigned long)dataSz, HTTP_TIMEOUTsec, HTTP_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_connectPromptParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);                 // wait for CONNECT, leave action open to send body
+    if (atResult.statusCode == RESULT_CODE_SUCCESS)
+    {
+        atResult.statusCode = s_sendBody(postData, dataSz);
+        if (atResult.statusCode == RESULT_CODE_SUCCESS)
+            atResult = atcmd_awaitResult(false);                         // last chunk sent with request complete parser
+    }
+    rslt = (atResult.statusCode == RESULT_CODE_SUCCESS) ? s_parseRequestResult(atResult.response, "+QHTTPPOST: ") : atResult.statusCode;
+    atcmd_close();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = s_readBody(recvr_func != NULL ? recvr_func : httpPtr->receiver_func);
+    return (rslt == RESULT_CODE_SUCCESS) ? httpPtr->httpStatus : rslt;
+}
+
+
+/**
+ *	\brief Perform a HTTP POST request, the request body is sent by BGx from a file (UFS).
+ *
+ *	\param url [in] - URL to request.
+ *	\param filename [in] - File containing the request body.
+ *	\param recvr_func [in] - Receiver for the response body, NULL to use the default receiver (http_setRecvrFunc).
+ * 
+ *  \return HTTP status from the server (ex: 200, 404), otherwise error code: BGx HTTP errors are 701-730.
+ */
+resultCode_t http_postFile(const char* url, const char* filename, httpReceiver_func_t recvr_func)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    resultCode_t rslt = s_configure(url);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = http_setServerUrl(url);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPPOSTFILE=\"%s\",%d", filename, HTTP_TIMEOUTsec);
+    if (!atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_postFileCompleteParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+    rslt = (atResult.statusCode == RESULT_CODE_SUCCESS) ? s_parseRequestResult(atResult.response, "+QHTTPPOSTFILE: ") : atResult.statusCode;
+    atcmd_close();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = s_readBody(recvr_func != NULL ? recvr_func : httpPtr->receiver_func);
+    return (rslt == RESULT_CODE_SUCCESS) ? httpPtr->httpStatus : rslt;
+}
+
+
+/**
+ *	\brief Get the content-length of the last response, 0 if not reported by the server.
+ */
+uint32_t http_getContentLength()
+{
+    return httpPtr->contentLen;
+}
+
+
+/**
+ *	\brief Open a keep-alive session to a server. Requests are sent as raw HTTP/1.1 over a socket, the TCP\TLS connection is reused 
+ *  for following requests. Responses are framed (Content-Length or chunked) as socket data is received (ltem_doWork).
+ *
+ *	\param socketId [in] - Socket to use for the session (0-5).
+ *	\param host [in] - Server host name or IP address, also sent as the Host header.
+ *	\param port [in] - Server port (ex: 80, 443).
+ *	\param useTls [in] - Open the socket as SSL (HTTPS), otherwise TCP.
+ *	\param recvr_func [in] - Receiver for response bodies, chunks are delivered as received.
+ *	\param response_func [in] - Notification of each complete response (optional).
+ * 
+ *  \return 200 if connected, otherwise socket open error code.
+ */
+resultCode_t http_sessionOpen(socketId_t socketId, const char *host, uint16_t port, bool useTls, httpReceiver_func_t recvr_func, httpResponse_func_t response_func)
+{
+    if (socketId >= SOCKET_COUNT || strlen(host) >= HTTP_SESSION_HOSTSZ || recvr_func == NULL)
+        return RESULT_CODE_BADREQUEST;
+
+    if (httpPtr->session == NULL)
+    {
+        httpPtr->session = calloc(1, sizeof(httpSession_t));
+        if (httpPtr->session == NULL)
+        {
+            ltem_notifyApp(ltemNotifType_memoryAllocFault, "http-could not alloc session struct");
+            return RESULT_CODE_ERROR;
+        }
+    }
+    else
+        http_sessionClose();
+
+    httpSession_t *session = httpPtr->session;
+    session->socketId = socketId;
+    strcpy(session->host, host);
+    session->port = port;
+    session->useTls = useTls;
+    session->receiver_func = recvr_func;
+    session->response_func = response_func;
+    return s_sessionConnect();
+}
+
+
+/**
+ *	\brief Send a GET request on the session. Requests can be pipelined (sent before prior responses are received), up to 
+ *  HTTP_SESSION_PIPELINEMAX; responses are delivered in request order. A connection closed by the server is reopened.
+ *
+ *	\param path [in] - Request target (ex: /api/status?id=1).
+ * 
+ *  \return 200 if request sent, 503 if pipeline is full, 412 if no session, otherwise socket error code.
+ */
+resultCode_t http_sessionGet(const char *path)
+{
+    char request[HTTP_SESSION_REQSZ];
+    httpSession_t *session = httpPtr->session;
+
+    if (session == NULL)
+        return RESULT_CODE_PRECONDFAILED;
+    if (session->pendingCnt >= HTTP_SESSION_PIPELINEMAX)
+        return RESULT_CODE_UNAVAILABLE;
+
+    uint16_t requestSz = snprintf(request, HTTP_SESSION_REQSZ, "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n", path, session->host);
+    if (requestSz >= HTTP_SESSION_REQSZ)
+        return RESULT_CODE_BADREQUEST;
+
+    resultCode_t rslt = RESULT_CODE_SUCCESS;
+    if (session->reconnect && session->pendingCnt == 0)
+        http_sessionClose();
+    if (!session->open)
+        rslt = s_sessionConnect();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = sckt_send(session->socketId, request, requestSz);
+    if (rslt != RESULT_CODE_SUCCESS && session->pendingCnt == 0)       // idle connection dropped by server\network, reconnect once
+    {
+        PRINTF(dbgColor_warn, "http-session send failed=%d, reconnect\r", rslt);
+        http_sessionClose();
+        rslt = s_sessionConnect();
+        if (rslt == RESULT_CODE_SUCCESS)
+            rslt = sckt_send(session->socketId, request, requestSz);
+    }
+    if (rslt == RESULT_CODE_SUCCESS)
+        session->pendingCnt++;
+    return rslt;
+}
+
+
+/**
+ *	\brief Get the number of session requests sent and awaiting response.
+ */
+uint8_t http_sessionPending()
+{
+    return (httpPtr->session != NULL) ? httpPtr->session->pendingCnt : 0;
+}
+
+
+/**
+ *	\brief Close the session connection. A response framed by connection close (no length) is completed; other pending 
+ *  requests are abandoned. The session can be reopened by http_sessionGet().
+ */
+void http_sessionClose()
+{
+    httpSession_t *session = httpPtr->session;
+    if (session == NULL)
+        return;
+
+    if (session->open)
+        sckt_close(session->socketId);
+    if (session->parseState == httpParseState_bodyToClose && session->pendingCnt > 0)
+        s_sessionResponseDone(session);
+
+    session->open = false;
+    session->reconnect = false;
+    session->pendingCnt = 0;
+    session->parseState = httpParseState_status;
+    session->lineSz = 0;
+}
+
+
+#pragma endregion
+
+
+/* private (static) functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief [private] Send BGx HTTP configuration, once prior to first request.
+ */
+static resultCode_t s_configure(const char *url)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+    resultCode_t rslt = RESULT_CODE_SUCCESS;
+
+    for (size_t i = 0; i < 2 && !httpPtr->configured && rslt == RESULT_CODE_SUCCESS; i++)
+    {
+        if (i == 0)
+            snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPCFG=\"contextid\",%d", httpPtr->contextId);
+        else
+            snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPCFG=\"responseheader\",0");
+
+        rslt = atcmd_tryInvoke(httpCmd) ? atcmd_awaitResult(true).statusCode : RESULT_CODE_CONFLICT;
+    }
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+    httpPtr->configured = true;
+
+    if (httpPtr->sslConfigured || (strncmp(url, "https://", 8) != 0 && strncmp(url, "HTTPS://", 8) != 0))     // SSL context only for HTTPS
+        return RESULT_CODE_SUCCESS;
+
+    if (httpPtr->sslContextId == TLS_CONTEXT_NONE)
+    {
+        tlsOptions_t tlsOptions;
+        tls_initOptions(&tlsOptions, sslVersion_any);
+        httpPtr->sslContextId = tls_acquireContext(&tlsOptions);
+        if (httpPtr->sslContextId == TLS_CONTEXT_NONE)
+            return RESULT_CODE_UNAVAILABLE;
+    }
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPCFG=\"sslctxid\",%d", httpPtr->sslContextId);
+    rslt = atcmd_tryInvoke(httpCmd) ? atcmd_awaitResult(true).statusCode : RESULT_CODE_CONFLICT;
+    httpPtr->sslConfigured = (rslt == RESULT_CODE_SUCCESS);
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Parse request result: +<landmark> <err>,<httpStatus>,<contentLength>
+ * 
+ *  \return 200 if request completed (httpStatus and contentLen set), otherwise BGx HTTP error.
+ */
+static resultCode_t s_parseRequestResult(const char *response, const char *landmark)
+{
+    char *continueAt = strstr(response, landmark);
+    if (continueAt == NULL)
+        return RESULT_CODE_ERROR;
+
+    uint16_t err = strtol(continueAt + strlen(landmark), &continueAt, 10);
+    if (err != 0)
+        return err;
+
+    httpPtr->httpStatus = strtol(++continueAt, &continueAt, 10);        // inc past comma
+    httpPtr->contentLen = (continueAt[0] == ASCII_cCOMMA) ? strtol(++continueAt, NULL, 10) : 0;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief [private] Read the response body to the receiver.
+ */
+static resultCode_t s_readBody(httpReceiver_func_t recvr_func)
+{
+    httpPtr->bodySz = 0;
+    if (recvr_func == NULL)                                             // body not wanted, BGx discards on next request
+        return RESULT_CODE_SUCCESS;
+
+    if (httpPtr->contentLen > 0)
+        return s_readBodyStream(recvr_func);
+    return s_readBodyFile(recvr_func);                                  // length unknown (chunked), stage in file to find end of body
+}
+
+
+/**
+ *	\brief [private] Stream the response body through IOP data buffers, delivering chunks as they fill.
+ * 
+ *  IOP (ISR) fills the HTTP data peer buffers, switching to a new buffer as one fills. Chunks are delivered from the buffer being 
+ *  read while IOP continues to fill, a buffer is released back to IOP once filled and fully delivered.
+ */
+static resultCode_t s_readBodyStream(httpReceiver_func_t recvr_func)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPREAD=%d", HTTP_TIMEOUTsec);
+
+    if (!atcmd_tryInvokeStart(httpCmd, HTTP_TIMEOUTml, NULL))
+        return RESULT_CODE_CONFLICT;
+    iopPtr->rxDataPeer = iopDataPeer_HTTP;                              // set before command is sent, response follows immediately
+    atcmd_invokeSend();
+
+    httpPtr->trailerSz = 0;
+    httpPtr->trailer[0] = ASCII_cNULL;
+    bool connected = false;
+    uint8_t readIndx = IOP_NO_BUFFER;
+    uint32_t recvAt = lMillis();
+    resultCode_t rslt = RESULT_CODE_PENDING;
+
+    while (rslt == RESULT_CODE_PENDING)
+    {
+        if (readIndx == IOP_NO_BUFFER)
+            readIndx = s_nextBodyBuffer();
+
+        if (readIndx != IOP_NO_BUFFER)
+        {
+            iopBuffer_t *buf = iopPtr->rxDataBufs[readIndx];
+            bool bufFilled = buf->dataReady;                            // read before head, head is final once buffer filled
+            char *head = buf->head;
+
+            if (!connected)
+            {
+                // \r\nCONNECT\r\n<body>\r\nOK\r\n\r\n+QHTTPREAD: <err>\r\n
+                char *connectAt = strstr(buf->buffer, "CONNECT\r\n");
+                if (connectAt != NULL)
+                {
+                    buf->tail = connectAt + 9;
+                    connected = true;
+                }
+                else
+                {
+                    char *cmeAt = strstr(buf->buffer, "+CME ERROR: ");
+                    if (cmeAt != NULL && strstr(cmeAt, ASCII_sCRLF) != NULL)
+                        rslt = strtol(cmeAt + 12, NULL, 10);
+                }
+            }
+            if (connected)
+            {
+                if (head > buf->tail)
+                    recvAt = lMillis();
+
+                uint32_t bodyRemaining = httpPtr->contentLen - httpPtr->bodySz;
+                uint16_t bodyAvail = MIN(head - buf->tail, bodyRemaining);
+                while (bodyAvail >= HTTP_RECV_CHUNKSZ || (bodyAvail > 0 && (bufFilled || bodyAvail == bodyRemaining)))
+                {
+                    uint16_t chunkSz = MIN(bodyAvail, HTTP_RECV_CHUNKSZ);
+                    recvr_func(buf->tail, chunkSz);
+                    buf->tail += chunkSz;
+                    httpPtr->bodySz += chunkSz;
+                    bodyRemaining -= chunkSz;
+                    bodyAvail -= chunkSz;
+                }
+
+                if (bodyRemaining == 0)                                 // body delivered, collect trailer for read result
+                {
+                    uint16_t trailerAvail = head - buf->tail;
+                    uint16_t copySz = MIN(trailerAvail, HTTP_TRAILER_SZ - 1 - httpPtr->trailerSz);
+                    memcpy(httpPtr->trailer + httpPtr->trailerSz, buf->tail, copySz);
+                    httpPtr->trailerSz += copySz;
+                    httpPtr->trailer[httpPtr->trailerSz] = ASCII_cNULL;
+                    buf->tail += trailerAvail;
+
+                    char *readRsltAt = strstr(httpPtr->trailer, "+QHTTPREAD: ");
+                    if (readRsltAt != NULL && strstr(readRsltAt, ASCII_sCRLF) != NULL)
+                    {
+                        uint16_t err = strtol(readRsltAt + 12, NULL, 10);
+                        rslt = (err == 0) ? RESULT_CODE_SUCCESS : err;
+                    }
+                }
+                if (bufFilled && buf->tail == head)                     // filled buffer delivered, release to IOP
+                {
+                    iop_resetDataBuffer(readIndx);
+                    readIndx = IOP_NO_BUFFER;
+                }
+            }
+        }
+        if (rslt == RESULT_CODE_PENDING)
+        {
+            if (lTimerExpired(recvAt, HTTP_TIMEOUTml))
+                rslt = RESULT_CODE_TIMEOUT;
+            else
+                lYield();
+        }
+    }
+    s_readClose();
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Read a response body of unknown length: BGx saves to file, file is read to the receiver in chunks.
+ */
+static resultCode_t s_readBodyFile(httpReceiver_func_t recvr_func)
+{
+    resultCode_t rslt = s_readToFile(HTTP_BODYFILE);
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    fileOpenResult_t openResult = filsys_open(HTTP_BODYFILE, fileOpenMode_normalRdOnly, s_fileBodyRecvr);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    s_fileBodyRecvr_func = recvr_func;
+    uint32_t prevSz;
+    do
+    {
+        prevSz = httpPtr->bodySz;
+        rslt = filsys_read(openResult.fileHandle, HTTP_RECV_CHUNKSZ);
+    } while (rslt == RESULT_CODE_SUCCESS && httpPtr->bodySz - prevSz == HTTP_RECV_CHUNKSZ);
+    s_fileBodyRecvr_func = NULL;
+
+    filsys_close(openResult.fileHandle);
+    filsys_delete(HTTP_BODYFILE);
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Read the response body to a UFS file (replaced if exists), BGx writes the file.
+ */
+static resultCode_t s_readToFile(const char *filename)
+{
+    filsys_delete(filename);
+    if (!s_readToFileStart(filename))
+        return RESULT_CODE_CONFLICT;
+    return s_readToFileResult(atcmd_awaitResult(false));
+}
+
+
+/**
+ *	\brief [private] Send the read to file request (AT+QHTTPREADFILE), the action is left open for the result.
+ */
+static bool s_readToFileStart(const char *filename)
+{
+    char httpCmd[HTTP_CMD_SZ] = {0};
+
+    snprintf(httpCmd, HTTP_CMD_SZ, "AT+QHTTPREADFILE=\"%s\",%d", filename, HTTP_TIMEOUTsec);
+    return atcmd_tryInvokeAdv(httpCmd, HTTP_TIMEOUTml, s_readFileCompleteParser);
+}
+
+
+/**
+ *	\brief [private] Parse the read to file result (+QHTTPREADFILE: <err>) and close the action.
+ */
+static resultCode_t s_readToFileResult(atcmdResult_t atResult)
+{
+    resultCode_t rslt = atResult.statusCode;
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        char *continueAt = strstr(atResult.response, "+QHTTPREADFILE: ");
+        uint16_t err = strtol(continueAt + 16, NULL, 10);
+        rslt = (err == 0) ? RESULT_CODE_SUCCESS : err;
+    }
+    atcmd_close();
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Get the next HTTP data buffer to read: a filled buffer (older) before the buffer IOP is filling.
+ */
+static uint8_t s_nextBodyBuffer()
+{
+    for (size_t i = 0; i < IOP_RX_DATABUFFERS_MAX; i++)
+    {
+        if (iopPtr->rxDataBufs[i] != NULL && iopPtr->rxDataBufs[i]->dataPeer == iopDataPeer_HTTP && iopPtr->rxDataBufs[i]->dataReady)
+            return i;
+    }
+    return iopPtr->rxDataBufIndx;
+}
+
+
+/**
+ *	\brief [private] Release the HTTP data peer: IOP data buffers, return IOP to command mode and close action.
+ */
+static void s_readClose()
+{
+    iopPtr->rxDataPeer = iopDataPeer__NONE;
+    iopPtr->rxDataBufIndx = IOP_NO_BUFFER;
+    for (size_t i = 0; i < IOP_RX_DATABUFFERS_MAX; i++)
+    {
+        if (iopPtr->rxDataBufs[i] != NULL && iopPtr->rxDataBufs[i]->dataPeer == iopDataPeer_HTTP)
+            iop_resetDataBuffer(i);
+    }
+    atcmd_close();
+}
+
+
+/**
+ *	\brief [private] File receiver for body staged in UFS, forwards to the application receiver.
+ */
+static void s_fileBodyRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz)
+{
+    (void)fileHandle;
+    httpPtr->bodySz += dataSz;
+    if (s_fileBodyRecvr_func != NULL && dataSz > 0)
+        s_fileBodyRecvr_func(fileData, dataSz);
+}
+
+
+/**
+ *	\brief [private] Send request body from caller's buffer, queued to the IOP TX buffer in chunks as space is available.
+ *
+ *  \return 200 if body queued (last chunk sent with the request complete parser), 408 if the TX buffer did not drain.
+ */
+static resultCode_t s_sendBody(const char *data, uint32_t dataSz)
+{
+    uint32_t sentSz = 0;
+
+    while (sentSz < dataSz)
+    {
+        uint16_t chunkSz = MIN(dataSz - sentSz, HTTP_SEND_CHUNKSZ);
+        uint32_t waitStart = lMillis();
+        while (iopPtr->txPend + chunkSz >= IOP_TX_BUFFER_SZ)            // wait for room in TX buffer, bounded by BGx body input timeout
+        {
+            if (lTimerExpired(waitStart, HTTP_TIMEOUTml))
+                return RESULT_CODE_TIMEOUT;
+            lYield();
+        }
+
+        if (sentSz + chunkSz == dataSz)                                 // last chunk, wait for request result
+            atcmd_sendRaw(data + sentSz, chunkSz, HTTP_TIMEOUTml, s_postCompleteParser);
+        else
+            iop_txSend(data + sentSz, chunkSz, true);
+        sentSz += chunkSz;
+    }
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief [private] CONNECT prompt parser, BGx is ready to receive URL or body.
+ */
+static resultCode_t s_connectPromptParser(const char *response, char **endptr)
+{
+    char *connectAt = strstr(response, "CONNECT\r\n");
+    if (connectAt != NULL)
+    {
+        *endptr = connectAt + 9;
+        return RESULT_CODE_SUCCESS;
+    }
+    char *cmeAt = strstr(response, "+CME ERROR:");
+    if (cmeAt != NULL)
+        return strtol(cmeAt + 11, endptr, 10);
+    return RESULT_CODE_PENDING;
+}
+
+
+/**
+ *	\brief [private] Request complete parser, the request result follows OK: <landmark><err>[,<httpStatus>[,<contentLength>]]\r\n
+ */
+static resultCode_t s_requestCompleteParser(const char *response, const char *landmark, char **endptr)
+{
+    char *landmarkAt = strstr(response, landmark);
+    if (landmarkAt != NULL)
+    {
+        char *lineEnd = strstr(landmarkAt, ASCII_sCRLF);
+        if (lineEnd == NULL)
+            return RESULT_CODE_PENDING;
+        *endptr = lineEnd + 2;
+        return RESULT_CODE_SUCCESS;
+    }
+    char *cmeAt = strstr(response, "+CME ERROR:");
+    if (cmeAt != NULL)
+        return strtol(cmeAt + 11, endptr, 10);
+    return RESULT_CODE_PENDING;
+}
+
+
+static resultCode_t s_getCompleteParser(const char *response, char **endptr)
+{
+    return s_requestCompleteParser(response, "+QHTTPGET: ", endptr);
+}
+
+
+static resultCode_t s_getExCompleteParser(const char *response, char **endptr)
+{
+    return s_requestCompleteParser(response, "+QHTTPGETEX: ", endptr);
+}
+
+
+static resultCode_t s_postCompleteParser(const char *response, char **endptr)
+{
+    return s_requestCompleteParser(response, "+QHTTPPOST: ", endptr);
+}
+
+
+static resultCode_t s_postFileCompleteParser(const char *response, char **endptr)
+{
+    return s_requestCompleteParser(response, "+QHTTPPOSTFILE: ", endptr);
+}
+
+
+static resultCode_t s_readFileCompleteParser(const char *response, char **endptr)
+{
+    return s_requestCompleteParser(response, "+QHTTPREADFILE: ", endptr);
+}
+
+
+/**
+ *	\brief [private] Open the session socket, response parser is reset.
+ */
+static resultCode_t s_sessionConnect()
+{
+    httpSession_t *session = httpPtr->session;
+
+    resultCode_t rslt = sckt_open(session->socketId, session->useTls ? protocol_ssl : protocol_tcp, session->host, session->port, 0, true, s_sessionRecvr);
+    if (rslt == SOCKET_RESULT_PREVOPEN)
+        rslt = RESULT_CODE_SUCCESS;
+
+    session->open = (rslt == RESULT_CODE_SUCCESS);
+    if (session->open)
+        sckt__setClosedFunc(session->socketId, s_sessionClosed);
+    session->reconnect = false;
+    session->pendingCnt = 0;
+    session->parseState = httpParseState_status;
+    session->lineSz = 0;
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Socket receiver for the session, frames the response stream incrementally. Status, header and chunk-size 
+ *  lines are collected to the line scratch; body bytes are delivered to the application receiver without copy.
+ */
+static void s_sessionRecvr(socketId_t socketId, void *data, uint16_t dataSz)
+{
+    (void)socketId;
+    httpSession_t *session = httpPtr->session;
+    char *dataPtr = (char *)data;
+    char *dataEnd = dataPtr + dataSz;
+
+    while (dataPtr < dataEnd)
+    {
+        switch (session->parseState)
+        {
+            case httpParseState_body:
+            case httpParseState_chunkData:
+            {
+                uint16_t deliverSz = MIN(session->remaining, dataEnd - dataPtr);
+                session->receiver_func(dataPtr, deliverSz);
+                session->bodySz += deliverSz;
+                session->remaining -= deliverSz;
+                dataPtr += deliverSz;
+                if (session->remaining == 0)
+                {
+                    if (session->parseState == httpParseState_body)
+                        s_sessionResponseDone(session);
+                    else
+                        session->parseState = httpParseState_chunkEnd;
+                }
+                break;
+            }
+            case httpParseState_bodyToClose:
+                session->receiver_func(dataPtr, dataEnd - dataPtr);
+                session->bodySz += dataEnd - dataPtr;
+                dataPtr = dataEnd;
+                break;
+
+            default:                                                    // line oriented states
+                if (*dataPtr == ASCII_cLF)
+                {
+                    if (session->lineSz > 0 && session->line[session->lineSz - 1] == ASCII_cCR)
+                        session->lineSz--;
+                    session->line[session->lineSz] = ASCII_cNULL;
+                    s_sessionLine(session);
+                    session->lineSz = 0;
+                }
+                else if (session->lineSz < HTTP_SESSION_LINESZ - 1)
+                    session->line[session->lineSz++] = *dataPtr;
+                dataPtr++;
+                break;
+        }
+    }
+}
+
+
+/**
+ *	\brief [private] Process a complete response line (CRLF removed) for the current parse state.
+ */
+static void s_sessionLine(httpSession_t *session)
+{
+    switch (session->parseState)
+    {
+        case httpParseState_status:
+            if (strncmp(session->line, "HTTP/", 5) != 0)                // blank line between responses
+                return;
+            char *statusAt = strchr(session->line, ASCII_cSPACE);
+            session->httpStatus = (statusAt != NULL) ? strtol(statusAt, NULL, 10) : 0;
+            session->chunked = false;
+            session->lengthKnown = false;
+            session->connClose = false;
+            session->remaining = 0;
+            session->bodySz = 0;
+            session->parseState = httpParseState_headers;
+            return;
+
+        case httpParseState_headers:
+            if (session->lineSz == 0)                                   // end of headers, select body framing
+            {
+                if (session->httpStatus < 200)                          // interim (100 Continue), response follows
+                    session->parseState = httpParseState_status;
+                else if (session->httpStatus == 204 || session->httpStatus == 304)
+                    s_sessionResponseDone(session);
+                else if (session->chunked)
+                    session->parseState = httpParseState_chunkSize;
+                else if (session->lengthKnown)
+                {
+                    if (session->remaining == 0)
+                        s_sessionResponseDone(session);
+                    else
+                        session->parseState = httpParseState_body;
+                }
+                else
+                {
+                    session->connClose = true;
+                    session->parseState = httpParseState_bodyToClose;
+                }
+                return;
+            }
+            for (size_t i = 0; i < session->lineSz; i++)                // header names and framing tokens are case-insensitive
+                session->line[i] = tolower(session->line[i]);
+
+            if (strncmp(session->line, "content-length:", 15) == 0)
+            {
+                session->remaining = strtoul(session->line + 15, NULL, 10);
+                session->lengthKnown = true;
+            }
+            else if (strncmp(session->line, "transfer-encoding:", 18) == 0 && strstr(session->line + 18, "chunked") != NULL)
+                session->chunked = true;
+            else if (strncmp(session->line, "connection:", 11) == 0 && strstr(session->line + 11, "close") != NULL)
+                session->connClose = true;
+            return;
+
+        case httpParseState_chunkSize:
+            session->remaining = strtoul(session->line, NULL, 16);     // chunk extensions (;ext) end the hex parse
+            session->parseState = (session->remaining == 0) ? httpParseState_trailers : httpParseState_chunkData;
+            return;
+
+        case httpParseState_chunkEnd:
+            session->parseState = httpParseState_chunkSize;
+            return;
+
+        case httpParseState_trailers:
+            if (session->lineSz == 0)
+                s_sessionResponseDone(session);
+            return;
+
+        default:
+            return;
+    }
+}
+
+
+/**
+ *	\brief [private] Response complete: notify application, advance pipeline. 
+ * 
+ *  Invoked from the socket receiver (IRD action is open), a server close is deferred to the next request. Requests pipelined 
+ *  behind a response with Connection: close are not answered by the server, they are completed with status 410 (gone).
+ */
+static void s_sessionResponseDone(httpSession_t *session)
+{
+    if (session->response_func != NULL)
+        session->response_func(session->httpStatus, session->bodySz);
+    if (session->pendingCnt > 0)
+        session->pendingCnt--;
+    session->parseState = httpParseState_status;
+
+    if (session->connClose)
+    {
+        session->reconnect = true;
+        for (; session->pendingCnt > 0; session->pendingCnt--)
+        {
+            if (session->response_func != NULL)
+                session->response_func(RESULT_CODE_GONE, 0);
+        }
+    }
+}
+
+
+/**
+ *	\brief [private] Session socket found dead (server close, network drop), notified by sockets doWork after received data 
+ *  is delivered. A response framed by connection close is complete, any other pending requests are completed with status 410 
+ *  (gone). The parser is reset and the socket is reopened on the next request.
+ */
+static void s_sessionClosed(socketId_t socketId, socketHealth_t health)
+{
+    httpSession_t *session = httpPtr->session;
+    if (session == NULL || session->socketId != socketId)
+        return;
+
+    PRINTF(dbgColor_warn, "http-session closed, health=%d pending=%d\r", health, session->pendingCnt);
+    if (session->parseState == httpParseState_bodyToClose && session->pendingCnt > 0)
+        s_sessionResponseDone(session);
+    for (; session->pendingCnt > 0; session->pendingCnt--)
+    {
+        if (session->response_func != NULL)
+            session->response_func(RESULT_CODE_GONE, 0);
+    }
+    session->reconnect = true;
+    session->parseState = httpParseState_status;
+    session->lineSz = 0;
+}
+
+#pragma endregion
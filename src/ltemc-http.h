@@ -1,5 +1,5 @@
 /******************************************************************************
- *  \file ltemc-geo.h
+ *  \file ltemc-http.h
  *  \author Greg Terrell
  *  \license MIT License
  *
@@ -30,28 +30,135 @@
 
 #include "ltemc.h"
 
+#define HTTP_TIMEOUTsec 30                  ///< BGx response timeout for request (GET\POST), body input and read
+#define HTTP_RECV_CHUNKSZ 512               ///< Response body is delivered to the receiver in chunks of up to this size
+#define HTTP_URL_MAXSZ 200                  ///< Max URL length (BGx limit is 700)
+#define HTTP_TRAILER_SZ 48                  ///< Scratch for read response trailer: \r\nOK\r\n\r\n+QHTTPREAD: <err>\r\n
+#define HTTP_BODYFILE "http.tmp"            ///< UFS file used to stage bodies without content-length
+#define HTTP_FILENAME_MAXSZ 80              ///< Max UFS file name (BGx limit)
+
+#define HTTP_RESULT_BGXERRORS 700           ///< BGx HTTP errors (701-730) are returned as result codes
+
+#define HTTP_SESSION_HOSTSZ 64              ///< Session: max host name length
+#define HTTP_SESSION_REQSZ 256              ///< Session: max request (request line and headers)
+#define HTTP_SESSION_LINESZ 80              ///< Session: response status\header line scratch, longer lines are truncated (not needed for framing)
+#define HTTP_SESSION_PIPELINEMAX 4          ///< Session: max requests sent ahead of their responses
+
 
 /** 
- *  \brief typedef for the socket services data receiver function. Connects filesystem processing to the application (receive).
+ *  \brief typedef for the HTTP response body receiver function. Connects HTTP response processing to the application (receive).
+ *  Data is valid only for the duration of the receiver call.
 */
 typedef void (*httpReceiver_func_t)(void *fileData, uint16_t dataSz);
 
 
+/** 
+ *  \brief typedef for the session response complete function, invoked (in order of requests) as each response is fully received.
+*/
+typedef void (*httpResponse_func_t)(uint16_t httpStatus, uint32_t bodySz);
+
+
+/** 
+ *  \brief Session response parser states, the response stream is framed incrementally as socket data arrives.
+*/
+typedef enum httpParseState_tag
+{
+    httpParseState_status = 0,              ///< Status line: HTTP/1.1 <status> <reason>
+    httpParseState_headers = 1,             ///< Header lines until empty line
+    httpParseState_body = 2,                ///< Content-Length framed body
+    httpParseState_chunkSize = 3,           ///< Chunked: chunk size line (hex)
+    httpParseState_chunkData = 4,           ///< Chunked: chunk data
+    httpParseState_chunkEnd = 5,            ///< Chunked: CRLF following chunk data
+    httpParseState_trailers = 6,            ///< Chunked: trailer lines until empty line
+    httpParseState_bodyToClose = 7          ///< No length framing, body ends with connection close
+} httpParseState_t;
+
+
+/** 
+ *  \brief Struct for a persistent (keep-alive) HTTP session. Requests are sent as raw HTTP/1.1 over a socket (TCP or SSL), avoiding
+ *  the TCP\TLS handshakes of a BGx HTTP request for each request.
+*/
+typedef struct httpSession_tag
+{
+    socketId_t socketId;                    ///< Socket carrying the session
+    bool useTls;                            ///< Socket protocol SSL (HTTPS) or TCP
+    char host[HTTP_SESSION_HOSTSZ];         ///< Server, also sent as Host header
+    uint16_t port;
+    bool open;                              ///< Socket open (connection may still be closed by server)
+    bool reconnect;                         ///< Server signaled Connection: close, socket is reopened on next request
+    httpReceiver_func_t receiver_func;      ///< Response body receiver
+    httpResponse_func_t response_func;      ///< Response complete notification
+    uint8_t pendingCnt;                     ///< Requests sent, awaiting response
+    httpParseState_t parseState;
+    char line[HTTP_SESSION_LINESZ];         ///< Status\header\chunk-size line being collected
+    uint8_t lineSz;
+    uint16_t httpStatus;                    ///< Status of response being received
+    bool chunked;                           ///< Transfer-Encoding: chunked
+    bool lengthKnown;                       ///< Content-Length header received
+    bool connClose;                         ///< Connection: close, server closes after this response
+    uint32_t remaining;                     ///< Body (or chunk) bytes remaining
+    uint32_t bodySz;                        ///< Body bytes delivered, this response
+} httpSession_t;
+
+
+/** 
+ *  \brief Async range request (http_getRangeFileAsync) progress.
+*/
+typedef enum httpAsyncStep_tag
+{
+    httpAsyncStep_none = 0,                 ///< No async request in progress
+    httpAsyncStep_request = 1,              ///< AT+QHTTPGETEX sent, awaiting request result
+    httpAsyncStep_readFile = 2              ///< AT+QHTTPREADFILE sent, awaiting body saved to file
+} httpAsyncStep_t;
+
+
+/** 
+ *  \brief Struct for the HTTP client state.
+*/
+typedef struct http_tag
+{
+    uint8_t contextId;                      ///< PDP context for HTTP requests
+    uint8_t sslContextId;                   ///< SSL context for HTTPS requests
+    bool configured;                        ///< BGx HTTP(S) configuration sent
+    bool sslConfigured;                     ///< BGx SSL context configured, on first HTTPS request
+    httpReceiver_func_t receiver_func;      ///< Default response body receiver
+    resultCode_t httpStatus;                ///< HTTP status of last request
+    uint32_t contentLen;                    ///< Content-length of last response, 0 if not reported by server
+    uint32_t bodySz;                        ///< Response body bytes delivered
+    char trailer[HTTP_TRAILER_SZ];          ///< Read response trailer, following body
+    uint8_t trailerSz;
+    httpSession_t *session;                 ///< Keep-alive session, allocated on first http_sessionOpen()
+    httpAsyncStep_t asyncStep;              ///< Async range request progress
+    char asyncFile[HTTP_FILENAME_MAXSZ + 1];    ///< Async range request: file to receive the partial body
+} http_t;
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+void http_create();
 
-// set file read data receiver function (here or with file_open). Not required if file is write only access.
-void http_setRecvrFunc(httpReceiver_func_t fileRecvr_func);
+// set response body receiver function (here or with http_get). 
+void http_setRecvrFunc(httpReceiver_func_t recvr_func);
 
-resultCode_t http_setServerUrl(const char* fileName);
-resultCode_t http_setSslOptions();
+resultCode_t http_setServerUrl(const char* url);
+resultCode_t http_setSslOptions(uint8_t sslContextId);
 
-resultCode_t http_get(const char* url, httpReceiver_func_t fileRecvr_func);
+resultCode_t http_get(const char* url, httpReceiver_func_t recvr_func);
 resultCode_t http_getFile(const char* url, const char* filename);
-resultCode_t http_post(const char* url, const char* postData, uint16_t dataSz);
-resultCode_t http_postFile(const char* url, const char* filename);
+resultCode_t http_getRangeFile(const char* url, uint32_t startPos, uint32_t rangeSz, const char* filename);
+resultCode_t http_getRangeFileAsync(const char* url, uint32_t startPos, uint32_t rangeSz, const char* filename);
+resultCode_t http_getRangeFileResult();
+resultCode_t http_post(const char* url, const char* postData, uint32_t dataSz, httpReceiver_func_t recvr_func);
+resultCode_t http_postFile(const char* url, const char* filename, httpReceiver_func_t recvr_func);
+uint32_t http_getContentLength();
+
+// keep-alive session: raw HTTP/1.1 over a socket, requests can be pipelined
+resultCode_t http_sessionOpen(socketId_t socketId, const char *host, uint16_t port, bool useTls, httpReceiver_func_t recvr_func, httpResponse_func_t response_func);
+resultCode_t http_sessionGet(const char *path);
+uint8_t http_sessionPending();
+void http_sessionClose();
 
 
 #ifdef __cplusplus
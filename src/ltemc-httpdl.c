@@ -0,0 +1,503 @@
+/******************************************************************************
+ *  \file ltemc-httpdl.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * HTTP download manager: resumable download of large resources (ex: firmware
+ * images) to BGx UFS using range requests, progress persisted in UFS.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-httpdl.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define HTTP_STATUS_PARTIALCONTENT 206
+
+static httpdl_t httpdl;
+
+static const uint32_t crc32Nibbles[16] = 
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+
+// private local declarations
+static void s_chunkResult(resultCode_t rslt);
+static resultCode_t s_requestChunk();
+static resultCode_t s_fetchResult();
+static resultCode_t s_appendOpen();
+static resultCode_t s_appendPiece();
+static void s_appendClose();
+static resultCode_t s_loadProgress();
+static resultCode_t s_saveProgress();
+static void s_setState(httpdlState_t state, resultCode_t resultCode);
+static void s_copyRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz);
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Start (or resume) a download. If the progress record in UFS is for the same URL and file, the download continues from 
+ *  the last committed chunk; otherwise the image file is replaced. Chunks are fetched by httpdl_doWork() (ltem_doWork).
+ *
+ *  \param url [in] - URL of the image, the server must support range requests.
+ *  \param fileName [in] - UFS file to receive the image.
+ *  \param imageSz [in] - Size of the image (from update manifest).
+ *  \param expectedCrc [in] - CRC-32 of the image (from update manifest), verified when complete. 0 to skip verification.
+ *  \param progress_func [in] - Application function notified of progress and completion (optional).
+ * 
+ *  \return 200 if download started\resumed, 202 if the progress record shows the image is already downloaded, otherwise error code.
+ */
+resultCode_t httpdl_start(const char *url, const char *fileName, uint32_t imageSz, uint32_t expectedCrc, httpdlProgress_func progress_func)
+{
+    if (strlen(url) > HTTP_URL_MAXSZ || strlen(fileName) >= HTTPDL_FILENAMESZ || imageSz == 0)
+        return RESULT_CODE_BADREQUEST;
+    if (httpdl.state == httpdlState_downloading || httpdl.state == httpdlState_retryWait)
+        return RESULT_CODE_CONFLICT;
+
+    memset(&httpdl, 0, sizeof(httpdl_t));
+    strcpy(httpdl.url, url);
+    strcpy(httpdl.fileName, fileName);
+    httpdl.expectedCrc = expectedCrc;
+    httpdl.progress_func = progress_func;
+
+    uint32_t downloadId = httpdl__crc32(0, url, strlen(url));
+    downloadId = httpdl__crc32(downloadId, fileName, strlen(fileName));
+
+    if (s_loadProgress() != RESULT_CODE_SUCCESS || 
+        httpdl.progress.magic != HTTPDL_MAGIC || 
+        httpdl.progress.downloadId != downloadId || 
+        httpdl.progress.imageSz != imageSz ||
+        httpdl.progress.offset > imageSz)
+    {
+        PRINTF(dbgColor_info, "httpdl: new download\r");
+        memset(&httpdl.progress, 0, sizeof(httpdlProgress_t));
+        httpdl.progress.magic = HTTPDL_MAGIC;
+        httpdl.progress.downloadId = downloadId;
+        httpdl.progress.imageSz = imageSz;
+        filsys_delete(fileName);
+        resultCode_t rslt = s_saveProgress();
+        if (rslt != RESULT_CODE_SUCCESS)
+            return rslt;
+    }
+    else
+    {
+        PRINTF(dbgColor_info, "httpdl: resume at %lu\r", (unsigned long)httpdl.progress.offset);
+    }
+
+    if (httpdl.progress.offset == imageSz)
+    {
+        httpdl.state = httpdlState_complete;
+        httpdl.lastResult = (expectedCrc == 0 || httpdl.progress.crc == expectedCrc) ? RESULT_CODE_SUCCESS : RESULT_CODE_PRECONDFAILED;
+        return RESULT_CODE_ACCEPTED;
+    }
+    httpdl.state = httpdlState_downloading;
+    g_ltem->httpdlWork_func = httpdl_doWork;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief Stop the download. A BGx request in progress (range request or context activation) is completed first.
+ *
+ *  \param discard [in] - Delete the image and progress record, otherwise the download can be resumed by httpdl_start().
+ */
+void httpdl_cancel(bool discard)
+{
+    g_ltem->httpdlWork_func = NULL;
+    while (httpdl.activating && ntwk_getActivateResult() == RESULT_CODE_ACCEPTED)
+    {
+        lYield();
+    }
+    httpdl.activating = false;
+    if (httpdl.state == httpdlState_downloading)
+    {
+        while (httpdl.step == httpdlStep_fetching && http_getRangeFileResult() == RESULT_CODE_ACCEPTED)
+        {
+            lYield();
+        }
+        if (httpdl.step == httpdlStep_append)
+            s_appendClose();
+        httpdl.step = httpdlStep_request;
+    }
+    if (discard)
+    {
+        filsys_delete(HTTPDL_STATEFILE);
+        if (httpdl.fileName[0] != ASCII_cNULL)
+            filsys_delete(httpdl.fileName);
+    }
+    filsys_delete(HTTPDL_PARTFILE);
+    httpdl.state = httpdlState_idle;
+}
+
+
+/**
+ *	\brief Get the download state.
+ */
+httpdlState_t httpdl_getState()
+{
+    return httpdl.state;
+}
+
+
+/**
+ *	\brief Get the download progress (bytes committed and running CRC-32).
+ */
+httpdlProgress_t httpdl_getProgress()
+{
+    return httpdl.progress;
+}
+
+
+/**
+ *	\brief Background work, advances the current chunk by one step per invoke. Invoked by ltem_doWork() while a download is active.
+ *
+ *  The range request holds the AT command channel until BGx reports the body saved to the part file (up to HTTP_TIMEOUTsec for
+ *  each), other steps are a single file command. A new chunk is not started while the application has an AT action open.
+ * 
+ *  A failed chunk (ex: link lost, PDP context deactivated) enters retry wait; after HTTPDL_RETRYsec the network registration and
+ *  PDP context are checked (context activation is requested if needed) before the chunk is retried.
+ */
+void httpdl_doWork()
+{
+    if (httpdl.state == httpdlState_retryWait)
+    {
+        if (httpdl.activating)
+        {
+            if (ntwk_getActivateResult() == RESULT_CODE_ACCEPTED)
+                return;
+            httpdl.activating = false;
+        }
+        else
+        {
+            if (!lTimerExpired(httpdl.retryAt, PERIOD_FROM_SECONDS(HTTPDL_RETRYsec)))
+                return;
+
+            httpdl.retryAt = lMillis();                                 // network not ready: restart wait
+            if (!ntwk_isRegistered())
+                return;
+            if (ntwk_getPdpCntxt(g_ltem->dataContext) == NULL && !g_ltem->atcmd->isOpen)
+            {
+                httpdl.activating = (ntwk_activatePdpContextAsync(g_ltem->dataContext) == RESULT_CODE_ACCEPTED);
+                return;
+            }
+        }
+        if (ntwk_getPdpCntxt(g_ltem->dataContext) == NULL)
+            return;
+        httpdl.state = httpdlState_downloading;
+        httpdl.step = httpdlStep_request;
+    }
+    if (httpdl.state != httpdlState_downloading)
+        return;
+
+    resultCode_t rslt;
+    switch (httpdl.step)
+    {
+        case httpdlStep_request:
+            if (g_ltem->atcmd->isOpen)                                  // don't contend with application commands
+                return;
+            rslt = s_requestChunk();
+            break;
+        case httpdlStep_fetching:
+            rslt = s_fetchResult();
+            break;
+        case httpdlStep_appendOpen:
+            rslt = s_appendOpen();
+            break;
+        case httpdlStep_append:
+            rslt = s_appendPiece();
+            break;
+        default:
+            rslt = RESULT_CODE_ERROR;
+            break;
+    }
+    if (rslt != RESULT_CODE_ACCEPTED)                                   // chunk committed or failed
+        s_chunkResult(rslt);
+}
+
+
+/**
+ *	\brief Update a running CRC-32 (IEEE 802.3, reflected). Start with crc=0, the result after the last update is the final CRC.
+ */
+uint32_t httpdl__crc32(uint32_t crc, const char *data, uint16_t dataSz)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < dataSz; i++)
+    {
+        crc ^= (uint8_t)data[i];
+        crc = (crc >> 4) ^ crc32Nibbles[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32Nibbles[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+#pragma endregion
+
+
+/* private functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief [private] Completed chunk: notify progress (or complete the download) on success, otherwise retry wait or fail.
+ */
+static void s_chunkResult(resultCode_t rslt)
+{
+    httpdl.step = httpdlStep_request;
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        httpdl.failCnt = 0;
+        if (httpdl.progress.offset < httpdl.progress.imageSz)
+        {
+            httpdl.lastResult = rslt;
+            if (httpdl.progress_func != NULL)
+                httpdl.progress_func(httpdl.state, httpdl.progress.offset, httpdl.progress.imageSz, rslt);
+            return;
+        }
+        filsys_delete(HTTPDL_PARTFILE);
+        bool verified = httpdl.expectedCrc == 0 || httpdl.progress.crc == httpdl.expectedCrc;
+        s_setState(verified ? httpdlState_complete : httpdlState_failed, verified ? RESULT_CODE_SUCCESS : RESULT_CODE_PRECONDFAILED);
+    }
+    else if (rslt == RESULT_CODE_PRECONDFAILED)                         // server can't satisfy ranges, no retry
+    {
+        s_setState(httpdlState_failed, rslt);
+    }
+    else if (++httpdl.failCnt >= HTTPDL_RETRYMAX)
+    {
+        s_setState(httpdlState_failed, rslt);
+    }
+    else
+    {
+        PRINTF(dbgColor_warn, "httpdl: chunk failed=%d, retry\r", rslt);
+        httpdl.lastResult = rslt;
+        httpdl.retryAt = lMillis();
+        httpdl.state = httpdlState_retryWait;
+    }
+}
+
+
+/**
+ *	\brief [private] Send the range request for the next chunk, the partial body is saved to the part file by BGx.
+ * 
+ *  \return 202 if request sent (or AT channel busy, request is sent on a later pass), otherwise HTTP error (retryable).
+ */
+static resultCode_t s_requestChunk()
+{
+    httpdl.chunkSz = MIN(HTTPDL_CHUNKSZ, httpdl.progress.imageSz - httpdl.progress.offset);
+
+    resultCode_t rslt = http_getRangeFileAsync(httpdl.url, httpdl.progress.offset, httpdl.chunkSz, HTTPDL_PARTFILE);
+    if (rslt == RESULT_CODE_ACCEPTED)
+        httpdl.step = httpdlStep_fetching;
+    return (rslt == RESULT_CODE_CONFLICT) ? RESULT_CODE_ACCEPTED : rslt;
+}
+
+
+/**
+ *	\brief [private] Collect the range request result.
+ * 
+ *  \return 202 if pending or part file received, 412 if the server did not honor the range (or size mismatch), otherwise HTTP 
+ *  error (retryable).
+ */
+static resultCode_t s_fetchResult()
+{
+    resultCode_t rslt = http_getRangeFileResult();
+    if (rslt == RESULT_CODE_ACCEPTED)
+        return rslt;
+    if (rslt == RESULT_CODE_SUCCESS || rslt == RESULT_CODE_NOTFOUND || (rslt >= 411 && rslt <= 416))
+        return RESULT_CODE_PRECONDFAILED;                               // full content (range ignored) or resource\range invalid
+    if (rslt != HTTP_STATUS_PARTIALCONTENT)
+        return rslt;
+    if (http_getContentLength() != httpdl.chunkSz)
+        return RESULT_CODE_PRECONDFAILED;                               // image size does not match server resource
+
+    httpdl.step = httpdlStep_appendOpen;
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief [private] Open the part and image files for the append, the image is truncated to the committed offset (discarding 
+ *  uncommitted data from an interrupted append).
+ * 
+ *  \return 202 if files opened, otherwise file error (retryable).
+ */
+static resultCode_t s_appendOpen()
+{
+    fileOpenResult_t partResult = filsys_open(HTTPDL_PARTFILE, fileOpenMode_normalRdOnly, s_copyRecvr);
+    if (partResult.resultCode != RESULT_CODE_SUCCESS)
+        return partResult.resultCode;
+
+    fileOpenResult_t imageResult = filsys_open(httpdl.fileName, fileOpenMode_normalRdWr, NULL);
+    if (imageResult.resultCode != RESULT_CODE_SUCCESS)
+    {
+        filsys_close(partResult.fileHandle);
+        return imageResult.resultCode;
+    }
+    httpdl.partHandle = partResult.fileHandle;
+    httpdl.imageHandle = imageResult.fileHandle;
+
+    resultCode_t rslt = filsys_seek(httpdl.imageHandle, httpdl.progress.offset, fileSeekMode_seekFromBegin);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = filsys_truncate(httpdl.imageHandle);
+    if (rslt != RESULT_CODE_SUCCESS)
+    {
+        s_appendClose();
+        return rslt;
+    }
+    httpdl.copyOffset = httpdl.progress.offset;
+    httpdl.copyCrc = httpdl.progress.crc;
+    httpdl.step = httpdlStep_append;
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief [private] Copy one piece of the part file to the image file, updating the running CRC. When the chunk is copied the files
+ *  are closed and progress is committed: offset and crc in RAM, then the progress record.
+ * 
+ *  \return 202 if piece copied, 200 if chunk committed, otherwise file error (retryable).
+ */
+static resultCode_t s_appendPiece()
+{
+    uint32_t copied = httpdl.copyOffset - httpdl.progress.offset;
+
+    httpdl.copySz = 0;
+    resultCode_t rslt = filsys_read(httpdl.partHandle, MIN(HTTPDL_COPYSZ, httpdl.chunkSz - copied));
+    if (rslt == RESULT_CODE_SUCCESS && httpdl.copySz == 0)
+        rslt = RESULT_CODE_ERROR;                                       // part file shorter than reported content length
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        fileWriteResult_t writeResult = filsys_write(httpdl.imageHandle, httpdl.copyBuf, httpdl.copySz);
+        rslt = writeResult.resultCode;
+        if (rslt == RESULT_CODE_SUCCESS && writeResult.writtenSz != httpdl.copySz)
+            rslt = RESULT_CODE_ERROR;
+    }
+    if (rslt != RESULT_CODE_SUCCESS)
+    {
+        s_appendClose();
+        return rslt;
+    }
+
+    httpdl.copyCrc = httpdl__crc32(httpdl.copyCrc, httpdl.copyBuf, httpdl.copySz);
+    httpdl.copyOffset += httpdl.copySz;
+    if (httpdl.copyOffset - httpdl.progress.offset < httpdl.chunkSz)
+        return RESULT_CODE_ACCEPTED;
+
+    s_appendClose();
+    httpdl.progress.offset = httpdl.copyOffset;
+    httpdl.progress.crc = httpdl.copyCrc;
+    return s_saveProgress();
+}
+
+
+/**
+ *	\brief [private] Close the part and image files.
+ */
+static void s_appendClose()
+{
+    filsys_close(httpdl.imageHandle);
+    filsys_close(httpdl.partHandle);
+}
+
+
+/**
+ *	\brief [private] Read the progress record from UFS into httpdl.progress.
+ */
+static resultCode_t s_loadProgress()
+{
+    fileOpenResult_t openResult = filsys_open(HTTPDL_STATEFILE, fileOpenMode_normalRdOnly, s_copyRecvr);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    httpdl.copySz = 0;
+    resultCode_t rslt = filsys_read(openResult.fileHandle, sizeof(httpdlProgress_t));
+    filsys_close(openResult.fileHandle);
+
+    if (rslt == RESULT_CODE_SUCCESS && httpdl.copySz != sizeof(httpdlProgress_t))
+        rslt = RESULT_CODE_ERROR;
+    if (rslt == RESULT_CODE_SUCCESS)
+        memcpy(&httpdl.progress, httpdl.copyBuf, sizeof(httpdlProgress_t));
+    return rslt;
+}
+
+
+/**
+ *	\brief [private] Write httpdl.progress to the UFS progress record (replaced).
+ */
+static resultCode_t s_saveProgress()
+{
+    fileOpenResult_t openResult = filsys_open(HTTPDL_STATEFILE, fileOpenMode_clearRdWr, NULL);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    fileWriteResult_t writeResult = filsys_write(openResult.fileHandle, (const char *)&httpdl.progress, sizeof(httpdlProgress_t));
+    resultCode_t closeRslt = filsys_close(openResult.fileHandle);
+    return (writeResult.resultCode == RESULT_CODE_SUCCESS) ? closeRslt : writeResult.resultCode;
+}
+
+
+/**
+ *	\brief [private] Set terminal state (complete\failed), stop background work and notify application.
+ */
+static void s_setState(httpdlState_t state, resultCode_t resultCode)
+{
+    PRINTF(dbgColor_info, "httpdl: state=%d, result=%d\r", state, resultCode);
+    httpdl.state = state;
+    httpdl.lastResult = resultCode;
+    g_ltem->httpdlWork_func = NULL;
+    if (httpdl.progress_func != NULL)
+        httpdl.progress_func(state, httpdl.progress.offset, httpdl.progress.imageSz, resultCode);
+}
+
+
+/**
+ *	\brief [private] File receiver for part file and progress record reads, data is copied to httpdl.copyBuf.
+ */
+static void s_copyRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz)
+{
+    (void)fileHandle;
+    uint16_t copySz = MIN(dataSz, HTTPDL_COPYSZ - httpdl.copySz);
+    memcpy(httpdl.copyBuf + httpdl.copySz, fileData, copySz);
+    httpdl.copySz += copySz;
+}
+
+#pragma endregion
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *  \file ltemc-httpdl.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * HTTP download manager: resumable download of large resources (ex: firmware
+ * images) to BGx UFS using range requests, progress persisted in UFS.
+ *****************************************************************************/
+
+#ifndef __LTEMC_HTTPDL_H__
+#define __LTEMC_HTTPDL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ltemc-http.h"
+
+#define HTTPDL_CHUNKSZ 16384                ///< Range request size, a dropped link costs at most one chunk
+#define HTTPDL_COPYSZ 512                   ///< Chunk is appended from the part file to the image file in pieces of this size
+#define HTTPDL_FILENAMESZ 41                ///< Max image file name (BGx UFS limit is 80)
+#define HTTPDL_PARTFILE "httpdl.prt"        ///< UFS file receiving the current range
+#define HTTPDL_STATEFILE "httpdl.sta"       ///< UFS file persisting download progress
+#define HTTPDL_RETRYsec 10                  ///< Wait after a failed chunk before retrying
+#define HTTPDL_RETRYMAX 10                  ///< Consecutive failed chunks before the download is abandoned
+#define HTTPDL_MAGIC 0x4C445448             ///< Progress record signature ("HTDL")
+
+/*  Each chunk is fetched with a range request to HTTPDL_PARTFILE, appended to the image file at the committed offset and then 
+ *  the progress record is rewritten. A reset between append and progress write is recovered by truncating the image file to the
+ *  committed offset on resume. The running hash is CRC-32 (IEEE 802.3), the same as zlib crc32() and most build tools.
+ *
+ *  Work is split in short steps, one per httpdl_doWork(): the range request and body save are collected as the BGx completes 
+ *  them and the append is copied HTTPDL_COPYSZ bytes at a time, so ltem_doWork() is not held for the duration of a chunk.
+ */
+
+
+/** 
+ *  \brief Download manager states.
+*/
+typedef enum httpdlState_tag
+{
+    httpdlState_idle = 0,                   ///< No download started
+    httpdlState_downloading = 1,            ///< Chunks are fetched and appended by httpdl_doWork()
+    httpdlState_retryWait = 2,              ///< Chunk failed (or network lost), waiting for retry
+    httpdlState_complete = 3,               ///< Image downloaded and hash verified
+    httpdlState_failed = 4                  ///< Abandoned: retries exhausted, server error or hash mismatch
+} httpdlState_t;
+
+
+/** 
+ *  \brief Chunk steps, advanced one per httpdl_doWork() while downloading.
+*/
+typedef enum httpdlStep_tag
+{
+    httpdlStep_request = 0,                 ///< Send range request for the next chunk
+    httpdlStep_fetching = 1,                ///< Range request (and save to part file) in progress
+    httpdlStep_appendOpen = 2,              ///< Open part and image files, image truncated to committed offset
+    httpdlStep_append = 3                   ///< Copy one piece (HTTPDL_COPYSZ) of part file to image file
+} httpdlStep_t;
+
+
+/** 
+ *  \brief Typedef for the application's progress function, invoked after each committed chunk and on state change to complete\failed.
+*/
+typedef void (*httpdlProgress_func)(httpdlState_t state, uint32_t offset, uint32_t imageSz, resultCode_t resultCode);
+
+
+/** 
+ *  \brief Struct for the persisted download progress record (HTTPDL_STATEFILE).
+*/
+typedef struct httpdlProgress_tag
+{
+    uint32_t magic;                         ///< HTTPDL_MAGIC, record valid
+    uint32_t downloadId;                    ///< CRC-32 of URL and image file name, resume only the same download
+    uint32_t imageSz;                       ///< Expected image size
+    uint32_t offset;                        ///< Bytes committed to the image file
+    uint32_t crc;                           ///< Running CRC-32 of committed bytes
+} httpdlProgress_t;
+
+
+/** 
+ *  \brief Struct for the download manager state.
+*/
+typedef struct httpdl_tag
+{
+    char url[HTTP_URL_MAXSZ + 1];
+    char fileName[HTTPDL_FILENAMESZ];
+    uint32_t expectedCrc;                   ///< Image CRC-32 from manifest, verified at completion
+    httpdlState_t state;
+    httpdlProgress_t progress;
+    httpdlProgress_func progress_func;
+    resultCode_t lastResult;                ///< Result of the last chunk (or completion)
+    uint8_t failCnt;                        ///< Consecutive failed chunks
+    uint32_t retryAt;                       ///< Start of retry wait
+    bool activating;                        ///< Retry wait: data context activation requested, result pending
+    httpdlStep_t step;                      ///< Current chunk step
+    uint32_t chunkSz;                       ///< Size of the current chunk (range)
+    uint16_t partHandle;                    ///< Append: part file handle
+    uint16_t imageHandle;                   ///< Append: image file handle
+    uint32_t copyOffset;                    ///< Append: image offset reached, committed when the chunk is complete
+    uint32_t copyCrc;                       ///< Append: running CRC-32 at copyOffset
+    char copyBuf[HTTPDL_COPYSZ];            ///< Part file to image file copy
+    uint16_t copySz;
+} httpdl_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+resultCode_t httpdl_start(const char *url, const char *fileName, uint32_t imageSz, uint32_t expectedCrc, httpdlProgress_func progress_func);
+void httpdl_cancel(bool discard);
+httpdlState_t httpdl_getState();
+httpdlProgress_t httpdl_getProgress();
+void httpdl_doWork();
+
+// semi-private functions, not intended for most application but not static for special needs
+uint32_t httpdl__crc32(uint32_t crc, const char *data, uint16_t dataSz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_HTTPDL_H__
@@ -45,7 +45,6 @@
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define IOP_RXCTRLBLK_ADVINDEX(INDX) INDX = (++INDX == IOP_RXCTRLBLK_COUNT) ? 0 : INDX
 
-#define QBG_APPREADY_MILLISMAX 5000
 
 
 // shortcut to this
@@ -78,6 +77,9 @@ static void s_interruptCallbackISR();
     //
     // -- Protocols
     // +QIURC: "recv",      -- "unsolicited response" proto tcp/udp
+    // +QIURC: "incoming"   -- incoming connection accepted by a tcp listener
+    // +QIURC: "closed"     -- connection closed by remote peer (also +QSSLURC: "closed")
+    // +QISTATE:            -- socket state lines, captured while health monitor query pending
     // +QIRD: #             -- "read data" response 
     // +QSSLURC: "recv"     -- "unsolicited response" proto ssl tunnel
     // +QHTTPGET:           -- GET response, HTTP-READ 
@@ -149,12 +151,15 @@ void iop_start()
  */
 void iop_awaitAppReady()
 {
-    unsigned long apprdyWaitStart = lMillis();
-    while (g_ltem->qbgReadyState < qbg_readyState_appReady)
+    uint32_t apprdyWaitStart = lMillis();
+    while (g_ltem->qbgReadyState < qbg_readyState_appReady)        // set by APP RDY URC (iop_rxParseImmediate)
     {
+        if (lTimerExpired(apprdyWaitStart, QBG_APPREADY_MILLISMAX))
+        {
+            ltem_notifyApp(ltemNotifType_hwInitFailed,  "qbg-BGx module failed to start in the allowed time");
+            return;
+        }
         lYield();
-        if (apprdyWaitStart + QBG_APPREADY_MILLISMAX < lMillis())
-        ltem_notifyApp(ltemNotifType_hwInitFailed,  "qbg-BGx module failed to start in the allowed time");
     }
 }
 
@@ -290,6 +295,7 @@ static iopBuffer_t *s_rxBufCreate(size_t bufSz)
         free(rxBuf);
         return NULL;
     }
+    rxBuf->bufferEnd = rxBuf->buffer + bufSz;
     rxBuf->head = rxBuf->buffer;
     rxBuf->prevHead = rxBuf->buffer;
     rxBuf->tail = rxBuf->buffer;
@@ -305,9 +311,9 @@ static iopBuffer_t *s_rxBufCreate(size_t bufSz)
  */
 static uint8_t s_getDataBuffer(iopDataPeer_t dataPeer)
 {
-    for (size_t i = 0; i < IOP_RX_DATABUFFERS_MAX; i++)                         // return buffer already assigned to dataPeer, if exists
+    for (size_t i = 0; i < IOP_RX_DATABUFFERS_MAX; i++)                         // return buffer already assigned to dataPeer (not filled), if exists
     {
-        if (iopPtr->rxDataBufs[i] != NULL && iopPtr->rxDataBufs[i]->dataPeer == dataPeer)
+        if (iopPtr->rxDataBufs[i] != NULL && iopPtr->rxDataBufs[i]->dataPeer == dataPeer && !iopPtr->rxDataBufs[i]->dataReady)
             return i;
     }
 
@@ -410,16 +416,45 @@ static uint16_t s_txTake(char *data, uint16_t dataSz)
 */
 void iop_rxParseImmediate()
 {
+    if (iopPtr->peerTypeMap.gnssNmea)
+    {
+        uint16_t chunkSz = iopPtr->rxCmdBuf->head - iopPtr->rxCmdBuf->prevHead;
+        uint16_t keptSz = gnss__nmeaCapture(iopPtr->rxCmdBuf->prevHead, chunkSz);      // NMEA lines removed from chunk in place
+        if (keptSz != chunkSz)
+        {
+            PRINTF(dbgColor_cyan, "-p=nmea");
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead + keptSz;
+            if (keptSz == 0)
+                return;
+        }
+    }
+
+    if (iopPtr->peerTypeMap.socketState)                                        // socket state query, capture lines as they arrive
+    {
+        char *respEnd = iopPtr->rxCmdBuf->buffer + sckt__stateCapture(iopPtr->rxCmdBuf->buffer, iopPtr->rxCmdBuf->head - iopPtr->rxCmdBuf->buffer);
+        if (respEnd != iopPtr->rxCmdBuf->head)
+        {
+            PRINTF(dbgColor_cyan, "-p=qistate");
+            iopPtr->rxCmdBuf->head = respEnd;
+            if (iopPtr->rxCmdBuf->prevHead >= respEnd)
+            {
+                iopPtr->rxCmdBuf->prevHead = respEnd;
+                return;
+            }
+        }
+    }
+
     char *urcPrefix = memchr(iopPtr->rxCmdBuf->prevHead, '+', 6);             // all URC start with '+', skip leading \r\n 
     if (urcPrefix)
     {
         if (iopPtr->peerTypeMap.sslSocket && memcmp("+QSSLURC: \"recv", urcPrefix, strlen("+QSSLURC: \"recv")) == 0)
         {
             PRINTF(dbgColor_cyan, "-p=sslURC");
-            char *connIdPtr = iopPtr->rxCmdBuf->prevHead + strlen("+QSSLURC: \"recv");
+            char *connIdPtr = urcPrefix + strlen("+QSSLURC: \"recv\",");
             char *endPtr = NULL;
             uint8_t socketId = (uint8_t)strtol(connIdPtr, &endPtr, 10);
-            scktPtr->socketCtrls[socketId + iopDataPeer__SOCKET].dataPending = true;
+            if (socketId < IOP_SOCKET_COUNT)                                        // refused incoming connections (BGx ID > 5) are closed by sockets
+                scktPtr->socketCtrls[socketId + iopDataPeer__SOCKET].dataPending = true;
             // discard this chunk, processed here
             iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
         }
@@ -427,10 +462,35 @@ void iop_rxParseImmediate()
         else if (iopPtr->peerTypeMap.tcpudpSocket && memcmp("+QIURC: \"recv", urcPrefix, strlen("+QIURC: \"recv")) == 0)
         {
             PRINTF(dbgColor_cyan, "-p=ipURC");
-            char *connIdPtr = iopPtr->rxCmdBuf->prevHead + strlen("+QIURC: \"recv");
+            char *connIdPtr = urcPrefix + strlen("+QIURC: \"recv\",");
             char *endPtr = NULL;
             uint8_t socketId = (uint8_t)strtol(connIdPtr, &endPtr, 10);
-            scktPtr->socketCtrls[socketId + iopDataPeer__SOCKET].dataPending = true;
+            if (socketId < IOP_SOCKET_COUNT)                                        // refused incoming connections (BGx ID > 5) are closed by sockets
+                scktPtr->socketCtrls[socketId + iopDataPeer__SOCKET].dataPending = true;
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
+        }
+
+        else if (iopPtr->peerTypeMap.tcpudpSocket && memcmp("+QIURC: \"incoming", urcPrefix, strlen("+QIURC: \"incoming")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=ipIncoming");
+            sckt__urcIncoming(urcPrefix, iopPtr->rxCmdBuf->head - urcPrefix);
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
+        }
+
+        else if (iopPtr->peerTypeMap.tcpudpSocket && memcmp("+QIURC: \"closed", urcPrefix, strlen("+QIURC: \"closed")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=ipClosed");
+            sckt__urcClosed((uint8_t)strtol(urcPrefix + strlen("+QIURC: \"closed\","), NULL, 10));
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
+        }
+
+        else if (iopPtr->peerTypeMap.sslSocket && memcmp("+QSSLURC: \"closed", urcPrefix, strlen("+QSSLURC: \"closed")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=sslClosed");
+            sckt__urcClosed((uint8_t)strtol(urcPrefix + strlen("+QSSLURC: \"closed\","), NULL, 10));
             // discard this chunk, processed here
             iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
         }
@@ -448,26 +508,41 @@ void iop_rxParseImmediate()
         else if (iopPtr->peerTypeMap.mqttConnection && memcmp("+QMTSTAT:", urcPrefix, strlen("+QMTSTAT:")) == 0)
         {
             PRINTF(dbgColor_cyan, "-p=mqttS");
-            mqttPtr->state = mqttStatus_closed;
-            // todo mark mqtt connection closed
+            mqttPtr->state = mqttStatus_closed;                         // BGx closed MQTT connection, supervisor (if enabled) recovers in doWork
+            iopPtr->peerTypeMap.mqttConnection = 0;
+            iopPtr->peerTypeMap.mqttSubscribe = 0;
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
         }
 
         else if (iopPtr->peerTypeMap.pdpContext && memcmp("+QIURC: \"pdpdeact", urcPrefix, strlen("+QIURC: \"pdpdeact")) == 0)
         {
             PRINTF(dbgColor_cyan, "-p=pdpD");
+            char *connIdPtr = urcPrefix + strlen("+QIURC: \"pdpdeact\",");
+            ntwk__urcPdpDeact((uint8_t)strtol(connIdPtr, NULL, 10));
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
+        }
 
-            char *connIdPtr = iopPtr->rxCmdBuf->prevHead + strlen("+QIURC: \"pdpdeact");
-            char *endPtr = NULL;
-            uint8_t contextId = (uint8_t)strtol(connIdPtr, &endPtr, 10);
-            for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
-            {
-                if (g_ltem->network->pdpCntxts[i].contextId == contextId)
-                {
-                    g_ltem->network->pdpCntxts[i].contextId = 0;
-                    g_ltem->network->pdpCntxts[i].ipAddress[0] = 0;
-                    break;
-                }
-            }
+        else if (iopPtr->peerTypeMap.dnsLookup && memcmp("+QIURC: \"dnsgip", urcPrefix, strlen("+QIURC: \"dnsgip")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=dns");
+            dns__urcDnsgip(urcPrefix, iopPtr->rxCmdBuf->head - urcPrefix);
+            // discard this chunk, processed here
+            iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
+        }
+
+        else if (memcmp("+CEREG: ", urcPrefix, strlen("+CEREG: ")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=cereg");
+            if (ntwk__urcRegistration(urcPrefix + strlen("+CEREG: ")))        // response to AT+CEREG? is cached, but left for command result
+                iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;            // discard this chunk, processed here
+        }
+
+        else if (memcmp("+CGEV: ", urcPrefix, strlen("+CGEV: ")) == 0)
+        {
+            PRINTF(dbgColor_cyan, "-p=cgev");
+            ntwk__urcEvent(urcPrefix + strlen("+CGEV: "));
             // discard this chunk, processed here
             iopPtr->rxCmdBuf->head = iopPtr->rxCmdBuf->prevHead;
         }
@@ -556,6 +631,57 @@ static void s_interruptCallbackISR()
                     //PRINTF(dbgColor_info, "d=%s", iopPtr->rxDataBufs[iopPtr->rxDataBufIndx]->buffer);
                 }
 
+                else if (iopPtr->rxDataPeer == iopDataPeer_FILE)             // file read\list, filesys awaits complete response in data buffer
+                {
+                    PRINTF(dbgColor_magenta, "-file ");
+
+                    if (iopPtr->rxDataBufIndx == IOP_NO_BUFFER)
+                    {
+                        iopPtr->rxDataBufIndx = s_getDataBuffer(iopPtr->rxDataPeer);
+                    }
+                    if (iopPtr->rxDataBufIndx == IOP_NO_BUFFER)                         // no buffer free: drop (filesys times out)
+                    {
+                        uint8_t discard[SC16IS741A_FIFO_BUFFER_SZ];
+                        sc16is741a_read(discard, rxLevel);
+                    }
+                    else
+                    {
+                        iopBuffer_t *dataBuf = iopPtr->rxDataBufs[iopPtr->rxDataBufIndx];
+                        if (dataBuf->head + rxLevel >= dataBuf->bufferEnd)              // overflow: keep receiving into last chunk, retains result trailer
+                            dataBuf->head = dataBuf->bufferEnd - SC16IS741A_FIFO_BUFFER_SZ - 1;
+                        sc16is741a_read(dataBuf->head, rxLevel);
+                        dataBuf->prevHead = dataBuf->head;
+                        dataBuf->head += rxLevel;
+                    }
+                }
+
+                else if (iopPtr->rxDataPeer == iopDataPeer_HTTP)             // HTTP read: buffers filled in turn, http delivers from filled\filling buffers
+                {
+                    PRINTF(dbgColor_magenta, "-http ");
+
+                    if (iopPtr->rxDataBufIndx == IOP_NO_BUFFER)
+                    {
+                        iopPtr->rxDataBufIndx = s_getDataBuffer(iopPtr->rxDataPeer);
+                    }
+                    if (iopPtr->rxDataBufIndx == IOP_NO_BUFFER)                         // no buffer free, http is behind: drop (http times out)
+                    {
+                        uint8_t discard[SC16IS741A_FIFO_BUFFER_SZ];
+                        sc16is741a_read(discard, rxLevel);
+                    }
+                    else
+                    {
+                        iopBuffer_t *dataBuf = iopPtr->rxDataBufs[iopPtr->rxDataBufIndx];
+                        sc16is741a_read(dataBuf->head, rxLevel);
+                        dataBuf->prevHead = dataBuf->head;
+                        dataBuf->head += rxLevel;
+                        if (dataBuf->bufferEnd - dataBuf->head <= SC16IS741A_FIFO_BUFFER_SZ)     // no room for another FIFO read, switch buffer
+                        {
+                            dataBuf->dataReady = true;
+                            iopPtr->rxDataBufIndx = IOP_NO_BUFFER;
+                        }
+                    }
+                }
+
                 // MQTT is unique: data is announced and delivered in same msg. Other data sources announce data, then you request it.
                 else if (iopPtr->rxDataPeer == iopDataPeer_MQTT)
                 {
@@ -69,10 +69,11 @@ typedef enum iopDataPeer_tag
     iopDataPeer_MQTT = 6,
     iopDataPeer_HTTP = 7,
     iopDataPeer_FTP = 8,
+    iopDataPeer_FILE = 9,
 
     iopDataPeer__SOCKET = 0,
     iopDataPeer__SOCKET_CNT = 6,
-    iopDataPeer__TABLESZ = iopDataPeer_FTP + 1,
+    iopDataPeer__TABLESZ = iopDataPeer_FILE + 1,
 
     iopDataPeer__NONE = 255
 } iopDataPeer_t;
@@ -91,6 +92,9 @@ typedef struct peerTypeMap_tag      // Remote data sources, 1 indicates active s
     uint8_t sslSocket;              // bit-map of open SSL sockets
     uint8_t mqttConnection;         // bool of MQTT server connection (only one connection to manage\monitor)
     uint8_t mqttSubscribe;          // bool of MQTT topic subscription, incoming message (only one incoming message receiver currently supported)
+    uint8_t gnssNmea;               // bool of GNSS NMEA streaming, sentences captured to GNSS NMEA ring
+    uint8_t dnsLookup;              // bool of DNS lookup pending, +QIURC: "dnsgip" results captured to DNS resolver
+    uint8_t socketState;            // bool of socket state query pending, +QISTATE lines captured to socket health monitor
 } peerTypeMap_t;    
 
 
@@ -160,6 +164,7 @@ void iop_awaitAppReady();
 uint16_t iop_txSend(const char *sendData, uint16_t sendSz, bool sendReady);
 void iop_rxParseImmediate();
 void iop_resetCmdBuffer();
+void iop_resetDataBuffer(uint8_t bufIndx);
 
 resultCode_t iop_txDataPromptParser(const char *response, char **endptr);
 
@@ -48,8 +48,14 @@
 #define ICCID_SIZE 20
 
 
+#define MDMINFO_LINE_SZ 48
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+
 // private local declarations
 static resultCode_t s_iccidCompleteParser(const char *response, char **endptr);
+static bool s_batchModemInfo();
+static char *s_nextLine(char *response, char *line, uint8_t lineSz);
 
 
 /* Public functions
@@ -64,6 +70,14 @@ static resultCode_t s_iccidCompleteParser(const char *response, char **endptr);
 */
 modemInfo_t mdminfo_ltem()
 {
+    if (*g_ltem->modemInfo->imei == 0 || *g_ltem->modemInfo->iccid == 0 || 
+        *g_ltem->modemInfo->fwver == 0 || *g_ltem->modemInfo->mfgmodel == 0)
+    {
+        if (s_batchModemInfo())                                         // single round trip for all values
+            return *g_ltem->modemInfo;
+    }
+
+    // batch failed (ex: no SIM for ICCID), get values individually
     if (*g_ltem->modemInfo->imei == NULL)
     {
         if (atcmd_tryInvoke("AT+GSN"))
@@ -179,6 +193,86 @@ uint8_t mdminfo_rssiBars(uint8_t numberOfBars)
  * --------------------------------------------------------------------------------------------- */
 #pragma region private functions
 
+/**
+ *	\brief Get the modem information values with a single batched AT command. Response is parsed in command order.
+ * 
+ *  \return True if all values were obtained.
+ */
+static bool s_batchModemInfo()
+{
+    // ATI+GSN;+ICCID;+QGMR response lines:
+    //   Quectel / BG96 / Revision: BG96MAR02A07M1G / {IMEI} / +ICCID: {ICCID} / BG96MAR02A07M1G_01.016.01.016 / OK
+    char mfg[MDMINFO_LINE_SZ];
+    char model[MDMINFO_LINE_SZ];
+    char line[MDMINFO_LINE_SZ];
+    atcmdBatch_t infoBatch;
+    bool complete = false;
+
+    atcmd_batchInit(&infoBatch);
+    atcmd_batchAdd(&infoBatch, "ATI");
+    atcmd_batchAdd(&infoBatch, "AT+GSN");
+    atcmd_batchAdd(&infoBatch, "AT+ICCID");
+    atcmd_batchAdd(&infoBatch, "AT+QGMR");
+    infoBatch.replayOnError = false;                                    // caller falls back to individual queries
+
+    atcmdResult_t atResult = atcmd_batchInvoke(&infoBatch, ACTION_TIMEOUTml * infoBatch.cmdCnt, false);
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+        return false;                                                   // batch invoke closed action on error
+
+    char *next = s_nextLine(atResult.response, mfg, MDMINFO_LINE_SZ);
+    next = s_nextLine(next, model, MDMINFO_LINE_SZ);
+    next = s_nextLine(next, line, MDMINFO_LINE_SZ);                     // Revision: 
+    if (next != NULL && strncmp(line, "Revision", 8) == 0)
+    {
+        snprintf(g_ltem->modemInfo->mfgmodel, sizeof(g_ltem->modemInfo->mfgmodel), "%s: %s", mfg, model);
+
+        next = s_nextLine(next, line, MDMINFO_LINE_SZ);                 // IMEI
+        strncpy(g_ltem->modemInfo->imei, line, IMEI_SIZE);
+
+        next = s_nextLine(next, line, MDMINFO_LINE_SZ);                 // +ICCID: 
+        if (next != NULL && strncmp(line, "+ICCID: ", 8) == 0)
+            strncpy(g_ltem->modemInfo->iccid, line + 8, ICCID_SIZE);
+
+        next = s_nextLine(next, line, MDMINFO_LINE_SZ);                 // firmware version
+        if (next != NULL)
+        {
+            strncpy(g_ltem->modemInfo->fwver, line, sizeof(g_ltem->modemInfo->fwver) - 1);
+            char *term = strchr(g_ltem->modemInfo->fwver, '_');
+            if (term != NULL)
+                *term = ' ';
+            complete = *g_ltem->modemInfo->iccid != 0;
+        }
+    }
+    atcmd_close();
+    return complete;
+}
+
+
+/**
+ *	\brief Copy next non-empty response line, skips CR/LF framing between lines.
+ * 
+ *  \return Pointer to response following the line, NULL if no line found.
+ */
+static char *s_nextLine(char *response, char *line, uint8_t lineSz)
+{
+    line[0] = ASCII_cNULL;
+    if (response == NULL)
+        return NULL;
+
+    while (*response == ASCII_cCR || *response == ASCII_cLF)
+        response++;
+
+    char *lineEnd = strstr(response, ASCII_sCRLF);
+    if (lineEnd == NULL || lineEnd == response)
+        return NULL;
+
+    uint8_t copySz = MIN(lineEnd - response, lineSz - 1);
+    memcpy(line, response, copySz);
+    line[copySz] = ASCII_cNULL;
+    return lineEnd;
+}
+
+
 /**
  *	\brief Action response parser for iccid value request. 
  */
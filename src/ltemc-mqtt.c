@@ -46,6 +46,18 @@
 
 #define MQTT_ACTION_CMD_SZ 81
 #define MQTT_CONNECT_CMD_SZ 300
+#define MQTT_PUBLISH_HEAD_SZ 32                 ///< AT+QMTPUBEX=<tcpconnectID>,<msgID>,<qos>,<retain>," (topic and length are appended in TX buffer)
+#define MQTT_PROPS_ENCODEBUF_SZ 32              ///< property builder URL-encode chunk, flushed to TX buffer when full
+#define MQTT_OUTBOX_RECMAGIC 0xA5               ///< outbox record marker, detects torn (partially written) records
+#define MQTT_OUTBOX_RECHDRSZ 6                  ///< outbox record header: magic, qos, topicSz (LE16), messageSz (LE16)
+
+/* outbox read control, filesys receiver copies file data to dest */
+typedef struct outboxRead_tag
+{
+    char *dest;
+    uint16_t destSz;
+    uint16_t filledSz;
+} outboxRead_t;
 
 #pragma region Static Local Function Declarations
 static resultCode_t s_mqttOpenStatusParser(const char *response, char **endptr);
@@ -55,12 +67,36 @@ static resultCode_t s_mqttConnectCompleteParser(const char *response, char **end
 static resultCode_t s_mqttSubscribeCompleteParser(const char *response, char **endptr);
 static resultCode_t s_mqttPublishCompleteParser(const char *response, char **endptr);
 static void s_urlDecode(char *src, int len);
+static void s_urlEncodeToTx(const char *src, char *encodeBuf, uint8_t *encodeSz);
+static resultCode_t s_subscribeSlot(uint8_t subSlot);
+static void s_supervise();
+static void s_superviseRetry();
+static resultCode_t s_publish(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *data, uint16_t dataSz, mqttPublishHandle_t *pubHandle);
+static bool s_publishStart(const char *topic, uint16_t topicSz, mqttQos_t qos);
+static bool s_publishStartHandle(mqttPublishHandle_t *pubHandle);
+static resultCode_t s_publishComplete(const char *data, uint16_t dataSz);
+static resultCode_t s_publishAbort();
+static resultCode_t s_publishTo(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *data, uint16_t dataSz, mqttPublishHandle_t *pubHandle);
+static resultCode_t s_outboxAppend(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *message, uint16_t messageSz);
+static void s_outboxReplay();
+static uint32_t s_outboxFrame(uint32_t fileSz);
+static bool s_outboxResync(uint32_t fromOffset, uint32_t endOffset, uint32_t *nextOffset);
+static bool s_outboxHdrValid(const char *recHdr, uint32_t offset, uint32_t endOffset, uint32_t *recordSz);
+static bool s_outboxReadAt(uint32_t offset, char *dest, uint16_t readSz);
+static bool s_outboxRead(char *dest, uint16_t readSz);
+static void s_outboxRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz);
 #pragma endregion
 
 // IOP peer
 static iop_t *iopPtr;
 // this 
 static mqttPtr_t mqttPtr;
+// outbox file read in progress
+static outboxRead_t outboxRead;
+// publish builder, true between a successful mqtt_publishBegin() and mqtt_publishEnd() (AT command lock held)
+static bool publishBegun;
+// publish builder, true after first property appended (separator needed)
+static bool publishPropsAdded;
 
 
 /* public mqtt functions
@@ -79,6 +115,7 @@ void mqtt_create()
 	}
     mqttPtr->msgId = 1;
     mqttPtr->dataBufferIndx = IOP_NO_BUFFER;
+    mqttPtr->tlsContextId = TLS_CONTEXT_NONE;
 
     // set global reference
     g_ltem->mqtt = mqttPtr;
@@ -135,10 +172,26 @@ mqttStatus_t mqtt_status(const char *host, bool force)
 
 
 
+/**
+ *  \brief Use an application acquired SSL context (tls_acquireContext) for SSL connections, ex: for certificate authentication. 
+ *  Otherwise mqtt_open() acquires a context for the SSL version.
+ * 
+ *  \param tlsContextId [in] SSL context from tls_acquireContext().
+*/
+void mqtt_setTlsContext(uint8_t tlsContextId)
+{
+    if (mqttPtr->tlsContextId != TLS_CONTEXT_NONE && !mqttPtr->tlsContextAppSet)
+        tls_releaseContext(mqttPtr->tlsContextId);
+    mqttPtr->tlsContextId = tlsContextId;
+    mqttPtr->tlsContextAppSet = true;
+}
+
+
+
 /**
  *  \brief Open a remote MQTT server for use.
  * 
- *  \param host [in] The host IP address or name of the remote server.
+ *  \param host [in] The host IP address or name of the remote server. Without SSL, a name is opened by address from the DNS cache.
  *  \param port [in] The IP port number to use for the communications.
  *  \param useSslVersion [in] Specifies the version and options for use of SSL to protect communications.
  *  \param useMqttVersion [in] Specifies the MQTT protocol revision to use for communications.
@@ -153,22 +206,45 @@ resultCode_t mqtt_open(const char *host, uint16_t port, sslVersion_t useSslVersi
     // AT+QMTOPEN=5,"iothub-dev-pelogical.azure-devices.net",8883
 
     char actionCmd[MQTT_ACTION_CMD_SZ] = {0};
+    char openAddr[DNS_ADDRSZ];
+    const char *openHost = host;
+    bool addrCached = false;
     atcmdResult_t atResult;
 
-    mqttPtr->state = mqtt_status(host, true);     // refresh state, state must be not open for config changes
+    if (mqttPtr->tlsContextId != TLS_CONTEXT_NONE && !mqttPtr->tlsContextAppSet && mqttPtr->supervisor.sslVersion != useSslVersion)
+    {
+        tls_releaseContext(mqttPtr->tlsContextId);  // SSL version changed, context acquired below
+        mqttPtr->tlsContextId = TLS_CONTEXT_NONE;
+    }
+    mqttPtr->supervisor.host = host;                // retain for supervisor reconnect
+    mqttPtr->supervisor.port = port;
+    mqttPtr->supervisor.sslVersion = useSslVersion;
+    mqttPtr->supervisor.mqttVersion = useMqttVersion;
+
+    if (useSslVersion == sslVersion_none && !dns__isIpAddress(host))   // TLS verifies\indicates (SNI) the host name, BGx resolves
+    {
+        addrCached = dns_getCached(host, openAddr);
+        if (addrCached || dns_resolve(host, openAddr) == RESULT_CODE_SUCCESS)
+            openHost = openAddr;
+    }
+
+    mqttPtr->state = mqtt_status(openHost, true); // refresh state, state must be not open for config changes
     if (mqttPtr->state >= mqttStatus_open)        // already open+connected with server "host"
         return RESULT_CODE_SUCCESS;
 
     if (useSslVersion != sslVersion_none)
     {
-        snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QSSLCFG=\"sslversion\",%d,%d", MQTT_SOCKET_ID, (uint8_t)useSslVersion);
-        if (atcmd_tryInvoke(actionCmd))
+        // context is held across reconnects (supervisor), BGx resumes the cached TLS session instead of a full handshake
+        if (mqttPtr->tlsContextId == TLS_CONTEXT_NONE)
         {
-            if (atcmd_awaitResult(true).statusCode != RESULT_CODE_SUCCESS)
-                return RESULT_CODE_ERROR;
+            tlsOptions_t tlsOptions;
+            tls_initOptions(&tlsOptions, useSslVersion);
+            mqttPtr->tlsContextId = tls_acquireContext(&tlsOptions);
+            if (mqttPtr->tlsContextId == TLS_CONTEXT_NONE)
+                return RESULT_CODE_UNAVAILABLE;
         }
 
-        snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTCFG=\"ssl\",%d,1,%d", MQTT_SOCKET_ID, MQTT_SOCKET_ID);
+        snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTCFG=\"ssl\",%d,1,%d", MQTT_SOCKET_ID, mqttPtr->tlsContextId);
         if (atcmd_tryInvoke(actionCmd))
         {
             if (atcmd_awaitResult(true).statusCode != RESULT_CODE_SUCCESS)
@@ -187,10 +263,12 @@ resultCode_t mqtt_open(const char *host, uint16_t port, sslVersion_t useSslVersi
     }
 
     // TYPICAL: AT+QMTOPEN=0,"iothub-dev-pelogical.azure-devices.net",8883
-    snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTOPEN=%d,\"%s\",%d", MQTT_SOCKET_ID, host, port);
+    snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTOPEN=%d,\"%s\",%d", MQTT_SOCKET_ID, openHost, port);
     if (atcmd_tryInvokeAdv(actionCmd, PERIOD_FROM_SECONDS(45), s_mqttOpenCompleteParser))
     {
         atcmdResult_t atResult = atcmd_awaitResult(true);
+        if (addrCached && atResult.statusCode != RESULT_CODE_SUCCESS)
+            dns_invalidate(host);                   // host may have moved, next open (supervisor retry) does a fresh lookup
 
         // if (atResult.statusCode == RESULT_CODE_SUCCESS)
         //     iopPtr->peerTypeMap.mqttConnection = 1;
@@ -217,6 +295,7 @@ resultCode_t mqtt_open(const char *host, uint16_t port, sslVersion_t useSslVersi
                 return RESULT_CODE_ERROR;
         }
     }
+    return RESULT_CODE_CONFLICT;
 }
 
 
@@ -229,6 +308,7 @@ void mqtt_close()
 {
     char actionCmd[MQTT_ACTION_CMD_SZ] = {0};
 
+    mqttPtr->supervisor.state = mqttSupvState_off;          // application initiated close, stop supervision
     mqttPtr->state = mqttStatus_closed;                 
 
     iopPtr->peerTypeMap.mqttConnection = 0;           // release mqtt socket in IOP
@@ -278,6 +358,11 @@ resultCode_t mqtt_connect(const char *clientId, const char *username, const char
     char actionCmd[MQTT_CONNECT_CMD_SZ] = {0};
     atcmdResult_t atResult;
 
+    mqttPtr->supervisor.clientId = clientId;                // retain for supervisor reconnect
+    mqttPtr->supervisor.username = username;
+    mqttPtr->supervisor.password = password;
+    mqttPtr->supervisor.cleanSession = cleanSession;
+
     if (mqttPtr->state == mqttStatus_connected)       // already connected, trusting internal state as this is likely immediately after open
         return RESULT_CODE_SUCCESS;                         // mqtt_open forces mqtt state sync with BGx
 
@@ -331,7 +416,6 @@ resultCode_t mqtt_connect(const char *clientId, const char *username, const char
  */
 resultCode_t mqtt_subscribe(const char *topic, mqttQos_t qos, mqtt_recvFunc_t recv_func)
 {
-    char actionCmd[MQTT_ACTION_CMD_SZ] = {0};
     uint8_t subSlot = 0xFF;
 
     uint16_t topicSz = strlen(topic);
@@ -360,8 +444,7 @@ resultCode_t mqtt_subscribe(const char *topic, mqttQos_t qos, mqtt_recvFunc_t re
             if (mqttPtr->subscriptions[i].topicName[0] == 0)
             {
                 strncpy(mqttPtr->subscriptions[i].topicName, topicEntryName, strlen(topicEntryName)+1);
-                if (wildcard)
-                    mqttPtr->subscriptions[i].wildcard = '#';
+                mqttPtr->subscriptions[i].wildcard = wildcard ? '#' : 0;
                 mqttPtr->subscriptions[i].receiver_func = recv_func;
                 subSlot = i;
                 break;
@@ -370,24 +453,16 @@ resultCode_t mqtt_subscribe(const char *topic, mqttQos_t qos, mqtt_recvFunc_t re
     }
     if (subSlot == 0xFF)
         return RESULT_CODE_CONFLICT;
+    mqttPtr->subscriptions[subSlot].qos = qos;
 
     // regardless of new or existing subscription table entry, complete network subscribe
     // BGx implementation of MQTT doesn't provide subscription query, but is tolerant of duplicate subscription 
     // if sucessful, the topic's subscription will overwrite the IOP peer map without issue as well (same bitmap value)
 
-    snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTSUB=%d,%d,\"%s\",%d", MQTT_SOCKET_ID, ++mqttPtr->msgId, topic, qos);
-    if (atcmd_tryInvokeAdv(actionCmd, PERIOD_FROM_SECONDS(15), s_mqttSubscribeCompleteParser))
-    {
-        atcmdResult_t atResult = atcmd_awaitResult(true);
-        if (atResult.statusCode == RESULT_CODE_SUCCESS)
-        {
-            iopPtr->peerTypeMap.mqttSubscribe = iopPtr->peerTypeMap.mqttSubscribe | (1 << subSlot);
-            return atResult.statusCode;
-        }
-        else
-            mqttPtr->subscriptions[subSlot].topicName[0] = 0;        // if error on BGx subscribe, give table entry back
-    }
-    return RESULT_CODE_BADREQUEST;
+    resultCode_t rslt = s_subscribeSlot(subSlot);
+    if (rslt != RESULT_CODE_SUCCESS)
+        mqttPtr->subscriptions[subSlot].topicName[0] = 0;        // if error on BGx subscribe, give table entry back
+    return rslt;
 }
 
 
@@ -434,42 +509,278 @@ resultCode_t mqtt_unsubscribe(const char *topic)
 
 
 /**
- *  \brief Publish a message to server.
+ *  \brief Enable or disable the MQTT connection supervisor. When enabled, mqtt_doWork() detects a lost connection, reconnects
+ *  with randomized exponential backoff and restores the subscriptions table. Connection state changes are signaled to the application
+ *  with ltemNotifType_mqttDisconnect and ltemNotifType_mqttConnect notifications.
+ * 
+ *  The supervisor reuses the parameters of the last mqtt_open() and mqtt_connect(); the strings passed to those functions must 
+ *  remain valid while the supervisor is enabled. Each reconnect step is a single blocking AT action, one step per mqtt_doWork().
+ * 
+ *  \param enable [in] - True to start supervising the MQTT connection, false to return connection management to the application.
+ * 
+ *  \returns A resultCode_t value, RESULT_CODE_PRECONDFAILED if mqtt_open()\mqtt_connect() have not been invoked to set connection parameters.
+ */
+resultCode_t mqtt_supervise(bool enable)
+{
+    if (!enable)
+    {
+        mqttPtr->supervisor.state = mqttSupvState_off;
+        return RESULT_CODE_SUCCESS;
+    }
+    if (mqttPtr->supervisor.host == NULL || mqttPtr->supervisor.clientId == NULL)
+        return RESULT_CODE_PRECONDFAILED;
+
+    mqttPtr->supervisor.retryCnt = 0;
+    if (mqttPtr->state == mqttStatus_connected)
+        mqttPtr->supervisor.state = mqttSupvState_online;
+    else
+    {
+        mqttPtr->supervisor.state = mqttSupvState_backoff;          // start reconnect immediately
+        mqttPtr->supervisor.backoffStart = lMillis();
+        mqttPtr->supervisor.backoffPeriod = 0;
+    }
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *  \brief Publish a text message to server. If the outbox is enabled and MQTT is not connected, the message is persisted to the outbox for later delivery.
  * 
  *  \param topic [in] - Pointer to the message topic (see your server for topic formatting details).
  *  \param qos [in] - The MQTT QOS to be assigned to sent message.
- *  \param message [in] - Pointer to message to be sent.
+ *  \param message [in] - Pointer to message to be sent (C-string).
  * 
- *  \returns A resultCode_t value indicating the success or type of failure (http status type code).
-*/
+ *  \returns A resultCode_t value indicating the success or type of failure (http status type code). RESULT_CODE_ACCEPTED if queued to outbox.
+ */
 resultCode_t mqtt_publish(const char *topic, mqttQos_t qos, const char *message)
 {
-    // AT+QMTPUB=<tcpconnectID>,<msgID>,<qos>,<retain>,"<topic>"
-    char publishCmd[MQTT_TOPIC_PUBBUF_SZ] = {0};
-    char msgText[MQTT_MESSAGE_SZ];
-    atcmdResult_t atResult;
+    return mqtt_publishBin(topic, qos, message, strlen(message));
+}
 
-    // register the pending publish action
-    uint16_t msgId = ((uint8_t)qos == 0) ? 0 : ++mqttPtr->msgId;
-    snprintf(publishCmd, MQTT_TOPIC_PUBBUF_SZ, "AT+QMTPUB=%d,%d,%d,0,\"%s\"", MQTT_SOCKET_ID, msgId, qos, topic);
-    
-    if (atcmd_tryInvokeAdv(publishCmd, ACTION_TIMEOUTml, iop_txDataPromptParser))
+
+/**
+ *  \brief Publish a binary message to server. Message is length specified (AT+QMTPUBEX), so may contain any byte values including NUL and Ctrl-Z.
+ * 
+ *  \param topic [in] - Pointer to the message topic (see your server for topic formatting details).
+ *  \param qos [in] - The MQTT QOS to be assigned to sent message.
+ *  \param data [in] - Pointer to message data to be sent.
+ *  \param dataSz [in] - Size of the message data, max MQTT_PUBLISHBIN_MAXSZ (message is queued in full to IOP TX buffer).
+ * 
+ *  \returns A resultCode_t value indicating the success or type of failure (http status type code). RESULT_CODE_ACCEPTED if queued to outbox.
+ */
+resultCode_t mqtt_publishBin(const char *topic, mqttQos_t qos, const char *data, uint16_t dataSz)
+{
+    return s_publishTo(topic, strlen(topic), qos, data, dataSz, NULL);
+}
+
+
+/**
+ *  \brief Initialize a publish handle, the publish command with topic and properties is formatted once and reused for each message 
+ *  published with the handle (only the message ID is patched).
+ * 
+ *  \param pubHandle [out] - Application owned publish handle to initialize.
+ *  \param topic [in] - The message topic. For Azure IoTHub: devices/{deviceId}/messages/events/
+ *  \param props [in] - Optional (NULL if not used) properties appended to the topic, URL-encoded key=value pairs separated by '&'.
+ *  \param qos [in] - The MQTT QOS to be assigned to messages sent with this handle.
+ * 
+ *  \returns RESULT_CODE_SUCCESS, or RESULT_CODE_BADREQUEST if the topic and properties exceed MQTT_TOPIC_SZ.
+ */
+resultCode_t mqtt_publishHandleInit(mqttPublishHandle_t *pubHandle, const char *topic, const char *props, mqttQos_t qos)
+{
+    uint16_t topicSz = strlen(topic);
+    uint16_t propsSz = (props == NULL) ? 0 : strlen(props);
+    if (topicSz + propsSz > MQTT_TOPIC_SZ)
+        return RESULT_CODE_BADREQUEST;
+
+    // AT+QMTPUBEX=<tcpconnectID>,<msgID>,<qos>,<retain>,"<topic>    msgID is a zero filled placeholder
+    uint8_t headSz = snprintf(pubHandle->pubCmd, MQTT_TOPIC_PUBCMD_OVRHD_SZ, "AT+QMTPUBEX=%d,%0*d,%d,0,\"", MQTT_SOCKET_ID, MQTT_PUBLISH_MSGID_DIGITS, 0, qos);
+    pubHandle->msgIdOffset = strchr(pubHandle->pubCmd, ',') + 1 - pubHandle->pubCmd;
+    pubHandle->topicOffset = headSz;
+
+    memcpy(pubHandle->pubCmd + headSz, topic, topicSz);
+    memcpy(pubHandle->pubCmd + headSz + topicSz, props, propsSz);
+    pubHandle->pubCmd[headSz + topicSz + propsSz] = ASCII_cNULL;
+    pubHandle->topicSz = topicSz + propsSz;
+    pubHandle->qos = qos;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *  \brief Publish a binary message to server using a publish handle (preformatted topic and properties).
+ * 
+ *  \param pubHandle [in] - Publish handle initialized with mqtt_publishHandleInit().
+ *  \param data [in] - Pointer to message data to be sent.
+ *  \param dataSz [in] - Size of the message data, max MQTT_PUBLISHBIN_MAXSZ.
+ * 
+ *  \returns A resultCode_t value indicating the success or type of failure (http status type code). RESULT_CODE_ACCEPTED if queued to outbox.
+ */
+resultCode_t mqtt_publishWithHandle(mqttPublishHandle_t *pubHandle, const char *data, uint16_t dataSz)
+{
+    return s_publishTo(pubHandle->pubCmd + pubHandle->topicOffset, pubHandle->topicSz, pubHandle->qos, data, dataSz, pubHandle);
+}
+
+
+/**
+ *  \brief Begin a publish with per-message properties. The topic and properties are written directly to the IOP TX buffer.
+ * 
+ *  A successful begin holds the AT command lock, the application must complete the publish with mqtt_publishAddProp() (optional, 
+ *  repeated) and mqtt_publishEnd(). Publishes built this way are not queued to the outbox, MQTT must be connected.
+ * 
+ *  \param topic [in] - The message topic. For Azure IoTHub: devices/{deviceId}/messages/events/
+ *  \param qos [in] - The MQTT QOS to be assigned to the message.
+ * 
+ *  \returns RESULT_CODE_SUCCESS if started, RESULT_CODE_UNAVAILABLE if not connected, RESULT_CODE_CONFLICT if AT command lock unavailable 
+ *  (or a publish is already begun).
+ */
+resultCode_t mqtt_publishBegin(const char *topic, mqttQos_t qos)
+{
+    if (publishBegun)
+        return RESULT_CODE_CONFLICT;
+    if (mqttPtr->state != mqttStatus_connected || mqtt_outboxPendingSz() > 0)
+        return RESULT_CODE_UNAVAILABLE;
+
+    publishPropsAdded = false;
+    publishBegun = s_publishStart(topic, strlen(topic), qos);
+    return publishBegun ? RESULT_CODE_SUCCESS : RESULT_CODE_CONFLICT;
+}
+
+
+/**
+ *  \brief Append a property (key=value) to a publish started with mqtt_publishBegin(). Key and value are URL-encoded as written.
+ * 
+ *  \param propKey [in] - Property name, Azure IoTHub system properties are prefixed with "$." (ex: $.ct).
+ *  \param propValue [in] - Property value.
+ * 
+ *  \returns RESULT_CODE_SUCCESS if appended, RESULT_CODE_PRECONDFAILED if no publish is begun (nothing is written to the TX buffer).
+ */
+resultCode_t mqtt_publishAddProp(const char *propKey, const char *propValue)
+{
+    char encodeBuf[MQTT_PROPS_ENCODEBUF_SZ];
+    uint8_t encodeSz = 0;
+
+    if (!publishBegun)
+        return RESULT_CODE_PRECONDFAILED;
+
+    if (publishPropsAdded)
+        encodeBuf[encodeSz++] = '&';
+    s_urlEncodeToTx(propKey, encodeBuf, &encodeSz);
+    encodeBuf[encodeSz++] = '=';
+    s_urlEncodeToTx(propValue, encodeBuf, &encodeSz);
+
+    atcmd_invokeAppend(encodeBuf, encodeSz);
+    publishPropsAdded = true;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *  \brief Complete a publish started with mqtt_publishBegin(), the command is sent and the message data transferred.
+ * 
+ *  \param data [in] - Pointer to message data to be sent.
+ *  \param dataSz [in] - Size of the message data, max MQTT_PUBLISHBIN_MAXSZ. If larger, the started command is abandoned.
+ * 
+ *  \returns A resultCode_t value indicating the success or type of failure (http status type code). RESULT_CODE_BADREQUEST if dataSz too large, 
+ *  RESULT_CODE_PRECONDFAILED if no publish is begun.
+ */
+resultCode_t mqtt_publishEnd(const char *data, uint16_t dataSz)
+{
+    if (!publishBegun)
+        return RESULT_CODE_PRECONDFAILED;
+    publishBegun = false;
+
+    if (dataSz > MQTT_PUBLISHBIN_MAXSZ)
+    {
+        s_publishAbort();
+        return RESULT_CODE_BADREQUEST;
+    }
+    return s_publishComplete(data, dataSz);
+}
+
+
+/**
+ *  \brief Enable the MQTT outbox, publishes made while not connected are persisted to a file in the BGx filesystem.
+ * 
+ *  Records from a previous session are framed: corrupt records are skipped (resync to next record), a torn record at the end of 
+ *  the file (interrupted append) is truncated.
+ * 
+ *  \param fileName [in] - Name of the outbox file in the BGx filesystem. Records from a previous session in this file are replayed on connect.
+ * 
+ *  \returns A resultCode_t value indicating the success or type of failure (http status type code).
+ */
+resultCode_t mqtt_outboxEnable(const char *fileName)
+{
+    if (mqttPtr->outbox.enabled)
+        return RESULT_CODE_SUCCESS;
+
+    fileOpenResult_t openResult = filsys_open(fileName, fileOpenMode_normalRdWr, s_outboxRecvr);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    resultCode_t rslt = filsys_seek(openResult.fileHandle, 0, fileSeekMode_seekFromEnd);
+    filePositionResult_t posResult = filsys_getPosition(openResult.fileHandle);
+    if (rslt != RESULT_CODE_SUCCESS || posResult.resultCode != RESULT_CODE_SUCCESS)
+    {
+        filsys_close(openResult.fileHandle);
+        return RESULT_CODE_ERROR;
+    }
+
+    mqttPtr->outbox.replayBuf = calloc(1, MQTT_TOPIC_SZ + MQTT_OUTBOX_MSG_MAXSZ);    // kept off the doWork stack
+    if (mqttPtr->outbox.replayBuf == NULL)
     {
-        atResult = atcmd_awaitResult(false);
+        filsys_close(openResult.fileHandle);
+        ltem_notifyApp(ltemNotifType_memoryAllocFault, "mqtt-could not alloc outbox buffer");
+        return RESULT_CODE_ERROR;
+    }
 
-        if (atResult.statusCode == RESULT_CODE_SUCCESS)         // wait for data prompt for data, now complete sub-command to actually transfer data
+    mqttPtr->outbox.fileHandle = openResult.fileHandle;
+    uint32_t validSz = s_outboxFrame(posResult.fileOffset);                         // records left from previous session are pending
+    if (validSz < posResult.fileOffset)
+    {
+        PRINTF(DBGCOLOR_warn, "MQTT outbox torn record @%lu, truncating\r", validSz);
+        if (filsys_seek(openResult.fileHandle, validSz, fileSeekMode_seekFromBegin) != RESULT_CODE_SUCCESS ||
+            filsys_truncate(openResult.fileHandle) != RESULT_CODE_SUCCESS)
         {
-            atcmd_sendRawWithEOTs(message, strlen(message), ASCII_sCTRLZ, MQTT_PUBLISH_TIMEOUT, s_mqttPublishCompleteParser);
-            atResult = atcmd_awaitResult(true);
+            filsys_close(openResult.fileHandle);
+            free(mqttPtr->outbox.replayBuf);
+            mqttPtr->outbox.replayBuf = NULL;
+            return RESULT_CODE_ERROR;
         }
-
-        if (atResult.statusCode != RESULT_CODE_SUCCESS)         // if any problem, make sure BGx is out of text mode
-            atcmd_exitTextMode();
     }
-    else 
-        return RESULT_CODE_BADREQUEST;
+    mqttPtr->outbox.readOffset = 0;
+    mqttPtr->outbox.writeOffset = validSz;
+    mqttPtr->outbox.retryCnt = 0;
+    mqttPtr->outbox.lastReplayAt = 0;
+    mqttPtr->outbox.enabled = true;
+    return RESULT_CODE_SUCCESS;
+}
 
-    return atResult.statusCode;
+
+/**
+ *  \brief Disable the MQTT outbox and close its file. Records not yet replayed remain in the file for a future mqtt_outboxEnable().
+ */
+void mqtt_outboxDisable()
+{
+    if (!mqttPtr->outbox.enabled)
+        return;
+
+    mqttPtr->outbox.enabled = false;
+    filsys_close(mqttPtr->outbox.fileHandle);
+    free(mqttPtr->outbox.replayBuf);
+    mqttPtr->outbox.replayBuf = NULL;
+}
+
+
+/**
+ *  \brief Get the number of bytes in the MQTT outbox waiting to be replayed (published).
+ * 
+ *  \returns Size in bytes of the outbox records not yet replayed, 0 if outbox empty or not enabled.
+ */
+uint32_t mqtt_outboxPendingSz()
+{
+    if (!mqttPtr->outbox.enabled)
+        return 0;
+    return mqttPtr->outbox.writeOffset - mqttPtr->outbox.readOffset;
 }
 
 
@@ -511,6 +822,40 @@ static void s_urlDecode(char *src, int len)
 }
 
 
+/**
+ *  \brief URL encodes a string into a chunk buffer, the buffer is flushed to the TX buffer (open AT command) as it fills.
+ * 
+ *  \param src [in] - Text string to URL encode.
+ *  \param encodeBuf [in/out] - Chunk buffer, MQTT_PROPS_ENCODEBUF_SZ.
+ *  \param encodeSz [in/out] - Number of chars pending in chunk buffer.
+*/
+static void s_urlEncodeToTx(const char *src, char *encodeBuf, uint8_t *encodeSz)
+{
+    const char *hexDigits = "0123456789ABCDEF";
+
+    for (; *src != ASCII_cNULL; src++)
+    {
+        if (*encodeSz > MQTT_PROPS_ENCODEBUF_SZ - 4)            // flush, leave room for an encoded char and a separator
+        {
+            atcmd_invokeAppend(encodeBuf, *encodeSz);
+            *encodeSz = 0;
+        }
+        char c = *src;
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+            c == '-' || c == '_' || c == '.' || c == '~' || c == '$')
+        {
+            encodeBuf[(*encodeSz)++] = c;
+        }
+        else
+        {
+            encodeBuf[(*encodeSz)++] = '%';
+            encodeBuf[(*encodeSz)++] = hexDigits[(uint8_t)c >> 4];
+            encodeBuf[(*encodeSz)++] = hexDigits[(uint8_t)c & 0x0F];
+        }
+    }
+}
+
+
 /**
  *  \brief Performs background tasks to advance MQTT pipeline dataflows.
 */
@@ -565,6 +910,12 @@ void mqtt_doWork()
         mqttPtr->dataBufferIndx = IOP_NO_BUFFER;
         iop_resetDataBuffer(iopBufIndx);           // delivered, clear IOP data buffer
     }
+
+    if (mqttPtr && mqttPtr->supervisor.state != mqttSupvState_off)
+        s_supervise();
+
+    if (mqttPtr && mqttPtr->outbox.enabled)
+        s_outboxReplay();
 }
 
 
@@ -574,6 +925,455 @@ void mqtt_doWork()
  * --------------------------------------------------------------------------------------------- */
 #pragma region private functions
 
+/**
+ *  \brief [private] Invoke BGx subscribe for a subscriptions table entry.
+ */
+static resultCode_t s_subscribeSlot(uint8_t subSlot)
+{
+    char actionCmd[MQTT_ACTION_CMD_SZ] = {0};
+    mqttSubscription_t *subscription = &mqttPtr->subscriptions[subSlot];
+
+    // restore multilevel wildcard removed from table entry name
+    snprintf(actionCmd, MQTT_ACTION_CMD_SZ, "AT+QMTSUB=%d,%d,\"%s%s\",%d", MQTT_SOCKET_ID, ++mqttPtr->msgId, 
+             subscription->topicName, subscription->wildcard ? "#" : "", subscription->qos);
+
+    if (atcmd_tryInvokeAdv(actionCmd, PERIOD_FROM_SECONDS(15), s_mqttSubscribeCompleteParser))
+    {
+        atcmdResult_t atResult = atcmd_awaitResult(true);
+        if (atResult.statusCode == RESULT_CODE_SUCCESS)
+        {
+            iopPtr->peerTypeMap.mqttSubscribe = iopPtr->peerTypeMap.mqttSubscribe | (1 << subSlot);
+            return atResult.statusCode;
+        }
+    }
+    return RESULT_CODE_BADREQUEST;
+}
+
+
+/**
+ *  \brief [private] MQTT connection supervisor, advances reconnect by one step (AT action) per invoke.
+ */
+static void s_supervise()
+{
+    mqttSupervisor_t *supervisor = &mqttPtr->supervisor;
+
+    switch (supervisor->state)
+    {
+        case mqttSupvState_online:
+            if (mqttPtr->state != mqttStatus_connected)                             // +QMTSTAT URC or failed action closed connection
+            {
+                ltem_notifyApp(ltemNotifType_mqttDisconnect, "MQTT connection lost");
+                supervisor->retryCnt = 0;
+                supervisor->state = mqttSupvState_backoff;
+                supervisor->backoffStart = lMillis();
+                supervisor->backoffPeriod = 0;                                      // first attempt immediately
+            }
+            break;
+
+        case mqttSupvState_backoff:
+            if (lTimerExpired(supervisor->backoffStart, supervisor->backoffPeriod))
+                supervisor->state = mqttSupvState_open;
+            break;
+
+        case mqttSupvState_open:
+            if (mqtt_open(supervisor->host, supervisor->port, supervisor->sslVersion, supervisor->mqttVersion) == RESULT_CODE_SUCCESS)
+                supervisor->state = mqttSupvState_connect;
+            else
+                s_superviseRetry();
+            break;
+
+        case mqttSupvState_connect:
+            if (mqtt_connect(supervisor->clientId, supervisor->username, supervisor->password, supervisor->cleanSession) == RESULT_CODE_SUCCESS)
+            {
+                supervisor->subscrIndx = 0;
+                supervisor->state = mqttSupvState_subscribe;
+            }
+            else
+                s_superviseRetry();
+            break;
+
+        case mqttSupvState_subscribe:
+            while (supervisor->subscrIndx < MQTT_TOPIC_MAXCNT && 
+                   mqttPtr->subscriptions[supervisor->subscrIndx].topicName[0] == 0)
+                supervisor->subscrIndx++;                                           // skip empty table slots
+
+            if (supervisor->subscrIndx < MQTT_TOPIC_MAXCNT)
+            {
+                if (s_subscribeSlot(supervisor->subscrIndx) == RESULT_CODE_SUCCESS)
+                    supervisor->subscrIndx++;
+                else
+                    s_superviseRetry();
+            }
+            else
+            {
+                supervisor->retryCnt = 0;
+                supervisor->state = mqttSupvState_online;
+                ltem_notifyApp(ltemNotifType_mqttConnect, "MQTT connection restored");
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/**
+ *  \brief [private] Reconnect step failed, set next backoff period: exponential with random jitter in upper half of period.
+ */
+static void s_superviseRetry()
+{
+    mqttSupervisor_t *supervisor = &mqttPtr->supervisor;
+
+    uint32_t backoff = MQTT_RECONNECT_BASEml << MIN(supervisor->retryCnt, 16);
+    backoff = MIN(backoff, MQTT_RECONNECT_MAXml);
+    if (supervisor->retryCnt < UINT8_MAX)
+        supervisor->retryCnt++;
+
+    uint32_t jitterSeed = lMillis() * 2654435761u;                                 // Knuth multiplicative hash of timer, differs by device
+    supervisor->backoffPeriod = backoff / 2 + (jitterSeed % (backoff / 2 + 1));
+    supervisor->backoffStart = lMillis();
+    supervisor->state = mqttSupvState_backoff;
+
+    if (mqttPtr->state == mqttStatus_connected)                                     // failed restoring subscriptions, restart from open
+        mqttPtr->state = mqttStatus_open;
+    PRINTF(DBGCOLOR_warn, "MQTT reconnect retry=%d, backoff=%dms\r", supervisor->retryCnt, supervisor->backoffPeriod);
+}
+
+
+/**
+ *  \brief [private] Publish a message, outbox spill if enabled and not connected (or outbox replay is pending to preserve order) or publish fails.
+ */
+static resultCode_t s_publishTo(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *data, uint16_t dataSz, mqttPublishHandle_t *pubHandle)
+{
+    if (dataSz > MQTT_PUBLISHBIN_MAXSZ)
+        return RESULT_CODE_BADREQUEST;
+
+    if (mqttPtr->outbox.enabled &&
+        (mqttPtr->state != mqttStatus_connected ||
+         mqttPtr->outbox.readOffset < mqttPtr->outbox.writeOffset))
+    {
+        return s_outboxAppend(topic, topicSz, qos, data, dataSz);
+    }
+
+    resultCode_t rslt = s_publish(topic, topicSz, qos, data, dataSz, pubHandle);
+    if (mqttPtr->outbox.enabled && rslt != RESULT_CODE_SUCCESS)                    // connection likely dropped, keep the message
+    {
+        PRINTF(DBGCOLOR_warn, "MQTT publish failed (%d), to outbox\r", rslt);
+        return s_outboxAppend(topic, topicSz, qos, data, dataSz);
+    }
+    return rslt;
+}
+
+
+/**
+ *  \brief [private] Publish a message to server (no outbox handling). Data size is sent with the command, no EOT (Ctrl-Z) terminator.
+ *  With a publish handle (not NULL), its preformatted command is sent and topic\topicSz\qos are not used.
+ */
+static resultCode_t s_publish(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *data, uint16_t dataSz, mqttPublishHandle_t *pubHandle)
+{
+    bool started = (pubHandle != NULL) ? s_publishStartHandle(pubHandle) : s_publishStart(topic, topicSz, qos);
+    if (!started)
+        return RESULT_CODE_BADREQUEST;
+    return s_publishComplete(data, dataSz);
+}
+
+
+/**
+ *  \brief [private] Start publish command, the command head and topic are written to TX buffer. Topic properties can be appended before completing.
+ */
+static bool s_publishStart(const char *topic, uint16_t topicSz, mqttQos_t qos)
+{
+    // AT+QMTPUBEX=<tcpconnectID>,<msgID>,<qos>,<retain>,"<topic>",<msgLen>
+    char publishHead[MQTT_PUBLISH_HEAD_SZ];
+
+    uint16_t msgId = ((uint8_t)qos == 0) ? 0 : ++mqttPtr->msgId;
+    snprintf(publishHead, MQTT_PUBLISH_HEAD_SZ, "AT+QMTPUBEX=%d,%d,%d,0,\"", MQTT_SOCKET_ID, msgId, qos);
+
+    if (!atcmd_tryInvokeStart(publishHead, ACTION_TIMEOUTml, iop_txDataPromptParser))
+        return false;
+    atcmd_invokeAppend(topic, topicSz);
+    return true;
+}
+
+
+/**
+ *  \brief [private] Start publish command from a publish handle, the message ID is patched into the preformatted command.
+ */
+static bool s_publishStartHandle(mqttPublishHandle_t *pubHandle)
+{
+    uint16_t msgId = ((uint8_t)pubHandle->qos == 0) ? 0 : ++mqttPtr->msgId;
+    char *digit = pubHandle->pubCmd + pubHandle->msgIdOffset + MQTT_PUBLISH_MSGID_DIGITS;
+    for (size_t i = 0; i < MQTT_PUBLISH_MSGID_DIGITS; i++)
+    {
+        *--digit = '0' + msgId % 10;
+        msgId /= 10;
+    }
+    return atcmd_tryInvokeStart(pubHandle->pubCmd, ACTION_TIMEOUTml, iop_txDataPromptParser);
+}
+
+
+/**
+ *  \brief [private] Complete publish command with message length, send command and then transfer message data after BGx prompt.
+ */
+static resultCode_t s_publishComplete(const char *data, uint16_t dataSz)
+{
+    char publishTail[MQTT_PUBLISH_HEAD_SZ];
+    atcmdResult_t atResult;
+
+    snprintf(publishTail, MQTT_PUBLISH_HEAD_SZ, "\",%d", dataSz);
+    atcmd_invokeAppend(publishTail, strlen(publishTail));
+    atcmd_invokeSend();
+
+    atResult = atcmd_awaitResult(false);
+    if (atResult.statusCode == RESULT_CODE_SUCCESS)             // wait for data prompt for data, now complete sub-command to actually transfer data
+    {
+        atcmd_sendRaw(data, dataSz, MQTT_PUBLISH_TIMEOUT, s_mqttPublishCompleteParser);
+        atResult = atcmd_awaitResult(true);
+    }
+    else
+        atcmd_close();
+
+    return atResult.statusCode;
+}
+
+
+/**
+ *  \brief [private] Abandon a started publish command. The command line is not terminated (no CR), ESC cancels any part already 
+ *  transmitted to BGx and the action is closed. BGx does not respond to the cancel.
+ */
+static resultCode_t s_publishAbort()
+{
+    char cancel = ASCII_cESC;
+    iop_txSend(&cancel, 1, true);
+    atcmd_close();
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief [private] Append a publish to the outbox file as a record: header (magic, qos, topicSz, messageSz), topic, message.
+ * 
+ *  \return RESULT_CODE_ACCEPTED if persisted to the outbox, otherwise error code.
+ */
+static resultCode_t s_outboxAppend(const char *topic, uint16_t topicSz, mqttQos_t qos, const char *message, uint16_t messageSz)
+{
+    if (topicSz > MQTT_TOPIC_SZ || messageSz > MQTT_OUTBOX_MSG_MAXSZ)
+        return RESULT_CODE_BADREQUEST;
+
+    char recHdr[MQTT_OUTBOX_RECHDRSZ];
+    recHdr[0] = MQTT_OUTBOX_RECMAGIC;
+    recHdr[1] = (uint8_t)qos;
+    recHdr[2] = topicSz & 0xFF;
+    recHdr[3] = topicSz >> 8;
+    recHdr[4] = messageSz & 0xFF;
+    recHdr[5] = messageSz >> 8;
+
+    uint16_t fileHandle = mqttPtr->outbox.fileHandle;
+    if (filsys_seek(fileHandle, mqttPtr->outbox.writeOffset, fileSeekMode_seekFromBegin) != RESULT_CODE_SUCCESS ||
+        filsys_write(fileHandle, recHdr, MQTT_OUTBOX_RECHDRSZ).resultCode != RESULT_CODE_SUCCESS ||
+        filsys_write(fileHandle, topic, topicSz).resultCode != RESULT_CODE_SUCCESS ||
+        filsys_write(fileHandle, message, messageSz).resultCode != RESULT_CODE_SUCCESS)
+    {
+        if (filsys_seek(fileHandle, mqttPtr->outbox.writeOffset, fileSeekMode_seekFromBegin) == RESULT_CODE_SUCCESS)
+            filsys_truncate(fileHandle);                        // drop partial record; if this fails, it is truncated at next enable
+        return RESULT_CODE_ERROR;
+    }
+    mqttPtr->outbox.writeOffset += MQTT_OUTBOX_RECHDRSZ + topicSz + messageSz;
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief [private] Replay a batch of outbox records when connected, paced by MQTT_OUTBOX_PACINGml. Outbox file is truncated when fully replayed.
+ *  A record that fails to publish is kept and retried with backoff until the connection recovers.
+ */
+static void s_outboxReplay()
+{
+    mqttOutbox_t *outbox = &mqttPtr->outbox;
+
+    if (mqttPtr->state != mqttStatus_connected || 
+        outbox->readOffset >= outbox->writeOffset ||
+        !lTimerExpired(outbox->lastReplayAt, (uint32_t)MQTT_OUTBOX_PACINGml << MIN(outbox->retryCnt, MQTT_OUTBOX_BACKOFFMAX)))
+        return;
+
+    char recHdr[MQTT_OUTBOX_RECHDRSZ];
+    char *topic = outbox->replayBuf;
+    char *message = outbox->replayBuf + MQTT_TOPIC_SZ;
+
+    for (size_t i = 0; i < MQTT_OUTBOX_BATCHSZ && outbox->readOffset < outbox->writeOffset; i++)
+    {
+        uint32_t recordSz;
+        if (!s_outboxReadAt(outbox->readOffset, recHdr, MQTT_OUTBOX_RECHDRSZ))
+            break;
+
+        if (!s_outboxHdrValid(recHdr, outbox->readOffset, outbox->writeOffset, &recordSz))
+        {
+            uint32_t nextOffset;
+            if (!s_outboxResync(outbox->readOffset + 1, outbox->writeOffset, &nextOffset))
+                break;                                                  // file read failed, retry next pass
+            PRINTF(DBGCOLOR_warn, "MQTT outbox corrupt record @%lu, skipped to %lu\r", outbox->readOffset, nextOffset);
+            outbox->readOffset = nextOffset;                            // skip only the corrupt bytes, records following are kept
+            continue;
+        }
+
+        mqttQos_t qos = (mqttQos_t)recHdr[1];
+        uint16_t topicSz = (uint8_t)recHdr[2] | ((uint8_t)recHdr[3] << 8);
+        uint16_t messageSz = (uint8_t)recHdr[4] | ((uint8_t)recHdr[5] << 8);
+
+        if (!s_outboxRead(topic, topicSz) || !s_outboxRead(message, messageSz))
+            break;
+
+        if (s_publish(topic, topicSz, qos, message, messageSz, NULL) != RESULT_CODE_SUCCESS)
+        {
+            if (outbox->retryCnt < UINT8_MAX)
+                outbox->retryCnt++;
+            break;                                                      // record kept, retry after backoff
+        }
+
+        outbox->retryCnt = 0;
+        outbox->readOffset += recordSz;
+    }
+    outbox->lastReplayAt = lMillis();
+
+    if (outbox->readOffset >= outbox->writeOffset)                      // outbox drained, reset file
+    {
+        if (filsys_seek(outbox->fileHandle, 0, fileSeekMode_seekFromBegin) == RESULT_CODE_SUCCESS &&
+            filsys_truncate(outbox->fileHandle) == RESULT_CODE_SUCCESS)
+        {
+            outbox->readOffset = 0;
+            outbox->writeOffset = 0;
+        }
+    }
+}
+
+
+/**
+ *	\brief [private] Walk the outbox record framing from the start of the file, resyncing past corrupt records.
+ * 
+ *  \return File size holding whole records: a torn record (interrupted append) at the end of the file is excluded. If the file 
+ *  can't be read the full size is returned (nothing truncated), replay resyncs past any corrupt record.
+ */
+static uint32_t s_outboxFrame(uint32_t fileSz)
+{
+    char recHdr[MQTT_OUTBOX_RECHDRSZ];
+    uint32_t offset = 0;
+    uint32_t validSz = 0;
+    uint32_t recordSz;
+
+    while (offset < fileSz)
+    {
+        if (!s_outboxReadAt(offset, recHdr, MQTT_OUTBOX_RECHDRSZ))
+            return fileSz;
+        if (s_outboxHdrValid(recHdr, offset, fileSz, &recordSz))
+        {
+            offset += recordSz;
+            validSz = offset;
+        }
+        else if (!s_outboxResync(offset + 1, fileSz, &offset))
+            return fileSz;
+    }
+    return validSz;
+}
+
+
+/**
+ *	\brief [private] Find the next record header following a corrupt record. The file is scanned for the record marker, a 
+ *  candidate header must be valid and be followed by a valid header (or end exactly at endOffset).
+ * 
+ *  \param nextOffset [out] - File offset of next record, endOffset if none.
+ *  \return False if the file could not be read (nextOffset not set).
+ */
+static bool s_outboxResync(uint32_t fromOffset, uint32_t endOffset, uint32_t *nextOffset)
+{
+    char *window = mqttPtr->outbox.replayBuf;
+    char nextHdr[MQTT_OUTBOX_RECHDRSZ];
+    uint32_t recordSz;
+    uint32_t nextSz;
+
+    while (fromOffset + MQTT_OUTBOX_RECHDRSZ <= endOffset)
+    {
+        uint16_t windowSz = MIN(MQTT_TOPIC_SZ + MQTT_OUTBOX_MSG_MAXSZ, endOffset - fromOffset);
+        if (!s_outboxReadAt(fromOffset, window, windowSz))
+            return false;
+
+        for (uint16_t i = 0; i + MQTT_OUTBOX_RECHDRSZ <= windowSz; i++)
+        {
+            if (!s_outboxHdrValid(window + i, fromOffset + i, endOffset, &recordSz))
+                continue;
+
+            uint32_t candidateEnd = fromOffset + i + recordSz;
+            if (candidateEnd == endOffset ||
+                (s_outboxReadAt(candidateEnd, nextHdr, MQTT_OUTBOX_RECHDRSZ) && s_outboxHdrValid(nextHdr, candidateEnd, endOffset, &nextSz)))
+            {
+                *nextOffset = fromOffset + i;
+                return true;
+            }
+        }
+        fromOffset += windowSz - (MQTT_OUTBOX_RECHDRSZ - 1);                        // overlap: header may straddle windows
+    }
+    *nextOffset = endOffset;
+    return true;
+}
+
+
+/**
+ *	\brief [private] Validate an outbox record header (marker, QOS, sizes) and that the record fits before endOffset.
+ */
+static bool s_outboxHdrValid(const char *recHdr, uint32_t offset, uint32_t endOffset, uint32_t *recordSz)
+{
+    uint16_t topicSz = (uint8_t)recHdr[2] | ((uint8_t)recHdr[3] << 8);
+    uint16_t messageSz = (uint8_t)recHdr[4] | ((uint8_t)recHdr[5] << 8);
+
+    *recordSz = MQTT_OUTBOX_RECHDRSZ + topicSz + messageSz;
+    return (uint8_t)recHdr[0] == MQTT_OUTBOX_RECMAGIC &&
+           (uint8_t)recHdr[1] <= mqttQos_2 &&
+           topicSz > 0 && topicSz <= MQTT_TOPIC_SZ && messageSz <= MQTT_OUTBOX_MSG_MAXSZ &&
+           offset + *recordSz <= endOffset;
+}
+
+
+/**
+ *	\brief [private] Read from the outbox file at an offset.
+ */
+static bool s_outboxReadAt(uint32_t offset, char *dest, uint16_t readSz)
+{
+    return filsys_seek(mqttPtr->outbox.fileHandle, offset, fileSeekMode_seekFromBegin) == RESULT_CODE_SUCCESS &&
+           s_outboxRead(dest, readSz);
+}
+
+
+/**
+ *	\brief [private] Read from the outbox file at the current file position.
+ * 
+ *  \return True if readSz bytes were copied to dest.
+ */
+static bool s_outboxRead(char *dest, uint16_t readSz)
+{
+    if (readSz == 0)
+        return true;
+
+    outboxRead.dest = dest;
+    outboxRead.destSz = readSz;
+    outboxRead.filledSz = 0;
+    if (filsys_read(mqttPtr->outbox.fileHandle, readSz) != RESULT_CODE_SUCCESS)
+        return false;
+    return outboxRead.filledSz == readSz;
+}
+
+
+/**
+ *	\brief [private] Filesystem receiver for outbox reads, copies file data out of the command buffer.
+ */
+static void s_outboxRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz)
+{
+    (void)fileHandle;
+    uint16_t copySz = MIN(dataSz, outboxRead.destSz - outboxRead.filledSz);
+    memcpy(outboxRead.dest + outboxRead.filledSz, fileData, copySz);
+    outboxRead.filledSz += copySz;
+}
+
+
 /**
  *	\brief [private] MQTT open status response parser.
  *
@@ -647,7 +1447,7 @@ static resultCode_t s_mqttSubscribeCompleteParser(const char *response, char **e
 
 
 /**
- *	\brief [private] MQTT publish message to topic response parser.
+ *	\brief [private] MQTT publish message to topic response parser. Matches +QMTPUB or +QMTPUBEX result, firmware dependent.
  *
  *  \param response [in] Character data recv'd from BGx to parse for task complete
  *  \param endptr [out] Char pointer to the char following parsed text
@@ -656,7 +1456,13 @@ static resultCode_t s_mqttSubscribeCompleteParser(const char *response, char **e
  */
 static resultCode_t s_mqttPublishCompleteParser(const char *response, char **endptr) 
 {
-    return atcmd_serviceResponseParser(response, "+QMTPUB: ", 2, endptr);
+    char *resultAt = strstr(response, "+QMTPUB");
+    if (resultAt == NULL)
+        return RESULT_CODE_PENDING;
+    resultAt = strchr(resultAt, ':');
+    if (resultAt == NULL)
+        return RESULT_CODE_PENDING;
+    return atcmd_serviceResponseParser(resultAt, ": ", 2, endptr);
 }
 
 
@@ -35,6 +35,7 @@
                                                                     ///< timeout, causes a subsequent msg timeout
 
 #define MQTT_MESSAGE_SZ 1548                                        ///< BGx max publish size
+#define MQTT_PUBLISHBIN_MAXSZ (IOP_TX_BUFFER_SZ - 1)                ///< max length specified publish, message is queued whole in IOP TX buffer
 #define MQTT_TOPIC_OFFSET_MAX 24                                    ///< Number of BGx preamble chars to get to topic
 
 /* MQTT TOPIC
@@ -46,11 +47,29 @@
 #define MQTT_TOPIC_SZ (MQTT_TOPIC_NAME_SZ + MQTT_TOPIC_PROPS_SZ)    ///< Total topic size (name+props) for buffer sizing
 #define MQTT_TOPIC_PUBCMD_OVRHD_SZ 27                               ///< when publishing, number of extra chars in outgoing buffer added to AT cmd
 #define MQTT_TOPIC_PUBBUF_SZ (MQTT_TOPIC_NAME_SZ + MQTT_TOPIC_PROPS_SZ + MQTT_TOPIC_PUBCMD_OVRHD_SZ)
+#define MQTT_PUBLISH_MSGID_DIGITS 5                                 ///< publish handle message ID field width (0-65535, zero filled)
 
 #define MQTT_TOPIC_MAXCNT 2                                         ///< number of slots for MQTT service subscriptions (reduce for mem conservation)
 #define MQTT_SOCKET_ID 5                                            ///< MQTT assigned BGx socket (this is behind-the-scenes and not readily visible)
 #define MQTT_PROPERTIES_CNT 12                                      ///< Azure IoTHub 3-sysProps, 3-props, plus your application
 
+/* MQTT OUTBOX
+ Publishes made while not connected are appended to a file in the BGx filesystem (UFS) and
+ replayed in batches once the connection is restored. Replay is at-least-once: a reset during
+ replay will resend records from the last partially replayed outbox file.
+ ------------------------------------------------------------------*/
+#define MQTT_OUTBOX_MSG_MAXSZ 512                                   ///< max message size for outbox records, sizes the replay buffer
+#define MQTT_OUTBOX_BATCHSZ 4                                       ///< number of outbox records replayed per doWork pass
+#define MQTT_OUTBOX_PACINGml 500                                    ///< millis between outbox replay batches, lets other traffic interleave
+#define MQTT_OUTBOX_BACKOFFMAX 6                                    ///< failed replay doubles pacing per attempt, up to PACING << BACKOFFMAX (records are never dropped)
+
+/* MQTT SUPERVISOR
+ Reconnect backoff doubles from BASE to MAX per failed attempt, actual delay is randomized in the upper half
+ of the backoff window so a fleet of devices doesn't reconnect in lock-step after a broker outage.
+ ------------------------------------------------------------------*/
+#define MQTT_RECONNECT_BASEml 1000                                  ///< initial reconnect backoff
+#define MQTT_RECONNECT_MAXml 120000                                 ///< backoff ceiling
+
 
 /* Example connection strings key/SAS token
   HostName=iothub-dev-pelogical.azure-devices.net;DeviceId=e8fdd7df-2ca2-4b64-95de-031c6b199299;SharedAccessKey=xx0p0kTA/PIUYCzOncQYWwTyzcrcNuXdQXjlKUBdkc0=
@@ -72,20 +91,6 @@ typedef enum mqttResult_tag
     mqttResult_failed = 2           ///< Publish failed.
 } mqttResult_t;
 
-/** 
- *  \brief Enum of available SSL version options for an SSL connection. 
-*/
-typedef enum sslVersion_tag 
-{
-    sslVersion_none = 255,          ///< Not set
-    sslVersion_ssl30 = 0,           ///< Require SSL v3.0 
-    sslVersion_tls10 = 1,           ///< Require TLS v1.0
-    sslVersion_tls11 = 2,           ///< Require TLS v1.1
-    sslVersion_tls12 = 3,           ///< Require TLS v1.2
-    sslVersion_any = 4              ///< Any SSL/TLS version is acceptable.
-} sslVersion_t;
-
-
 /** 
  *  \brief Enum of available MQTT protocol version options.
 */
@@ -142,10 +147,63 @@ typedef struct mqttSubscription_tag
 {
     char topicName[MQTT_TOPIC_NAME_SZ];     ///< Topic name. Note if the topic registered with '#' wildcard, this is removed from the topic name.
     char wildcard;                          ///< Set to '#' if multilevel wildcard specified when subscribing to topic.
+    mqttQos_t qos;                          ///< QOS requested at subscribe, used when the supervisor restores subscriptions.
     mqtt_recvFunc_t receiver_func;          ///< Function to receive incoming messages (event). Note that receiver_func can be unique or shared amongst subscriptions.
 } mqttSubscription_t;
 
 
+/** 
+ *  \brief Struct describing the MQTT outbox (publishes persisted to BGx filesystem while not connected).
+*/
+typedef struct mqttOutbox_tag
+{
+    bool enabled;                           ///< Outbox file is open and publishes will spill to it when not connected.
+    uint16_t fileHandle;                    ///< BGx file handle for the outbox file.
+    uint32_t readOffset;                    ///< File offset of the next record to replay.
+    uint32_t writeOffset;                   ///< File offset for the next record appended (end of file).
+    uint8_t retryCnt;                       ///< Failed replay attempts for the record at readOffset, backs off pacing.
+    uint32_t lastReplayAt;                  ///< Millis of last replay batch, for pacing.
+    char *replayBuf;                        ///< Topic and message buffer for replay (allocated when enabled).
+} mqttOutbox_t;
+
+
+/** 
+ *  \brief Enum of the MQTT connection supervisor states (see mqtt_supervise).
+*/
+typedef enum mqttSupvState_tag
+{
+    mqttSupvState_off = 0,                  ///< Supervisor not enabled, application manages MQTT connection.
+    mqttSupvState_online = 1,               ///< Connected and subscriptions in place, monitoring.
+    mqttSupvState_backoff = 2,              ///< Connection lost, waiting for backoff period to expire.
+    mqttSupvState_open = 3,                 ///< Reconnect step: open server.
+    mqttSupvState_connect = 4,              ///< Reconnect step: connect (authenticate) session.
+    mqttSupvState_subscribe = 5             ///< Reconnect step: restore subscriptions, one per step.
+} mqttSupvState_t;
+
+
+/** 
+ *  \brief Struct describing the MQTT connection supervisor. Connection parameters are captured by mqtt_open() and mqtt_connect().
+ * 
+ *  The string parameters are references, the application must keep them valid while the supervisor is enabled.
+*/
+typedef struct mqttSupervisor_tag
+{
+    mqttSupvState_t state;                  ///< Current supervisor state.
+    const char *host;                       ///< mqtt_open() host.
+    uint16_t port;                          ///< mqtt_open() port.
+    sslVersion_t sslVersion;                ///< mqtt_open() SSL option.
+    mqttVersion_t mqttVersion;              ///< mqtt_open() MQTT protocol version.
+    const char *clientId;                   ///< mqtt_connect() client ID.
+    const char *username;                   ///< mqtt_connect() user name.
+    const char *password;                   ///< mqtt_connect() password.
+    mqttSession_t cleanSession;             ///< mqtt_connect() session option.
+    uint8_t retryCnt;                       ///< Failed reconnect attempts since connection lost, sets backoff period.
+    uint8_t subscrIndx;                     ///< Next subscription table slot to restore.
+    uint32_t backoffStart;                  ///< Millis when the backoff period started.
+    uint32_t backoffPeriod;                 ///< Backoff period (millis) for the current attempt.
+} mqttSupervisor_t;
+
+
 /** 
  *  \brief Struct describing the MQTT service.
 */
@@ -159,11 +217,29 @@ typedef struct mqtt_tag
                                             ///< struct below is populated when recv buffer is complete and ready
     // bool recvComplete;                   ///< set within ISR to signal that EOT phrase recv'd and doWork can process into topic/message and deliv to application
     uint8_t dataBufferIndx;                 ///< index to IOP data buffer holding last completed message (set to IOP_NO_BUF if no recv ready)
+    uint8_t tlsContextId;                   ///< SSL context for the connection (tls manager), held across reconnects for session resumption
+    bool tlsContextAppSet;                  ///< SSL context set by mqtt_setTlsContext(), not assigned from mqtt_open() SSL version
+    mqttOutbox_t outbox;                    ///< Outbox controls, publishes spilled to BGx filesystem while not connected
+    mqttSupervisor_t supervisor;            ///< Connection supervisor, reconnects and restores subscriptions on connection loss
 } mqtt_t;
 
 typedef mqtt_t *mqttPtr_t;
 
 
+/** 
+ *  \brief Struct for a publish handle, the publish command (AT+QMTPUBEX with topic and properties) is formatted once for messages 
+ *  published repeatedly to the same topic. Only the message ID digits are patched for each message.
+*/
+typedef struct mqttPublishHandle_tag
+{
+    mqttQos_t qos;                          ///< QOS for messages published with this handle.
+    uint8_t msgIdOffset;                    ///< Offset of the message ID digits (MQTT_PUBLISH_MSGID_DIGITS, zero filled) in pubCmd.
+    uint8_t topicOffset;                    ///< Offset of the topic in pubCmd.
+    uint16_t topicSz;                       ///< Length of the formatted topic.
+    char pubCmd[MQTT_TOPIC_PUBBUF_SZ];      ///< AT+QMTPUBEX=<tcpconnectID>,<msgID>,<qos>,<retain>,"<topic>, length is appended at send.
+} mqttPublishHandle_t;
+
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -173,14 +249,28 @@ extern "C"
 void mqtt_create();
 
 mqttStatus_t mqtt_status(const char *host, bool force);
+void mqtt_setTlsContext(uint8_t tlsContextId);
 resultCode_t mqtt_open(const char *host, uint16_t port, sslVersion_t useSslVersion, mqttVersion_t useMqttVersion);
 resultCode_t mqtt_connect(const char *clientId, const char *username, const char *password, mqttSession_t cleanSession);
 void mqtt_close();
+resultCode_t mqtt_supervise(bool enable);
 
 
 resultCode_t mqtt_subscribe(const char *topic, mqttQos_t qos, mqtt_recvFunc_t rcvr_func);
 resultCode_t mqtt_unsubscribe(const char *topic);
 resultCode_t mqtt_publish(const char *topic, mqttQos_t qos, const char *message);
+resultCode_t mqtt_publishBin(const char *topic, mqttQos_t qos, const char *data, uint16_t dataSz);
+
+resultCode_t mqtt_publishHandleInit(mqttPublishHandle_t *pubHandle, const char *topic, const char *props, mqttQos_t qos);
+resultCode_t mqtt_publishWithHandle(mqttPublishHandle_t *pubHandle, const char *data, uint16_t dataSz);
+
+resultCode_t mqtt_publishBegin(const char *topic, mqttQos_t qos);
+resultCode_t mqtt_publishAddProp(const char *propKey, const char *propValue);
+resultCode_t mqtt_publishEnd(const char *data, uint16_t dataSz);
+
+resultCode_t mqtt_outboxEnable(const char *fileName);
+void mqtt_outboxDisable();
+uint32_t mqtt_outboxPendingSz();
 
 void mqtt_doWork();
 
@@ -46,7 +46,12 @@
 
 #pragma region Static Local Function Declarations
 static resultCode_t s_contextStatusCompleteParser(const char *response, char **endptr);
-static networkOperator_t s_getNetworkOperator();
+static void s_refreshRegistration();
+static void s_refreshOperator();
+static void s_refreshPdpCntxts();
+static void s_refreshPdpAddress(uint8_t cntxtId);
+static void s_clearPdpCntxt(uint8_t cntxtId);
+static void s_updatePdpPeerMap();
 static char *s_grabToken(char *source, int delimiter, char *tokenBuf, uint8_t tokenBufSz);
 #pragma endregion
 
@@ -67,17 +72,20 @@ void ntwk_create()
 	}
 
     networkPtr->networkOperator = calloc(1, sizeof(networkOperator_t));
-    pdpCntxt_t *context = calloc(BGX_PDPCONTEXT_COUNT, sizeof(pdpCntxt_t));
-	if (context == NULL)
+	if (networkPtr->networkOperator == NULL)
 	{
-        ltem_notifyApp(ltemNotifType_memoryAllocFault, "Could not alloc PDP context struct");
+        ltem_notifyApp(ltemNotifType_memoryAllocFault, "Could not alloc network operator struct");
         free(networkPtr);
 	}
 
-    for (size_t i = 0; i < IOP_SOCKET_COUNT; i++)
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
     {   
         networkPtr->pdpCntxts[i].ipType = pdpCntxtIpType_IPV4;
     }
+    networkPtr->registration.regStatus = ntwkRegStatus_unknown;
+    networkPtr->registration.rat = ntwkRat_unknown;
+    networkPtr->operatorStale = true;                           // no URC history at start (BGx may be registered from warm start)
+    networkPtr->pdpStale = true;
     g_ltem->network = networkPtr;
 }
 
@@ -86,86 +94,98 @@ void ntwk_create()
 /**
  *   \brief Wait for a network operator name and network mode. Can be cancelled in threaded env via g_ltem->cancellationRequest.
  * 
+ *   Registration is signaled by +CEREG URC, the registration status is only polled (AT+CEREG?) on start and at a long interval as a fallback.
+ * 
  *   \param waitDuration [in] Number of seconds to wait for a network. Supply 0 for no wait.
  * 
  *   \return Struct containing the network operator name (operName) and network mode (ntwkMode).
 */
 networkOperator_t ntwk_awaitOperator(uint16_t waitDuration)
 {
-    networkOperator_t ntwk;
-    unsigned long startMillis, endMillis;
+    uint32_t startMillis = lMillis();
+    uint32_t pollAt = startMillis;
+    bool polled = false;
 
-    startMillis = lMillis();
-    waitDuration = waitDuration * 1000;
-    do 
+    while (true)
     {
-        ntwk = s_getNetworkOperator();
-        if (ntwk.operName != 0)
-            break;
-        lDelay(1000);
-        endMillis = lMillis();
-    } while (endMillis - startMillis < waitDuration || g_ltem->cancellationRequest);
-    //       timed out waiting                      || global cancellation
-    return ntwk;
+        if (ntwk_isRegistered())
+        {
+            if (g_ltem->network->operatorStale)
+                s_refreshOperator();
+            if (g_ltem->network->networkOperator->operName[0] != 0)
+                break;
+        }
+        else if (!polled || lTimerExpired(pollAt, NTWK_AWAIT_POLLml))
+        {
+            s_refreshRegistration();
+            pollAt = lMillis();
+            polled = true;
+            continue;                                                   // test registration just read
+        }
+
+        if (lTimerExpired(startMillis, PERIOD_FROM_SECONDS((uint32_t)waitDuration)) || g_ltem->cancellationRequest)
+            break;                                                      // timed out waiting || global cancellation
+        lYield();
+    }
+    return *g_ltem->network->networkOperator;
 }
 
 
 
 /**
- *	\brief Get count of APN active data contexts from BGx.
+ *	\brief Get the network operator (cached), the operator is only read from BGx following a registration change.
  * 
- *  \return Count of active data contexts (BGx max is 3).
+ *  \return Struct containing the network operator name (operName) and network mode (ntwkMode), empty if not registered.
  */
-uint8_t ntwk_getActivePdpCntxtCnt()
+networkOperator_t ntwk_getOperator()
 {
-    #define IP_QIACT_SZ 8
+    if (g_ltem->network->operatorStale && ntwk_isRegistered())
+        s_refreshOperator();
+    return *g_ltem->network->networkOperator;
+}
 
-    atcmd_tryInvokeAdv("AT+QIACT?", ACTION_TIMEOUTml, s_contextStatusCompleteParser);
-    atcmdResult_t atResult = atcmd_awaitResult(false);
 
-    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)         // empty context table return and if success refill from parsing
-    {
-        g_ltem->network->pdpCntxts[i].contextId = 0;
-        g_ltem->network->pdpCntxts[i].ipAddress[0] = 0;
-    }
 
-    if (atResult.statusCode != RESULT_CODE_SUCCESS)
-    {
-        atcmd_close();
-        return 0;
-    }
+/**
+ *	\brief Get the network registration status and serving cell (cached, maintained by +CEREG URC).
+ */
+ntwkRegistration_t ntwk_getRegistration()
+{
+    ntwkRegistration_t registration;
+    memcpy(&registration, (const void *)&g_ltem->network->registration, sizeof(ntwkRegistration_t));
+    return registration;
+}
 
-    uint8_t apnIndx = 0;
-    if (strlen(atResult.response) > IP_QIACT_SZ)
-    {
-        #define TOKEN_BUF_SZ 16
-        char *nextContext;
-        char *landmarkAt;
-        char *continueAt;
-        uint8_t landmarkSz = IP_QIACT_SZ;
-        char tokenBuf[TOKEN_BUF_SZ];
 
-        nextContext = strstr(atResult.response, "+QIACT: ");
 
-        // no contexts returned = none active (only active contexts are returned)
-        while (nextContext != NULL)                             // now parse each pdp context entry
-        {
-            landmarkAt = nextContext;
-            g_ltem->network->pdpCntxts[apnIndx].contextId = strtol(landmarkAt + landmarkSz, &continueAt, 10);
-            continueAt = strchr(++continueAt, ',');             // skip context_state: always 1
-            g_ltem->network->pdpCntxts[apnIndx].ipType = (int)strtol(continueAt + 1, &continueAt, 10);
+/**
+ *	\brief Test for network registration (home or roaming), cached.
+ */
+bool ntwk_isRegistered()
+{
+    ntwkRegStatus_t regStatus = g_ltem->network->registration.regStatus;
+    return regStatus == ntwkRegStatus_home || regStatus == ntwkRegStatus_roaming;
+}
 
-            continueAt = s_grabToken(continueAt + 2, ASCII_cDBLQUOTE, tokenBuf, TOKEN_BUF_SZ);
-            if (continueAt != NULL)
-            {
-                strncpy(g_ltem->network->pdpCntxts[apnIndx].ipAddress, tokenBuf, TOKEN_BUF_SZ);
-            }
-            nextContext = strstr(nextContext + landmarkSz, "+QIACT: ");
-            apnIndx++;
-        }
+
+
+/**
+ *	\brief Get count of APN active data contexts (cached), BGx is only queried if a context was activated since last read.
+ * 
+ *  \return Count of active data contexts (BGx max is 3).
+ */
+uint8_t ntwk_getActivePdpCntxtCnt()
+{
+    if (g_ltem->network->pdpStale)
+        s_refreshPdpCntxts();
+
+    uint8_t activeCnt = 0;
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
+    {
+        if (g_ltem->network->pdpCntxts[i].contextId != 0)
+            activeCnt++;
     }
-    atcmd_close();
-    return apnIndx;
+    return activeCnt;
 }
 
 
@@ -178,9 +198,12 @@ uint8_t ntwk_getActivePdpCntxtCnt()
  */
 pdpCntxt_t *ntwk_getPdpCntxt(uint8_t cntxtId)
 {
+    if (g_ltem->network->pdpStale)
+        s_refreshPdpCntxts();
+
     for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
     {
-        if(g_ltem->network->pdpCntxts[i].contextId != 0)
+        if(g_ltem->network->pdpCntxts[i].contextId == cntxtId)
             return &g_ltem->network->pdpCntxts[i];
     }
     return NULL;
@@ -196,17 +219,95 @@ void ntwk_activatePdpContext(uint8_t cntxtId)
 {
     char atCmd[PROTOCOLS_CMD_BUFFER_SZ] = {0};
 
-    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+QIACT=%d\r", cntxtId);
+    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+QIACT=%d", cntxtId);
     if (atcmd_tryInvokeAdv(atCmd, ACTION_TIMEOUTml, s_contextStatusCompleteParser))
     {
         resultCode_t atResult = atcmd_awaitResult(true).statusCode;
         if ( atResult == RESULT_CODE_SUCCESS)
-            ntwk_getActivePdpCntxtCnt();
+            s_refreshPdpAddress(cntxtId);                           // only this context's address, not the full context table
     }
 }
 
 
 
+/**
+ *	\brief Request activation of a PDP context, returning without waiting for the BGx response (AT+QIACT can take many seconds). 
+ *  The AT command channel is held for at most NTWK_ACTIVATE_HOLDml, after that the activation completes in the BGx and is 
+ *  detected from the +CGEV URC or a context poll; other commands can run meanwhile. Collect the result with ntwk_getActivateResult().
+ * 
+ *  \param cntxtId [in] - The APN number to operate on.
+ * 
+ *  \return 202 if activation requested, 409 if AT action busy or an activation is already in progress.
+ */
+resultCode_t ntwk_activatePdpContextAsync(uint8_t cntxtId)
+{
+    char atCmd[PROTOCOLS_CMD_BUFFER_SZ] = {0};
+
+    if (g_ltem->network->activatingCntxt != 0)
+        return RESULT_CODE_CONFLICT;
+
+    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+QIACT=%d", cntxtId);
+    if (!atcmd_tryInvokeAdv(atCmd, NTWK_ACTIVATE_HOLDml, s_contextStatusCompleteParser))
+        return RESULT_CODE_CONFLICT;
+
+    g_ltem->network->activatingCntxt = cntxtId;
+    g_ltem->network->activateHeld = true;
+    g_ltem->network->activateAt = lMillis();
+    g_ltem->network->activatePolledAt = g_ltem->network->activateAt;
+    return RESULT_CODE_ACCEPTED;
+}
+
+
+/**
+ *	\brief Get the result of an activation requested with ntwk_activatePdpContextAsync(), returns immediately.
+ * 
+ *  While the AT+QIACT action holds the lock its response is checked. Once the hold expires the lock is released and the context 
+ *  table is checked, refreshed when +CGEV reports an activation or every NTWK_ACTIVATE_POLLml, until NTWK_ACTIVATE_TIMEOUTml.
+ * 
+ *  \return 200 if activated, 202 if activation pending, 404 if no activation requested, otherwise error (408 timeout, BGx error).
+ */
+resultCode_t ntwk_getActivateResult()
+{
+    uint8_t cntxtId = g_ltem->network->activatingCntxt;
+    if (cntxtId == 0)
+        return RESULT_CODE_NOTFOUND;
+
+    if (g_ltem->network->activateHeld)
+    {
+        resultCode_t atResult = atcmd_getResult(true).statusCode;          // closes action (releases lock) when complete
+        if (atResult == RESULT_CODE_PENDING)
+            return RESULT_CODE_ACCEPTED;
+
+        g_ltem->network->activateHeld = false;
+        if (atResult != RESULT_CODE_TIMEOUT)                                // BGx responded within hold
+        {
+            g_ltem->network->activatingCntxt = 0;
+            if (atResult == RESULT_CODE_SUCCESS)
+                s_refreshPdpAddress(cntxtId);
+            return atResult;
+        }
+        PRINTF(dbgColor_info, "Activate cntxt=%d released lock, awaiting\r", cntxtId);
+    }
+
+    if (lTimerExpired(g_ltem->network->activatePolledAt, NTWK_ACTIVATE_POLLml) && !g_ltem->atcmd->isOpen)
+    {
+        g_ltem->network->activatePolledAt = lMillis();
+        g_ltem->network->pdpStale = true;                                   // no +CGEV yet, poll
+    }
+    if (ntwk_getPdpCntxt(cntxtId) != NULL)                                  // refreshed if stale (+CGEV PDN ACT or poll)
+    {
+        g_ltem->network->activatingCntxt = 0;
+        return RESULT_CODE_SUCCESS;
+    }
+    if (lTimerExpired(g_ltem->network->activateAt, NTWK_ACTIVATE_TIMEOUTml))
+    {
+        g_ltem->network->activatingCntxt = 0;
+        return RESULT_CODE_TIMEOUT;
+    }
+    return RESULT_CODE_ACCEPTED;
+}
+
+
 /**
  *	\brief Deactivate APN.
  * 
@@ -215,13 +316,13 @@ void ntwk_activatePdpContext(uint8_t cntxtId)
 void ntwk_deactivatePdpContext(uint8_t cntxtId)
 {
     char atCmd[PROTOCOLS_CMD_BUFFER_SZ] = {0};
-    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+QIDEACT=%d\r", cntxtId);
+    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+QIDEACT=%d", cntxtId);
 
     if (atcmd_tryInvokeAdv(atCmd, ACTION_TIMEOUTml, s_contextStatusCompleteParser))
     {
         resultCode_t atResult = atcmd_awaitResult(true).statusCode;
         if ( atResult == RESULT_CODE_SUCCESS)
-            ntwk_getActivePdpContexts();
+            s_clearPdpCntxt(cntxtId);
     }
 }
 
@@ -229,7 +330,7 @@ void ntwk_deactivatePdpContext(uint8_t cntxtId)
 /**
  *	\brief Reset (deactivate/activate) all network APNs.
  *
- *  NOTE: activate and deactivate have side effects, they internally call getActiveContexts prior to return
+ *  NOTE: activate and deactivate have side effects, they update the context table prior to return
  */
 void ntwk_resetPdpContexts()
 {
@@ -250,6 +351,139 @@ void ntwk_resetPdpContexts()
     }
 }
 
+
+
+/**
+ *	\brief Background work for the network cache. Invoked by ltem_doWork().
+ * 
+ *  Notifies the application of network deactivated contexts, refreshes stale values and performs the (long interval) fallback refresh.
+ */
+void ntwk_doWork()
+{
+    if (g_ltem->network->pdpDeactCntxt != 0)
+    {
+        g_ltem->network->pdpDeactCntxt = 0;
+        ltem_notifyApp(ltemNotifType_pdpDeactivate, "Network deactivated PDP context");
+    }
+
+    if (g_ltem->atcmd->isOpen)                                                  // don't contend with application commands
+        return;
+    if (g_ltem->pwrMgmt != NULL && ((pwrMgmt_t *)g_ltem->pwrMgmt)->state != pwrState_awake)
+        return;                                                                 // don't wake BGx for a refresh
+
+    if (lTimerExpired(g_ltem->network->refreshedAt, NTWK_REFRESH_PERIODml))
+    {
+        g_ltem->network->refreshedAt = lMillis();
+        s_refreshRegistration();
+        g_ltem->network->operatorStale = true;
+        g_ltem->network->pdpStale = true;
+    }
+    if (ntwk_isRegistered())
+    {
+        if (g_ltem->network->pdpStale)
+            s_refreshPdpCntxts();
+        else if (g_ltem->network->operatorStale)
+            s_refreshOperator();
+    }
+}
+
+#pragma endregion
+
+
+/* semi-private functions, URC handlers invoked from IOP ISR: update cache only, no AT commands
+ * --------------------------------------------------------------------------------------------- */
+#pragma region semi-private functions
+
+
+/**
+ *	\brief Update registration cache from +CEREG. URC form: <stat>[,"<tac>","<ci>",<AcT>], response (AT+CEREG?) form: <n>,<stat>[,...]
+ * 
+ *  \param regInfo [in] - +CEREG content, following "+CEREG: " 
+ *  \return True if URC (unsolicited), false if response to AT+CEREG? (chunk must remain for the command result).
+ */
+bool ntwk__urcRegistration(const char *regInfo)
+{
+    char *nextAt;
+    bool isUrc = true;
+    ntwkRegStatus_t prevStatus = g_ltem->network->registration.regStatus;
+
+    uint8_t regStatus = (uint8_t)strtol(regInfo, &nextAt, 10);
+    if (*nextAt == ASCII_cCOMMA && nextAt[1] != ASCII_cDBLQUOTE)               // <n>,<stat>
+    {
+        isUrc = false;
+        regStatus = (uint8_t)strtol(nextAt + 1, &nextAt, 10);
+    }
+    g_ltem->network->registration.regStatus = (ntwkRegStatus_t)regStatus;
+
+    if (*nextAt == ASCII_cCOMMA && nextAt[1] == ASCII_cDBLQUOTE)                // location info present
+    {
+        g_ltem->network->registration.tac = (uint16_t)strtol(nextAt + 2, &nextAt, 16);
+        nextAt = strchr(nextAt, ASCII_cCOMMA);
+        if (nextAt != NULL && nextAt[1] == ASCII_cDBLQUOTE)
+        {
+            g_ltem->network->registration.cellId = strtoul(nextAt + 2, &nextAt, 16);
+            nextAt = strchr(nextAt, ASCII_cCOMMA);
+            if (nextAt != NULL)
+                g_ltem->network->registration.rat = (ntwkRat_t)strtol(nextAt + 1, NULL, 10);
+        }
+    }
+
+    if ((ntwkRegStatus_t)regStatus != prevStatus)
+        g_ltem->network->operatorStale = true;
+    return isUrc;
+}
+
+
+/**
+ *	\brief Update PDP context cache from +CGEV (AT+CGEREP=2,1).
+ * 
+ *  \param eventInfo [in] - +CGEV content, following "+CGEV: " 
+ */
+void ntwk__urcEvent(const char *eventInfo)
+{
+    char *cntxtIdAt;
+
+    if (memcmp(eventInfo + 3, "PDN ACT ", 8) == 0)                              // ME|NW PDN ACT <cid>, IP address read later
+    {
+        g_ltem->network->pdpStale = true;
+    }
+    else if ((cntxtIdAt = strstr(eventInfo, "PDN DEACT ")) != NULL)             // ME|NW PDN DEACT <cid>
+    {
+        uint8_t cntxtId = (uint8_t)strtol(cntxtIdAt + 10, NULL, 10);
+        if (memcmp(eventInfo, "NW", 2) == 0)
+            ntwk__urcPdpDeact(cntxtId);
+        else
+            s_clearPdpCntxt(cntxtId);
+    }
+    else if (memcmp(eventInfo + 3, "DETACH", 6) == 0)                           // ME|NW DETACH, all contexts gone
+    {
+        for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
+        {
+            if (g_ltem->network->pdpCntxts[i].contextId != 0)
+                ntwk__urcPdpDeact(g_ltem->network->pdpCntxts[i].contextId);
+        }
+        g_ltem->network->registration.regStatus = ntwkRegStatus_notRegistered;
+        g_ltem->network->operatorStale = true;
+    }
+}
+
+
+/**
+ *	\brief Network deactivated a PDP context (+QIURC: "pdpdeact" or +CGEV NW PDN DEACT), app is notified from ntwk_doWork().
+ */
+void ntwk__urcPdpDeact(uint8_t contextId)
+{
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
+    {
+        if (g_ltem->network->pdpCntxts[i].contextId == contextId)
+        {
+            s_clearPdpCntxt(contextId);
+            g_ltem->network->pdpDeactCntxt = contextId;
+            break;
+        }
+    }
+}
+
 #pragma endregion
 
 
@@ -271,14 +505,24 @@ static resultCode_t s_contextStatusCompleteParser(const char *response, char **e
 
 
 /**
- *   \brief Get the network operator name and network mode.
- * 
- *   \return Struct containing the network operator name (operName) and network mode (ntwkMode).
+ *   \brief Query registration (AT+CEREG?), the response is cached by the IOP URC handler as it is received.
 */
-static networkOperator_t s_getNetworkOperator()
+static void s_refreshRegistration()
 {
-    if (*g_ltem->network->networkOperator->operName != 0)
-        return *g_ltem->network->networkOperator;
+    if (atcmd_tryInvoke("AT+CEREG?"))
+        atcmd_awaitResult(true);
+}
+
+
+
+/**
+ *   \brief Read the network operator name and network mode into the cache.
+*/
+static void s_refreshOperator()
+{
+    g_ltem->network->operatorStale = false;
+    g_ltem->network->networkOperator->operName[0] = 0;
+    g_ltem->network->networkOperator->ntwkMode[0] = 0;
 
     if (atcmd_tryInvoke("AT+COPS?"))
     {
@@ -292,22 +536,149 @@ static networkOperator_t s_getNetworkOperator()
             {
                 continueAt = s_grabToken(continueAt + 1, ASCII_cDBLQUOTE, g_ltem->network->networkOperator->operName, NTWKOPERATOR_OPERNAME_SZ);
                 ntwkMode = (uint8_t)strtol(continueAt + 1, &continueAt, 10);
-                if (ntwkMode == 8)
+                if (ntwkMode == ntwkRat_catM1)
                     strcpy(g_ltem->network->networkOperator->ntwkMode, "CAT-M1");
                 else
                     strcpy(g_ltem->network->networkOperator->ntwkMode, "CAT-NB1");
             }
         }
         else
+            g_ltem->network->operatorStale = true;
+        atcmd_close();
+    }
+}
+
+
+
+/**
+ *   \brief Read all active contexts (AT+QIACT?) into the cache.
+*/
+static void s_refreshPdpCntxts()
+{
+    #define IP_QIACT_SZ 8
+
+    if (!atcmd_tryInvokeAdv("AT+QIACT?", ACTION_TIMEOUTml, s_contextStatusCompleteParser))
+        return;
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+    {
+        atcmd_close();
+        return;
+    }
+
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)         // success: empty context table and refill from parsing
+    {
+        g_ltem->network->pdpCntxts[i].contextId = 0;
+        g_ltem->network->pdpCntxts[i].ipAddress[0] = 0;
+    }
+
+    uint8_t apnIndx = 0;
+    if (strlen(atResult.response) > IP_QIACT_SZ)
+    {
+        #define TOKEN_BUF_SZ 16
+        char *nextContext;
+        char *landmarkAt;
+        char *continueAt;
+        uint8_t landmarkSz = IP_QIACT_SZ;
+        char tokenBuf[TOKEN_BUF_SZ];
+
+        nextContext = strstr(atResult.response, "+QIACT: ");
+
+        // no contexts returned = none active (only active contexts are returned)
+        while (nextContext != NULL && apnIndx < BGX_PDPCONTEXT_COUNT)      // now parse each pdp context entry
         {
-            g_ltem->network->networkOperator->operName[0] = 0;
-            g_ltem->network->networkOperator->ntwkMode[0] = 0;
+            landmarkAt = nextContext;
+            g_ltem->network->pdpCntxts[apnIndx].contextId = strtol(landmarkAt + landmarkSz, &continueAt, 10);
+            continueAt = strchr(++continueAt, ',');             // skip context_state: always 1
+            g_ltem->network->pdpCntxts[apnIndx].ipType = (int)strtol(continueAt + 1, &continueAt, 10);
+
+            continueAt = s_grabToken(continueAt + 2, ASCII_cDBLQUOTE, tokenBuf, TOKEN_BUF_SZ);
+            if (continueAt != NULL)
+            {
+                strncpy(g_ltem->network->pdpCntxts[apnIndx].ipAddress, tokenBuf, PDPCONTEXT_IPADDRESS_SZ);
+            }
+            nextContext = strstr(nextContext + landmarkSz, "+QIACT: ");
+            apnIndx++;
         }
     }
     atcmd_close();
-    return *g_ltem->network->networkOperator;
+    g_ltem->network->pdpStale = false;
+    s_updatePdpPeerMap();
+}
+
+
+
+/**
+ *   \brief Read the address of a single (just activated) context (AT+CGPADDR=<cid>) into the cache.
+*/
+static void s_refreshPdpAddress(uint8_t cntxtId)
+{
+    char atCmd[PROTOCOLS_CMD_BUFFER_SZ];
+    snprintf(atCmd, PROTOCOLS_CMD_BUFFER_SZ, "AT+CGPADDR=%d", cntxtId);
+
+    if (!atcmd_tryInvoke(atCmd))
+        return;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);
+    char *addressAt = strstr(atResult.response, "+CGPADDR: ");
+    if (atResult.statusCode == RESULT_CODE_SUCCESS && addressAt != NULL && (addressAt = strchr(addressAt, ASCII_cCOMMA)) != NULL)
+    {
+        pdpCntxt_t *cntxt = NULL;
+        for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)                      // existing entry for context, or first free
+        {
+            if (g_ltem->network->pdpCntxts[i].contextId == cntxtId)
+            {
+                cntxt = &g_ltem->network->pdpCntxts[i];
+                break;
+            }
+            if (cntxt == NULL && g_ltem->network->pdpCntxts[i].contextId == 0)
+                cntxt = &g_ltem->network->pdpCntxts[i];
+        }
+        if (cntxt != NULL)
+        {
+            bool quoted = addressAt[1] == ASCII_cDBLQUOTE;                      // address may be quoted
+            cntxt->contextId = cntxtId;
+            cntxt->ipType = pdpCntxtIpType_IPV4;
+            atcmd_strToken(addressAt + (quoted ? 2 : 1), quoted ? ASCII_cDBLQUOTE : ASCII_cCR, cntxt->ipAddress, PDPCONTEXT_IPADDRESS_SZ);
+        }
+    }
+    atcmd_close();
+    s_updatePdpPeerMap();
 }
 
+
+
+static void s_clearPdpCntxt(uint8_t cntxtId)
+{
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
+    {
+        if (g_ltem->network->pdpCntxts[i].contextId == cntxtId)
+        {
+            g_ltem->network->pdpCntxts[i].contextId = 0;
+            g_ltem->network->pdpCntxts[i].ipAddress[0] = 0;
+        }
+    }
+    s_updatePdpPeerMap();
+}
+
+
+
+/**
+ *   \brief Sync IOP peer map with active contexts, enables IOP scanning for context URCs.
+*/
+static void s_updatePdpPeerMap()
+{
+    uint8_t cntxtMap = 0;
+    for (size_t i = 0; i < BGX_PDPCONTEXT_COUNT; i++)
+    {
+        if (g_ltem->network->pdpCntxts[i].contextId != 0)
+            cntxtMap |= 0x01 << i;
+    }
+    g_ltem->iop->peerTypeMap.pdpContext = cntxtMap;
+}
+
+
 /**
  *  \brief Scans a C-String (char array) for the next delimeted token and null terminates it.
  * 
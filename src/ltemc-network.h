@@ -37,16 +37,17 @@
 /** 
  *  \brief Enum of protocols available on the modem. 
  * 
- *  Note: all of the protocols are clients, while the BGx line of modules support server mode the network carriers generally don't
+ *  Note: service protocols (UDP service, TCP listener) need a network path to the device: carrier premium plans, VPNs or local 
+ *  (private APN) networks. Service sockets are opened with sckt_openService().
 */
 typedef enum protocol_tag
 {
     protocol_tcp = 0x00,                ///< TCP client.
     protocol_udp = 0x01,                ///< UDP client.
-    //protocol_tcpListener = 0x02,
-    //protocol_udpService = 0x03,
     protocol_ssl = 0x02,                ///< SSL client.
-    protocol_AnyIP = 0x02,              ///< special value that includes any of the above IP basic transport protocols.
+    protocol_udpService = 0x03,         ///< UDP service, datagrams from\to any remote peer.
+    protocol_tcpListener = 0x04,        ///< TCP listener, accepts incoming connections.
+    protocol_AnyIP = 0x04,              ///< special value that includes any of the above IP basic transport protocols.
 
     protocol_http = 0x20,               ///< HTTP client.
     protocol_https = 0x21,              ///< HTTPS client, HTTP over SSL.
@@ -104,13 +105,70 @@ typedef struct pdpCntxt_tag
 } pdpCntxt_t;
 
 
+/** 
+ *  \brief Enum of network registration status (3GPP 27.007 +CEREG <stat>).
+*/
+typedef enum ntwkRegStatus_tag
+{
+    ntwkRegStatus_notRegistered = 0,    ///< Not registered, not searching.
+    ntwkRegStatus_home = 1,             ///< Registered, home network.
+    ntwkRegStatus_searching = 2,        ///< Not registered, searching for an operator.
+    ntwkRegStatus_denied = 3,           ///< Registration denied.
+    ntwkRegStatus_unknown = 4,          ///< Unknown (ex: out of coverage), also the state prior to first report.
+    ntwkRegStatus_roaming = 5           ///< Registered, roaming.
+} ntwkRegStatus_t;
+
+
+/** 
+ *  \brief Enum of the radio access technology (3GPP 27.007 +CEREG/+COPS <AcT>).
+*/
+typedef enum ntwkRat_tag
+{
+    ntwkRat_gsm = 0,                    ///< GSM (2G fallback)
+    ntwkRat_catM1 = 8,                  ///< LTE CAT-M1
+    ntwkRat_nbIot = 9,                  ///< LTE NB-IoT
+    ntwkRat_unknown = 255
+} ntwkRat_t;
+
+
+/** 
+ *  \brief Struct representing the network registration and serving cell, maintained from +CEREG URCs.
+*/
+typedef struct ntwkRegistration_tag
+{
+    ntwkRegStatus_t regStatus;          ///< Registration status
+    ntwkRat_t rat;                      ///< Access technology of the serving cell
+    uint16_t tac;                       ///< Tracking area code
+    uint32_t cellId;                    ///< E-UTRAN cell ID (28 bits)
+} ntwkRegistration_t;
+
+
+#define NTWK_REFRESH_PERIODml   600000U ///< fallback (polling) refresh of network state, normally maintained by URCs
+#define NTWK_AWAIT_POLLml       15000U  ///< fallback registration poll while awaiting operator
+#define NTWK_ACTIVATE_TIMEOUTml 30000U  ///< async PDP context activation (AT+QIACT) overall timeout
+#define NTWK_ACTIVATE_HOLDml    3000U   ///< async activation holds the AT action lock this long, then waits on URC/polled context state
+#define NTWK_ACTIVATE_POLLml    5000U   ///< async activation context poll (AT+QIACT?) after the lock is released, if no +CGEV URC
+
+
 /** 
  *  \brief Struct representing the full connectivity with a connected network carrier.
+ * 
+ *  Network state is a cache maintained by URCs (+CEREG, +CGEV, +QIURC: "pdpdeact") in the IOP ISR, reads do not generate AT traffic.
+ *  Values the URCs don't carry (operator name, PDP IP addresses) are flagged stale and refreshed by ntwk_doWork() or on first read.
 */
 typedef struct network_tag
 {
     networkOperator_t *networkOperator;             ///< Network operator name and protocol
-    pdpCntxt_t pdpCntxts[BGX_PDPCONTEXT_COUNT];   ///< Collection of contexts with network carrier. This is typically only 1, but some carriers implement more (ex VZW).
+    pdpCntxt_t pdpCntxts[BGX_PDPCONTEXT_COUNT];     ///< Collection of contexts with network carrier. This is typically only 1, but some carriers implement more (ex VZW).
+    volatile ntwkRegistration_t registration;       ///< Registration status and serving cell
+    volatile bool operatorStale;                    ///< Registration changed since operator was read
+    volatile bool pdpStale;                         ///< PDP context activated (URC), IP address not yet read
+    volatile uint8_t pdpDeactCntxt;                 ///< Context deactivated by network (URC), pending app notification (0=none)
+    uint32_t refreshedAt;                           ///< Time (millis) of last fallback refresh
+    uint8_t activatingCntxt;                        ///< Context with async activation in progress (0=none)
+    bool activateHeld;                              ///< Async activation AT+QIACT action still holds the AT action lock
+    uint32_t activateAt;                            ///< Time (millis) async activation was requested
+    uint32_t activatePolledAt;                      ///< Time (millis) of last context poll while awaiting async activation
 } network_t;
 
 
@@ -123,14 +181,26 @@ extern "C"
 void ntwk_create();
 
 networkOperator_t ntwk_awaitOperator(uint16_t waitDuration);
+networkOperator_t ntwk_getOperator();
+ntwkRegistration_t ntwk_getRegistration();
+bool ntwk_isRegistered();
 uint8_t ntwk_getActivePdpCntxtCnt();
 void ntwk_configPdpCntxt(uint8_t contxtId, pdpCntxtIpType_t ipType, const char *userId, const char *pw, pdpCntxtAuthMethods_t authMethod);
 pdpCntxt_t *ntwk_getPdpCntxt(uint8_t contxtId);
 
 void ntwk_activatePdpContext(uint8_t contxtId);
+resultCode_t ntwk_activatePdpContextAsync(uint8_t contxtId);
+resultCode_t ntwk_getActivateResult();
 void ntwk_deactivatePdpContext(uint8_t contxtId);
 void ntwk_resetPdpContexts();
 
+void ntwk_doWork();
+
+// semi-private functions, URC handlers invoked by IOP (ISR context)
+bool ntwk__urcRegistration(const char *regInfo);
+void ntwk__urcEvent(const char *eventInfo);
+void ntwk__urcPdpDeact(uint8_t contextId);
+
 
 #ifdef __cplusplus
 }
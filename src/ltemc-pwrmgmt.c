@@ -0,0 +1,407 @@
+/******************************************************************************
+ *  \file ltemc-pwrmgmt.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ ******************************************************************************
+ * Power management for BGx family: PSM (power saving mode) and eDRX timers,
+ * BGx sleep\wake tracking and host MCU sleep coordination.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-pwrmgmt.h"
+
+#define PWR_TIMER_UNITSHIFT 5
+#define PWR_TIMER_VALUEMAX 31
+#define PWR_EDRX_CYCLECNT 16
+
+/* 3GPP 24.008 GPRS timer units: bits 8-6 of the timer octet, bits 5-1 are the unit multiplier (0-31)
+ * --------------------------------------------------------------------------------------------- */
+typedef struct pwrTimerUnit_tag
+{
+    uint8_t unitBits;
+    uint32_t unitSeconds;
+} pwrTimerUnit_t;
+
+// T3412 extended (periodic TAU), GPRS Timer 3; ordered by unit size
+static const pwrTimerUnit_t s_t3412Units[] = { {3, 2}, {4, 30}, {5, 60}, {0, 600}, {1, 3600}, {2, 36000}, {6, 1152000} };
+// T3324 (active time), GPRS Timer 2; ordered by unit size
+static const pwrTimerUnit_t s_t3324Units[] = { {0, 2}, {1, 60}, {2, 360} };
+// eDRX cycle lengths (E-UTRAN) in milliseconds, indexed by the 4 bit eDRX value
+static const uint32_t s_edrxCycles[PWR_EDRX_CYCLECNT] = { 5120, 10240, 20480, 40960, 61440, 81920, 102400, 122880, 
+                                                          143360, 163840, 327680, 655360, 1310720, 2621440, 5242880, 10485760 };
+
+static pwrMgmt_t *pwrPtr;
+
+
+// private local declarations
+static uint8_t s_encodeTimer(const pwrTimerUnit_t *units, uint8_t unitCnt, uint32_t seconds);
+static void s_toBinaryStr(uint8_t value, uint8_t bitCnt, char *binaryStr);
+static void s_setAwake();
+static void s_ringIsr();
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Create the power manager and register with LTEmC, AT commands will wake the BGx from PSM as needed.
+ */
+void pwr_create()
+{
+    pwrPtr = calloc(1, sizeof(pwrMgmt_t));
+	if (pwrPtr == NULL)
+	{
+        ltem_notifyApp(ltemNotifType_memoryAllocFault,  "pwrmgmt-could not alloc power manager struct");
+	}
+    pwrPtr->state = pwrState_awake;
+
+    g_ltem->pwrMgmt = pwrPtr;
+    g_ltem->pwrWork_func = &pwr_doWork;
+    g_ltem->pwrWake_func = &pwr_wake;                                     // invoked by AT command invoke before sending
+
+    if (g_ltem->pinConfig.ringUrcPin != 0)                                      // RI (ring) signal is optional
+    {
+        gpio_openPin(g_ltem->pinConfig.ringUrcPin, gpioMode_inputPullUp);
+        gpio_attachIsr(g_ltem->pinConfig.ringUrcPin, true, gpioIrqTriggerOn_falling, s_ringIsr);
+    }
+}
+
+
+
+/**
+ *	\brief Configure PSM (power saving mode) timers, AT+CPSMS. The network may grant values different from those requested.
+ *
+ *  \param enable [in] - Request (true) or cancel (false) PSM.
+ *  \param tauSeconds [in] - Requested periodic TAU (T3412), BGx wakes at this interval to update the network.
+ *  \param activeSeconds [in] - Requested active time (T3324), BGx stays reachable (idle) for this period before entering PSM.
+ *
+ *  \return Result code representing status of operation, OK = 200.
+ */
+resultCode_t pwr_setPsm(bool enable, uint32_t tauSeconds, uint32_t activeSeconds)
+{
+    char atCmd[PWR_CMD_SZ];
+    char tauStr[PWR_TIMERSTR_SZ];
+    char activeStr[PWR_TIMERSTR_SZ];
+
+    if (enable)
+    {
+        s_toBinaryStr(pwr__encodeT3412(tauSeconds), 8, tauStr);
+        s_toBinaryStr(pwr__encodeT3324(activeSeconds), 8, activeStr);
+        snprintf(atCmd, PWR_CMD_SZ, "AT+CPSMS=1,,,\"%s\",\"%s\"", tauStr, activeStr);
+    }
+    else
+        strcpy(atCmd, "AT+CPSMS=0");
+
+    if (!atcmd_tryInvoke(atCmd))
+        return RESULT_CODE_CONFLICT;
+
+    resultCode_t rslt = atcmd_awaitResult(true).statusCode;
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        pwrPtr->psmEnabled = enable;
+        pwrPtr->psmTau = enable ? tauSeconds : 0;
+        pwrPtr->psmActiveTime = enable ? activeSeconds : 0;
+    }
+    return rslt;
+}
+
+
+
+/**
+ *	\brief Configure eDRX (extended discontinuous reception), AT+CEDRXS. The network may grant a cycle different from that requested.
+ *
+ *  \param enable [in] - Request (true) or cancel (false) eDRX.
+ *  \param actType [in] - Access technology the setting applies to.
+ *  \param cycleMillis [in] - Requested eDRX cycle, rounded up to the next cycle supported (5.12 to 10485.76 seconds).
+ *
+ *  \return Result code representing status of operation, OK = 200.
+ */
+resultCode_t pwr_setEdrx(bool enable, pwrEdrxAct_t actType, uint32_t cycleMillis)
+{
+    char atCmd[PWR_CMD_SZ];
+    char cycleStr[PWR_TIMERSTR_SZ];
+
+    if (enable)
+    {
+        s_toBinaryStr(pwr__encodeEdrx(cycleMillis), 4, cycleStr);
+        snprintf(atCmd, PWR_CMD_SZ, "AT+CEDRXS=1,%d,\"%s\"", actType, cycleStr);
+    }
+    else
+        snprintf(atCmd, PWR_CMD_SZ, "AT+CEDRXS=0,%d", actType);
+
+    if (!atcmd_tryInvoke(atCmd))
+        return RESULT_CODE_CONFLICT;
+
+    resultCode_t rslt = atcmd_awaitResult(true).statusCode;
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        pwrPtr->edrxEnabled = enable;
+        pwrPtr->edrxCycle = enable ? s_edrxCycles[pwr__encodeEdrx(cycleMillis)] : 0;
+    }
+    return rslt;
+}
+
+
+
+/**
+ *	\brief Get the BGx power (sleep\wake) state.
+ */
+pwrState_t pwr_getState()
+{
+    return pwrPtr->state;
+}
+
+
+
+/**
+ *	\brief Wake the BGx from PSM. Invoked automatically by AT command invoke, does not wait for the BGx.
+ *
+ *  If the BGx is in PSM the power key pulse is started and false returned (the command is not sent, as if the action lock was 
+ *  busy), pwr_doWork() completes the wake. Commands are accepted again once the BGx signals APP RDY.
+ *
+ *  \return True if BGx is awake.
+ */
+bool pwr_wake()
+{
+    if (pwrPtr->state == pwrState_awake)
+    {
+        if (!pwrPtr->psmEnabled || ltem_chkHwReady())
+            return true;
+        pwrPtr->state = pwrState_psmSleep;                                  // entered PSM, not yet seen by pwr_doWork()
+    }
+
+    if (pwrPtr->state == pwrState_psmSleep)
+    {
+        PRINTF(dbgColor_none, "Waking BGx from PSM\r");
+        pwrPtr->state = pwrState_waking;
+        pwrPtr->wakeAt = lMillis();
+        pwrPtr->wakePulse = true;
+        gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_high);      // power key pulse exits PSM, released by pwr_doWork()
+    }
+    return false;
+}
+
+
+
+/**
+ *	\brief Test if host MCU can safely enter deep sleep. 
+ *
+ *  Wake sources for the host are the BGx RI (ring) signal and the LTEm IRQ (SPI-UART bridge), 
+ *  the application is also notified of PSM entry\exit (ltemNotifType_psmEnter\ltemNotifType_psmExit).
+ *
+ *  \return True if BGx is in PSM, or eDRX is enabled and BGx is idle (no AT command or URC in progress).
+ */
+bool pwr_canSleep()
+{
+    if (pwrPtr == NULL || g_ltem->atcmd->isOpen)
+        return false;
+
+    if (pwrPtr->ringPending)
+    {
+        if (!lTimerExpired(pwrPtr->ringAt, PWR_RING_HOLDml))
+            return false;
+        pwrPtr->ringPending = false;
+    }
+
+    if (pwrPtr->state == pwrState_psmSleep)
+        return true;
+    return pwrPtr->state == pwrState_awake && pwrPtr->edrxEnabled;
+}
+
+
+
+/**
+ *	\brief Background work, tracks BGx sleep\wake from the status signal. Invoked by ltem_doWork().
+ *
+ *  Status low is expected when PSM is enabled, otherwise it is reported to the application as hwNotReady.
+ */
+void pwr_doWork()
+{
+    bool hwReady = ltem_chkHwReady();
+
+    switch (pwrPtr->state)
+    {
+        case pwrState_awake:
+            if (pwrPtr->sessionPending && hwReady && !g_ltem->atcmd->isOpen &&
+                (pwrPtr->sessionTriedAt == 0 || lTimerExpired(pwrPtr->sessionTriedAt, PWR_SESSION_RETRYml)))
+            {
+                pwrPtr->sessionTriedAt = lMillis();
+                resultCode_t rslt = qbg__sendSessionCmds();                     // +CEREG\+CGEV reporting is not retained in PSM
+                pwrPtr->sessionPending = (rslt != RESULT_CODE_SUCCESS);
+                if (rslt != RESULT_CODE_SUCCESS)
+                    PRINTF(dbgColor_warn, "PSM exit session restore=%d\r", rslt);
+            }
+            if (!hwReady)
+            {
+                if (!pwrPtr->psmEnabled)
+                {
+                    ltem_notifyApp(ltemNotifType_hwNotReady, "LTEm1 I/O Error");
+                    break;
+                }
+                PRINTF(dbgColor_info, "BGx entered PSM\r");
+                pwrPtr->state = pwrState_psmSleep;
+                ltem_notifyApp(ltemNotifType_psmEnter, "BGx entered PSM");
+            }
+            break;
+
+        case pwrState_psmSleep:
+            if (hwReady)                                                        // BGx woke on its own (TAU timer or mobile originated)
+                pwrPtr->state = pwrState_waking;
+            break;
+
+        case pwrState_waking:
+            if (pwrPtr->wakePulse && lTimerExpired(pwrPtr->wakeAt, QBG_POWERON_DELAY))
+            {
+                gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_low);
+                pwrPtr->wakePulse = false;
+            }
+            if (g_ltem->qbgReadyState == qbg_readyState_appReady)               // status edge then APP RDY (signaled by ISRs)
+                s_setAwake();
+            else if (!pwrPtr->wakePulse && lTimerExpired(pwrPtr->wakeAt, QBG_STATUS_MILLISMAX + QBG_APPREADY_MILLISMAX))
+            {
+                PRINTF(dbgColor_warn, "BGx PSM wake failed\r");
+                pwrPtr->wakeAt = 0;
+                pwrPtr->state = pwrState_psmSleep;                              // next AT command retries wake
+            }
+            break;
+    }
+}
+
+
+
+/**
+ *	\brief Encode a periodic TAU (T3412 extended) value. The value is rounded up to the next representable value.
+ *
+ *  \param seconds [in] - Requested TAU period in seconds.
+ *  \return GPRS Timer 3 octet (3GPP 24.008).
+ */
+uint8_t pwr__encodeT3412(uint32_t seconds)
+{
+    return s_encodeTimer(s_t3412Units, sizeof(s_t3412Units) / sizeof(pwrTimerUnit_t), seconds);
+}
+
+
+
+/**
+ *	\brief Encode an active time (T3324) value. The value is rounded up to the next representable value.
+ *
+ *  \param seconds [in] - Requested active time in seconds.
+ *  \return GPRS Timer 2 octet (3GPP 24.008).
+ */
+uint8_t pwr__encodeT3324(uint32_t seconds)
+{
+    return s_encodeTimer(s_t3324Units, sizeof(s_t3324Units) / sizeof(pwrTimerUnit_t), seconds);
+}
+
+
+
+/**
+ *	\brief Encode an eDRX cycle length, the shortest cycle not less than requested.
+ *
+ *  \param cycleMillis [in] - Requested eDRX cycle in milliseconds.
+ *  \return 4 bit eDRX value (3GPP 24.008).
+ */
+uint8_t pwr__encodeEdrx(uint32_t cycleMillis)
+{
+    for (uint8_t i = 0; i < PWR_EDRX_CYCLECNT; i++)
+    {
+        if (s_edrxCycles[i] >= cycleMillis)
+            return i;
+    }
+    return PWR_EDRX_CYCLECNT - 1;
+}
+
+
+#pragma endregion
+
+
+/* private functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief Encode GPRS timer: the smallest unit able to represent the value (rounded up) in 5 bits.
+ */
+static uint8_t s_encodeTimer(const pwrTimerUnit_t *units, uint8_t unitCnt, uint32_t seconds)
+{
+    for (uint8_t i = 0; i < unitCnt; i++)
+    {
+        uint32_t multiplier = (seconds + units[i].unitSeconds - 1) / units[i].unitSeconds;
+        if (multiplier <= PWR_TIMER_VALUEMAX)
+            return (units[i].unitBits << PWR_TIMER_UNITSHIFT) | multiplier;
+    }
+    return (units[unitCnt - 1].unitBits << PWR_TIMER_UNITSHIFT) | PWR_TIMER_VALUEMAX;      // saturate at max representable
+}
+
+
+static void s_toBinaryStr(uint8_t value, uint8_t bitCnt, char *binaryStr)
+{
+    for (uint8_t i = 0; i < bitCnt; i++)
+    {
+        binaryStr[i] = (value & (1 << (bitCnt - 1 - i))) ? '1' : '0';
+    }
+    binaryStr[bitCnt] = ASCII_cNULL;
+}
+
+
+/**
+ *	\brief BGx exited PSM. Session settings are restored by pwr_doWork(), TLS contexts are reconfigured on next acquire.
+ */
+static void s_setAwake()
+{
+    pwrPtr->state = pwrState_awake;
+    pwrPtr->wakeAt = 0;
+    pwrPtr->sessionPending = true;
+    pwrPtr->sessionTriedAt = 0;
+    tls__resetContexts();                                                   // BGx SSL configuration is not retained in PSM
+    ltem_notifyApp(ltemNotifType_psmExit, "BGx exited PSM");
+}
+
+
+/**
+ *	\brief RI (ring) signal ISR, BGx is signaling an inbound URC.
+ */
+static void s_ringIsr()
+{
+    pwrPtr->ringPending = true;
+    pwrPtr->ringAt = lMillis();
+}
+
+#pragma endregion
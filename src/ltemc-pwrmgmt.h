@@ -0,0 +1,107 @@
+/******************************************************************************
+ *  \file ltemc-pwrmgmt.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ ******************************************************************************
+ * Power management for BGx family: PSM (power saving mode) and eDRX timers,
+ * BGx sleep\wake tracking and host MCU sleep coordination.
+ *****************************************************************************/
+
+#ifndef __LTEMC_PWRMGMT_H__
+#define __LTEMC_PWRMGMT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWR_RING_HOLDml      1000U          ///< host MCU sleep deferred for this period following a RI (ring) signal, allows URC processing
+#define PWR_SESSION_RETRYml  5000U          ///< retry period for restoring the BGx session settings after PSM exit
+#define PWR_CMD_SZ           48
+#define PWR_TIMERSTR_SZ      9              ///< 8 bit binary string + \0
+
+
+/** 
+ *  \brief Enum describing the BGx power state as tracked by the power manager.
+*/
+typedef enum pwrState_tag
+{
+    pwrState_awake = 0,                 ///< BGx awake, able to accept AT commands.
+    pwrState_psmSleep = 1,              ///< BGx in PSM, status low (expected). BGx is woken transparently for next AT command.
+    pwrState_waking = 2                 ///< BGx leaving PSM (wake requested or TAU timer), waiting for BGx APP RDY.
+} pwrState_t;
+
+
+/** 
+ *  \brief Enum of the access technology for eDRX settings (3GPP 27.007 AT+CEDRXS <AcT-type>).
+*/
+typedef enum pwrEdrxAct_tag
+{
+    pwrEdrxAct_catM1 = 4,               ///< E-UTRAN (WB-S1 mode), LTE CAT-M1
+    pwrEdrxAct_nbIot = 5                ///< E-UTRAN (NB-S1 mode), NB-IoT
+} pwrEdrxAct_t;
+
+
+/** 
+ *  \brief Struct for the power manager state.
+*/
+typedef struct pwrMgmt_tag
+{
+    volatile pwrState_t state;          ///< BGx sleep\wake state
+    bool psmEnabled;                    ///< PSM requested (AT+CPSMS), status low is expected following T3324 (active time)
+    bool edrxEnabled;                   ///< eDRX requested (AT+CEDRXS)
+    uint32_t psmTau;                    ///< Requested periodic TAU (T3412) in seconds
+    uint32_t psmActiveTime;             ///< Requested active time (T3324) in seconds
+    uint32_t edrxCycle;                 ///< Requested eDRX cycle in milliseconds
+    volatile bool ringPending;          ///< RI (ring) signaled, URC inbound
+    volatile uint32_t ringAt;           ///< Time (millis) of last RI signal
+    uint32_t wakeAt;                    ///< Time (millis) wake requested (power key pulse), 0 if BGx woke on its own
+    bool wakePulse;                     ///< Power key held for wake pulse, released by pwr_doWork()
+    bool sessionPending;                ///< BGx exited PSM, session settings (qbg__sendSessionCmds) not yet restored
+    uint32_t sessionTriedAt;            ///< Time (millis) of last session restore attempt
+} pwrMgmt_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void pwr_create();
+
+resultCode_t pwr_setPsm(bool enable, uint32_t tauSeconds, uint32_t activeSeconds);
+resultCode_t pwr_setEdrx(bool enable, pwrEdrxAct_t actType, uint32_t cycleMillis);
+
+pwrState_t pwr_getState();
+bool pwr_wake();
+bool pwr_canSleep();
+
+void pwr_doWork();
+
+// semi-private functions, not intended for most application but not static for special needs
+uint8_t pwr__encodeT3412(uint32_t seconds);
+uint8_t pwr__encodeT3324(uint32_t seconds);
+uint8_t pwr__encodeEdrx(uint32_t cycleMillis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_PWRMGMT_H__
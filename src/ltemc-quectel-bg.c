@@ -41,16 +41,47 @@
 
 #include "ltemc.h"
 
-#define BG96_INIT_COMMAND_COUNT 1
+#define QBG_CFGFILE_NAMESZ 24                ///< ltemc_{fingerprint}.cfg
+#define QBG_CFGFILE_PATTERN "ltemc_*.cfg"
+#define QBG_CFGFILE_STALEMAX 4                ///< max number of stale fingerprint files removed at a config update
+#define QBG_CMDSZ 48
+#define FNV1A_OFFSET 2166136261u
+#define FNV1A_PRIME 16777619u
+
+/* BGx init commands. Settings must persist in the BGx, either saved by AT&W (user profile) or self-saving (ex: AT+QCFG).
+ * The list is fingerprinted, the full sequence is only sent when the fingerprint stored in BGx filesystem doesn't match.
+ */
 const char* const qbg_initCmds[] = 
 { 
     "ATE0",             // don't echo AT commands on serial
 };
+#define QBG_INITCMD_CNT (sizeof(qbg_initCmds) / sizeof(qbg_initCmds[0]))
+
+/* BGx session commands. Settings not retained across a BGx power cycle (not saved by AT&W), sent at every start.
+ */
+const char* const qbg_sessionCmds[] = 
+{ 
+    "AT+CEREG=2",       // registration URCs with location (network state cache)
+    "AT+CGEREP=2,1",    // packet domain event URCs, PDP context activate\deactivate (network state cache)
+};
+#define QBG_SESSIONCMD_CNT (sizeof(qbg_sessionCmds) / sizeof(qbg_sessionCmds[0]))
+
+/* Radio network search configuration (qbg_setNwConfig), self-saving AT+QCFG settings sent and fingerprinted with the init commands.
+ */
+#define QBG_NWCFGCMD_CNT 3
+static char nwConfigCmds[QBG_NWCFGCMD_CNT][QBG_CMDSZ];
+static bool nwConfigSet = false;
 
 
 #pragma region private functions
 /* --------------------------------------------------------------------------------------------- */
 
+static uint32_t s_initCmdsFingerprint();
+static bool s_cfgFileExists(const char *cfgFileName);
+static void s_cfgFileUpdate(const char *cfgFileName);
+static bool s_awaitStatus(bool statusHigh);
+static void s_startSession();
+static void s_batchAddNwConfig(atcmdBatch_t *batch);
 
 #pragma endregion
 
@@ -61,6 +92,8 @@ const char* const qbg_initCmds[] =
 
 /**
  *	\brief Power on the BGx module.
+ * 
+ *  Power-on completes on the status pin rising edge (qbg__statusIsr), the wait yields to the application rather than polling the pin.
  *  \returns Prior BGx power state: true=previously powered on
  */
 bool qbg_powerOn()
@@ -73,20 +106,15 @@ bool qbg_powerOn()
     }
 
     PRINTF(DBGCOLOR_dGreen, "Powering LTEm1 On...");
+    g_ltem->qbgReadyState = qbg_readyState_powerOff;
     gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_high);
-    lDelay(QBG_POWERON_DELAY);
+    lDelay(QBG_POWERON_DELAY);                                          // BGx power key pulse width (HW design spec)
     gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_low);
 
-    uint8_t attempts = 0;
-    while (attempts++ < 10)             // wait for status=ready
+    if (s_awaitStatus(true))
     {
-        if (gpio_readPin(g_ltem->pinConfig.statusPin))
-        {
-            g_ltem->qbgReadyState = qbg_readyState_powerOn;
-            PRINTF(DBGCOLOR_dGreen, "DONE\r");
-            return false;
-        }
-        lDelay(500);                    // allow background tasks to operate
+        PRINTF(DBGCOLOR_dGreen, "DONE\r");
+        return false;
     }
     PRINTF(DBGCOLOR_warn, "FAILED\r");
     return false;
@@ -103,15 +131,12 @@ void qbg_powerOff()
 	lDelay(QBG_POWEROFF_DELAY);
 	gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_low);
 
-    while (gpio_readPin(g_ltem->pinConfig.statusPin))
-    {
-        lDelay(500);          // allow background tasks to operate
-    }
+    s_awaitStatus(false);
 }
 
 
 /**
- *	\brief Powers off the BGx module.
+ *	\brief Reset the BGx module (AT+CFUN=1,1).
  */
 void qbg_reset()
 {
@@ -119,48 +144,56 @@ void qbg_reset()
     g_ltem->qbgReadyState = qbg_readyState_powerOn;
     iop_txSend("AT\r", 3, true);
     iop_txSend("AT+CFUN=1,1\r", 11, true);
-    while (!gpio_readPin(g_ltem->pinConfig.statusPin))
-    {
-        lDelay(500);          // allow background tasks to operate
-    }
+    s_awaitStatus(true);
 }
 
 
 /**
  *	\brief Initializes the BGx module.
+ *
+ *  The init commands are only sent if the BGx does not hold the configuration fingerprint file for the current qbg_initCmds[] list,
+ *  a warm start costs a single AT+QFLST query. After a full init, the settings are saved (AT&W) and the fingerprint file updated.
+ *  A radio network configuration set with qbg_setNwConfig() prior to start is part of the init commands (and fingerprint).
+ *  The session commands (qbg_sessionCmds[], not retained by BGx) are sent at every start.
+ * 
+ *  \return True if initialized. On failure the start sequence (ltem_doWork) power cycles the BGx and retries once.
  */
-void qbg_start()
+bool qbg_start()
 {
-    uint8_t attempts = 0;
-    atcmdResult_t atResult = {.statusCode = RESULT_CODE_TIMEOUT};
+    char cfgFileName[QBG_CFGFILE_NAMESZ];
 
-    qbg_startRetry:
+    snprintf(cfgFileName, QBG_CFGFILE_NAMESZ, "ltemc_%08lx.cfg", (unsigned long)s_initCmdsFingerprint());
 
     // toss out an empty AT command to flush any debris in the command channel
     atcmd_tryInvoke("AT");
     atcmd_awaitResult(true);
 
-    // init BGx state
-    for (size_t i = 0; i < BG96_INIT_COMMAND_COUNT; i++)
+    if (s_cfgFileExists(cfgFileName))                               // BGx already configured with current init settings
     {
+        PRINTF(DBGCOLOR_info, "BGx config current (%s)\r", cfgFileName);
+        s_startSession();
+        return true;
+    }
 
-        if (atcmd_tryInvoke(qbg_initCmds[i]))
-        {
-            if (atcmd_awaitResult(true).statusCode != RESULT_CODE_SUCCESS)
-            {
-                if (attempts == 0)
-                {
-                    attempts++;
-                    PRINTF(dbgColor_warn, "BGx reseting: init failed!\r");
-                    qbg_powerOff();
-                    qbg_powerOn();
-                    iop_awaitAppReady();
-                    goto qbg_startRetry;
-                }
-                ltem_notifyApp(ltemNotifType_hwInitFailed, "qbg-start() init sequence failed");
-            }
-        }
+    // init BGx state, batched into one command line, then persist settings to BGx user profile (AT&W)
+    atcmdBatch_t initBatch;
+    atcmd_batchInit(&initBatch);
+    for (size_t i = 0; i < QBG_INITCMD_CNT; i++)
+    {
+        if (!atcmd_batchAdd(&initBatch, qbg_initCmds[i]))
+            ltem_notifyApp(ltemNotifType_hwInitFailed, "qbg-start() init sequence exceeds batch");
+    }
+    s_batchAddNwConfig(&initBatch);
+    atcmd_batchAdd(&initBatch, "AT&W");
+
+    if (atcmd_batchInvoke(&initBatch, ACTION_TIMEOUTml * initBatch.cmdCnt, true).statusCode != RESULT_CODE_SUCCESS)
+    {
+        PRINTF(dbgColor_warn, "BGx init failed @%d!\r", initBatch.failedIndx);
+        return false;
     }
+    s_cfgFileUpdate(cfgFileName);                                   // record fingerprint of applied settings
+    s_startSession();
+    return true;
 }
 
 
@@ -233,4 +266,196 @@ void qbg_setIotOpMode(qbg_nw_iot_mode_t mode)
     atcmd_awaitResult(true);
 }
 
+
+
+/**
+ *  \brief Configure the BGx radio network search in a single (batched) AT command: RAT sequence, RAT(s) allowed and LTE category.
+ * 
+ *  Set prior to ltem_start() to have the configuration applied by qbg_start() with the init commands, it is then only resent when
+ *  changed. Once the BGx is started the configuration is applied immediately.
+ * 
+ *  \param sequence [in] - RAT search sequence (see qbg_setNwScanSeq), QBG_RATSEQ_ constants.
+ *  \param scanMode [in] - RAT(s) to be searched (see qbg_setNwScanMode).
+ *  \param iotMode [in] - Network category to be searched under LTE RAT (see qbg_setIotOpMode).
+ * 
+ *  \return True if all settings were applied (or recorded for start), false if sequence is invalid or a setting failed.
+*/
+bool qbg_setNwConfig(const char *sequence, qbg_nw_scan_mode_t scanMode, qbg_nw_iot_mode_t iotMode)
+{
+    if (strlen(sequence) >= QBG_RATSEQ_SZ)
+        return false;
+
+    snprintf(nwConfigCmds[0], QBG_CMDSZ, "AT+QCFG=\"nwscanseq\",%s", sequence);
+    snprintf(nwConfigCmds[1], QBG_CMDSZ, "AT+QCFG=\"nwscanmode\",%d", scanMode);
+    snprintf(nwConfigCmds[2], QBG_CMDSZ, "AT+QCFG=\"iotopmode\",%d", iotMode);
+    nwConfigSet = true;
+
+    if (g_ltem->qbgReadyState != qbg_readyState_appReady)           // applied by qbg_start()
+        return true;
+
+    atcmdBatch_t nwBatch;
+    atcmd_batchInit(&nwBatch);
+    s_batchAddNwConfig(&nwBatch);
+    return atcmd_batchInvoke(&nwBatch, ACTION_TIMEOUTml * nwBatch.cmdCnt, true).statusCode == RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief BGx status pin change ISR, tracks BGx power state from status signal edges.
+ * 
+ *  Attached by ltem__initIo(). Semi-private to allow host testing to simulate status edges (set pin level, call ISR).
+ */
+void qbg__statusIsr()
+{
+    if (gpio_readPin(g_ltem->pinConfig.statusPin))
+    {
+        if (g_ltem->qbgReadyState == qbg_readyState_powerOff)           // don't regress appReady on an edge glitch
+            g_ltem->qbgReadyState = qbg_readyState_powerOn;
+    }
+    else
+        g_ltem->qbgReadyState = qbg_readyState_powerOff;
+}
+
+
+/**
+ *	\brief Send the session commands (settings BGx doesn't retain across power cycle or PSM), batched into one command line.
+ * 
+ *  Sent by qbg_start(), and by the power manager when the BGx exits PSM.
+ *  \return 200 if sent, 409 if AT action lock unavailable, otherwise batch error.
+ */
+resultCode_t qbg__sendSessionCmds()
+{
+    atcmdBatch_t sessionBatch;
+    atcmd_batchInit(&sessionBatch);
+    for (size_t i = 0; i < QBG_SESSIONCMD_CNT; i++)
+    {
+        if (!atcmd_batchAdd(&sessionBatch, qbg_sessionCmds[i]))
+            ltem_notifyApp(ltemNotifType_hwInitFailed, "qbg-start() session sequence exceeds batch");
+    }
+    return atcmd_batchInvoke(&sessionBatch, ACTION_TIMEOUTml * sessionBatch.cmdCnt, true).statusCode;
+}
+
+
+#pragma endregion
+
+
+#pragma region private functions
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ *	\brief [private] Send the session commands at start, failure is reported to the application.
+ */
+static void s_startSession()
+{
+    if (qbg__sendSessionCmds() != RESULT_CODE_SUCCESS)
+        ltem_notifyApp(ltemNotifType_hwInitFailed, "qbg-start() session sequence failed");
+}
+
+
+/**
+ *	\brief [private] Add the radio network configuration commands (qbg_setNwConfig) to a batch, if set.
+ */
+static void s_batchAddNwConfig(atcmdBatch_t *batch)
+{
+    for (size_t i = 0; nwConfigSet && i < QBG_NWCFGCMD_CNT; i++)
+    {
+        if (!atcmd_batchAdd(batch, nwConfigCmds[i]))
+            ltem_notifyApp(ltemNotifType_hwInitFailed, "qbg-start() network config exceeds batch");
+    }
+}
+
+
+/**
+ *	\brief [private] FNV-1a hash of the init command list and radio network configuration, identifies the BGx configuration.
+ */
+static uint32_t s_initCmdsFingerprint()
+{
+    uint32_t hash = FNV1A_OFFSET;
+    for (size_t i = 0; i < QBG_INITCMD_CNT + (nwConfigSet ? QBG_NWCFGCMD_CNT : 0); i++)
+    {
+        const char *cmd = (i < QBG_INITCMD_CNT) ? qbg_initCmds[i] : nwConfigCmds[i - QBG_INITCMD_CNT];
+        for (const char *c = cmd; *c != ASCII_cNULL; c++)
+        {
+            hash ^= (uint8_t)*c;
+            hash *= FNV1A_PRIME;
+        }
+        hash ^= ASCII_cCR;                                          // command separator, ["AB","C"] != ["A","BC"]
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+
+/**
+ *	\brief [private] Test for configuration fingerprint file in BGx filesystem.
+ */
+static bool s_cfgFileExists(const char *cfgFileName)
+{
+    char atCmd[QBG_CMDSZ];
+    bool exists = false;
+
+    snprintf(atCmd, QBG_CMDSZ, "AT+QFLST=\"%s\"", cfgFileName);
+    if (atcmd_tryInvoke(atCmd))
+    {
+        atcmdResult_t atResult = atcmd_awaitResult(false);
+        exists = atResult.statusCode == RESULT_CODE_SUCCESS && strstr(atResult.response, "+QFLST: ") != NULL;
+        atcmd_close();
+    }
+    return exists;
+}
+
+
+/**
+ *	\brief [private] Replace stale configuration fingerprint file(s) with the current fingerprint (empty file).
+ */
+static void s_cfgFileUpdate(const char *cfgFileName)
+{
+    char atCmd[QBG_CMDSZ];
+    char staleName[QBG_CFGFILE_NAMESZ];
+
+    for (size_t i = 0; i < QBG_CFGFILE_STALEMAX; i++)                 // remove fingerprints of prior configurations
+    {
+        staleName[0] = ASCII_cNULL;
+        if (atcmd_tryInvoke("AT+QFLST=\"" QBG_CFGFILE_PATTERN "\""))
+        {
+            atcmdResult_t atResult = atcmd_awaitResult(false);
+            if (atResult.statusCode == RESULT_CODE_SUCCESS)
+            {
+                char *nameAt = strstr(atResult.response, "+QFLST: \"");
+                if (nameAt != NULL)
+                    atcmd_strToken(nameAt + 9, ASCII_cDBLQUOTE, staleName, QBG_CFGFILE_NAMESZ);
+            }
+            atcmd_close();
+        }
+        if (staleName[0] == ASCII_cNULL)
+            break;
+
+        snprintf(atCmd, QBG_CMDSZ, "AT+QFDEL=\"%s\"", staleName);
+        if (!atcmd_tryInvoke(atCmd) || atcmd_awaitResult(true).statusCode != RESULT_CODE_SUCCESS)
+            break;
+    }
+
+    fileOpenResult_t openResult = filsys_open(cfgFileName, fileOpenMode_normalRdWr, NULL);
+    if (openResult.resultCode == RESULT_CODE_SUCCESS)
+        filsys_close(openResult.fileHandle);
+}
+
+
+/**
+ *	\brief Wait (yielding) for the status ISR to signal the BGx power state.
+ *  \param statusHigh [in] - true: wait for power on, false: wait for power off
+ *  \return True if the state was signaled within QBG_STATUS_MILLISMAX.
+ */
+static bool s_awaitStatus(bool statusHigh)
+{
+    uint32_t waitStart = lMillis();
+    while ((g_ltem->qbgReadyState != qbg_readyState_powerOff) != statusHigh)
+    {
+        if (lTimerExpired(waitStart, QBG_STATUS_MILLISMAX))
+            return false;
+        lYield();
+    }
+    return true;
+}
+
 #pragma endregion
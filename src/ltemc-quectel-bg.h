@@ -35,12 +35,15 @@
 #define QBG_POWERON_DELAY      500U
 #define QBG_POWEROFF_DELAY     1500U
 #define QBG_RESET_DELAY        300U
+#define QBG_STATUS_MILLISMAX   5000U            ///< max wait for BGx status signal to follow power on\off (status pin edge)
+#define QBG_APPREADY_MILLISMAX 5000U            ///< max wait for BGx firmware ready (APP RDY) following status signal
 #define QBG_BAUDRATE_DEFAULT   115200U
 
 #define QBG_RATSEQ_AUTO    "00"
 #define QBG_RATSEQ_GSM     "01"
 #define QBG_RATSEQ_CATM1   "02"
 #define QBG_RATSEQ_NBIOT   "03"
+#define QBG_RATSEQ_SZ      9                ///< Max RAT search sequence string (4 RATs), with terminator
 
 
 /** 
@@ -82,7 +85,7 @@ extern "C"
 #endif // __cplusplus
 
 
-void qbg_start();
+bool qbg_start();
 
 bool qbg_powerOn();
 void qbg_powerOff();
@@ -91,6 +94,11 @@ void qbg_reset();
 void qbg_setNwScanSeq(const char *sequence);
 void qbg_setNwScanMode(qbg_nw_scan_mode_t mode);
 void qbg_setIotOpMode(qbg_nw_iot_mode_t mode);
+bool qbg_setNwConfig(const char *sequence, qbg_nw_scan_mode_t scanMode, qbg_nw_iot_mode_t iotMode);
+
+// semi-private functions, not intended for most application but not static for special needs
+void qbg__statusIsr();
+resultCode_t qbg__sendSessionCmds();
 
 
 #ifdef __cplusplus
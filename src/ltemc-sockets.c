@@ -48,12 +48,21 @@
 #define IRD_REQ_MAXSZ 1500
 
 #define ASCII_sSENDOK "SEND OK\r\n"
+#define SOCKET_URC_INCOMING "+QIURC: \"incoming"
+#define SOCKET_URC_INCOMINGSZ 17
+#define SOCKET_STATE_LANDMARK "+QISTATE: "
+#define SOCKET_STATE_LANDMARKSZ 10
 
 // file scope global variables
 static uint32_t irdReqstAt = 0;             // if not 0, IRD open is pending and value is tick cnt when IRD request issued
 
 // file scope local function declarations
+static socketResult_t s_openSocket(socketId_t socketId, protocol_t protocol, const char *host, uint16_t rmtPort, uint16_t lclPort, bool cleanSession, receiver_func_t rcvr_func);
 static bool s_requestIrdData(iopDataPeer_t dataPeer, bool applyLock);
+static char *s_parseRmtAddr(socketCtrl_t *socketCtrl, const char *addrField);
+static void s_resetSocketCtrl(socketId_t socketId);
+static void s_clearSocketCtrl(socketId_t socketId);
+static void s_queryStates();
 static resultCode_t s_tcpudpOpenCompleteParser(const char *response, char **endptr);
 static resultCode_t s_sslOpenCompleteParser(const char *response, char **endptr);
 static resultCode_t s_socketSendCompleteParser(const char *response, char **endptr);
@@ -83,8 +92,10 @@ void sckt_create()
         scktPtr->socketCtrls[i].protocol = protocol_void;
         scktPtr->socketCtrls[i].dataBufferIndx = IOP_NO_BUFFER;
         scktPtr->socketCtrls[i].pdpContextId = g_ltem->dataContext;
+        scktPtr->socketCtrls[i].tlsContextId = TLS_CONTEXT_NONE;
         scktPtr->socketCtrls[i].receiver_func = NULL;
         scktPtr->socketCtrls[i].dataBufferIndx = IOP_NO_BUFFER;
+        scktPtr->socketCtrls[i].listenerId = SOCKET_NOLISTENER;
     }
     // set global reference to this
     g_ltem->sockets = scktPtr;
@@ -96,12 +107,30 @@ void sckt_create()
 
 
 
+/**
+ *	\brief Set the SSL context for a socket, ex: for certificate authentication. Otherwise an SSL socket open acquires a default 
+ *  context (any TLS version, no authentication). The socket takes over the acquired context and releases it when closed or if the
+ *  open fails, set the context again before reopening.
+ *
+ *	\param socketId [in] - The socket to be opened with protocol_ssl.
+ *	\param tlsContextId [in] - SSL context from tls_acquireContext().
+ */
+void sckt_setTlsContext(socketId_t socketId, uint8_t tlsContextId)
+{
+    if (socketId >= IOP_SOCKET_COUNT)
+        return;
+    scktPtr->socketCtrls[socketId].tlsContextId = tlsContextId;
+}
+
+
+
 /**
  *	\brief Open a data connection (socket) to d data to an established endpoint via protocol used to open socket (TCP/UDP/TCP INCOMING).
  *
  *	\param socketId [in] - The ID or number specifying the socket connect to open.
  *	\param protocol [in] - The IP protocol to use for the connection (TCP/UDP/TCP LISTENER/UDP SERVICE/SSL).
- *	\param host [in] - The IP address (string) or domain name of the remote host to communicate with.
+ *	\param host [in] - The IP address (string) or domain name of the remote host to communicate with. Non-SSL host names
+ *  are opened by address from the DNS cache, a failed open with a cached address is retried with a fresh lookup.
  *  \param rmtPort [in] - The port number at the remote host.
  *  \param lclPort [in] - The port number on this side of the conversation, set to 0 to auto-assign.
  *  \param cleanSession [in] - If the port is found already open, TRUE: flushes any previous data from the socket session.
@@ -111,83 +140,76 @@ void sckt_create()
  */
 socketResult_t sckt_open(socketId_t socketId, protocol_t protocol, const char *host, uint16_t rmtPort, uint16_t lclPort, bool cleanSession, receiver_func_t rcvr_func)
 {
-    char openCmd[SOCKETS_CMDBUF_SZ] = {0};
-    char protoName[13] = {0};
+    char rmtAddr[DNS_ADDRSZ];
 
-    if (socketId >= IOP_SOCKET_COUNT ||
-        scktPtr->socketCtrls[socketId].protocol != protocol_void ||
-        protocol > protocol_AnyIP ||
-        rcvr_func == NULL
-        )
-    return RESULT_CODE_BADREQUEST;
+    if (protocol > protocol_ssl || rcvr_func == NULL)                   // service protocols: sckt_openService()
+        return RESULT_CODE_BADREQUEST;
 
-    uint8_t socketBitMap = 0x01 << socketId;
+    if (protocol == protocol_ssl || dns__isIpAddress(host))            // TLS verifies\indicates (SNI) the host name, BGx resolves
+        return s_openSocket(socketId, protocol, host, rmtPort, lclPort, cleanSession, rcvr_func);
 
-    switch (protocol)
+    bool cached = dns_getCached(host, rmtAddr);
+    if (!cached && dns_resolve(host, rmtAddr) != RESULT_CODE_SUCCESS)
+        return s_openSocket(socketId, protocol, host, rmtPort, lclPort, cleanSession, rcvr_func);     // BGx resolves on open
+
+    socketResult_t rslt = s_openSocket(socketId, protocol, rmtAddr, rmtPort, lclPort, cleanSession, rcvr_func);
+    if (cached && rslt != RESULT_CODE_SUCCESS && rslt != SOCKET_RESULT_PREVOPEN && rslt != RESULT_CODE_BADREQUEST)
     {
-    case protocol_udp:
-        strcpy(protoName, "UDP");
-        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | socketBitMap;
-        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
-        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_tcpudpOpenCompleteParser);
-        break;
+        dns_invalidate(host);                                           // host may have moved, retry with a fresh lookup
+        if (dns_resolve(host, rmtAddr) == RESULT_CODE_SUCCESS)
+            rslt = s_openSocket(socketId, protocol, rmtAddr, rmtPort, lclPort, cleanSession, rcvr_func);
+    }
+    return rslt;
+}
 
-    case protocol_tcp:
-        strcpy(protoName, "TCP");
-        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | socketBitMap;
-        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
-        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_tcpudpOpenCompleteParser);
-        break;
 
-    case protocol_ssl:
-        strcpy(protoName, "SSL");
-        socketBitMap = 0x01 << socketId;
-        iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket | socketBitMap;
-        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QSSLOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
-        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_sslOpenCompleteParser);
-        break;
 
-        /* The 2 use cases here are not really supported by the network carriers without premium service */
-        // case protocol_udpService:
-        //     strcpy(protoName, "UDP SERVICE");
-        //     strcpy(host, "127.0.0.1");
-        //     break;
-        // case protocol_tcpListener:
-        //     strcpy(protoName, "TCP LISTENER");
-        //     strcpy(host, "127.0.0.1");
-        //     break;
-    }
+/**
+ *	\brief Open a service socket, accepting data from any remote peer on a local port.
+ *
+ *	\param socketId [in] - The ID or number specifying the socket to open.
+ *	\param protocol [in] - Service protocol: protocol_udpService.
+ *  \param lclPort [in] - The local port to receive on.
+ *  \param rcvr_func [in] - The callback function in your application receiving each datagram with the sender's address and port.
+ * 
+ *  \return socket result code similar to http status code, OK = 200
+ */
+socketResult_t sckt_openService(socketId_t socketId, protocol_t protocol, uint16_t lclPort, datagramReceiver_func_t rcvr_func)
+{
+    if (protocol != protocol_udpService || socketId >= IOP_SOCKET_COUNT || lclPort == 0 || rcvr_func == NULL)
+        return RESULT_CODE_BADREQUEST;
 
-    // snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
-    // atcmd_tryInvokeAdv(openCmd, ACTION_LOCKRETRIES, ACTION_TIMEOUT_DEFAULTmillis, s_tcpudpOpenCompleteParser);
+    socketResult_t rslt = s_openSocket(socketId, protocol, "127.0.0.1", 0, lclPort, true, NULL);
+    if (rslt == RESULT_CODE_SUCCESS || rslt == SOCKET_RESULT_PREVOPEN)
+        scktPtr->socketCtrls[socketId].datagramRcvr_func = rcvr_func;
+    return rslt;
+}
 
-    // await result of open from inside switch() above
-    atcmdResult_t atResult = atcmd_awaitResult(true);
 
-    // finish initialization and run background tasks to prime data pipeline
-    if (atResult.statusCode == RESULT_CODE_SUCCESS || atResult.statusCode == SOCKET_RESULT_PREVOPEN)
-    {
-        scktPtr->socketCtrls[socketId].protocol = protocol;
-        scktPtr->socketCtrls[socketId].socketId = socketId;
-        scktPtr->socketCtrls[socketId].open = true;
-        scktPtr->socketCtrls[socketId].receiver_func = rcvr_func;
-    }
 
-    else        // failed to open, reset peerMap bits
-    {
-        uint8_t socketBitMap = socketBitMap<<socketId;
-        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket & ~socketBitMap;
-        iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket & ~socketBitMap;
-    }
+/**
+ *	\brief Open a TCP listener socket, accepting incoming connections on a local port.
+ *
+ *  Incoming connections are assigned a free connection (socket) ID by BGx, the accept function is invoked from doWork with the 
+ *  new socket ID and the remote peer. Accepted sockets use the listener's receiver function, send with sckt_send() and are 
+ *  closed with sckt_close().
+ *
+ *	\param socketId [in] - The ID or number specifying the listener socket to open.
+ *  \param lclPort [in] - The local port to listen on.
+ *  \param accept_func [in] - The callback function in your application to accept (or refuse) each incoming connection.
+ *  \param rcvr_func [in] - The callback function in your application to be notified of received data on accepted connections.
+ * 
+ *  \return socket result code similar to http status code, OK = 200
+ */
+socketResult_t sckt_listen(socketId_t socketId, uint16_t lclPort, acceptConnection_func_t accept_func, receiver_func_t rcvr_func)
+{
+    if (socketId >= IOP_SOCKET_COUNT || lclPort == 0 || accept_func == NULL || rcvr_func == NULL)
+        return RESULT_CODE_BADREQUEST;
 
-    if (atResult.statusCode == SOCKET_RESULT_PREVOPEN)
-    {
-        scktPtr->socketCtrls[socketId].flushing = cleanSession;
-        scktPtr->socketCtrls[socketId].dataPending = true;
-        PRINTF(DBGCOLOR_white, "Priming rxStream sckt=%d\r", socketId);
-        sckt_doWork();
-    }
-    return atResult.statusCode;
+    socketResult_t rslt = s_openSocket(socketId, protocol_tcpListener, "127.0.0.1", 0, lclPort, true, rcvr_func);
+    if (rslt == RESULT_CODE_SUCCESS || rslt == SOCKET_RESULT_PREVOPEN)
+        scktPtr->socketCtrls[socketId].accept_func = accept_func;
+    return rslt;
 }
 
 
@@ -203,27 +225,16 @@ void sckt_close(uint8_t socketId)
     uint8_t socketBitMap = 0x01 << socketId;
 
     if (iopPtr->peerTypeMap.tcpudpSocket & socketBitMap)                            // socket ID is an open TCP/UDP session
-    {
-        snprintf(closeCmd, 20, "AT+QICLOSE=%d", socketId);                                      // BGx syntax different for TCP/UDP and SSL
-        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket & ~socketBitMap;    // mask off closed socket bit to remove 
-    }
+        snprintf(closeCmd, 20, "AT+QICLOSE=%d", socketId);                          // BGx syntax different for TCP/UDP and SSL
     else if (iopPtr->peerTypeMap.sslSocket & socketBitMap)                          // socket ID is an open SSL session
-    {
         snprintf(closeCmd, 20, "AT+QSSLCLOSE=%d", socketId);
-        iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket & ~socketBitMap;  
-    }
     else
         return;
 
     if (atcmd_tryInvoke(closeCmd))
     {
         if (atcmd_awaitResult(true).statusCode == RESULT_CODE_SUCCESS)
-        {
-            scktPtr->socketCtrls[socketId].protocol = protocol_void;
-            scktPtr->socketCtrls[socketId].socketId = socketId;
-            scktPtr->socketCtrls[socketId].open = false;
-            scktPtr->socketCtrls[socketId].receiver_func = NULL;
-        }
+            s_resetSocketCtrl(socketId);                                            // removes socket from peer map, releases held IRD buffer
     }
 }
 
@@ -283,6 +294,82 @@ bool sckt_getState(uint8_t socketId)
 
 
 
+/**
+ *	\brief Enable the socket health monitor. Sockets closed by the remote peer (URC) are always detected, a check period 
+ *  adds a periodic state query (one AT+QISTATE for all TCP/UDP sockets) to find silently dropped connections.
+ * 
+ *  Unless configured with sckt_setKeepalive(), TCP keepalive is enabled with the SOCKET_KEEPALIVE_ defaults so idle connections
+ *  that are silently dropped are also detected (applies to sockets opened after this call).
+ *
+ *	\param checkPeriodSec [in] - Seconds between state queries, 0 = URC notifications only.
+ *	\param health_func [in] - Application callback invoked once for each socket found dead.
+ * 
+ *  \return 200 if enabled, otherwise the keepalive configuration error (monitor is enabled).
+ */
+resultCode_t sckt_setHealthMonitor(uint16_t checkPeriodSec, socketHealth_func_t health_func)
+{
+    scktPtr->health_func = health_func;
+    scktPtr->healthCheckPeriod = PERIOD_FROM_SECONDS((uint32_t)checkPeriodSec);
+    scktPtr->healthCheckAt = (checkPeriodSec > 0) ? lMillis() : 0;
+
+    if (scktPtr->keepaliveSet)
+        return RESULT_CODE_SUCCESS;
+    resultCode_t rslt = sckt_setKeepalive(true, SOCKET_KEEPALIVE_IDLEmin, SOCKET_KEEPALIVE_INTERVALsec, SOCKET_KEEPALIVE_PROBES);
+    scktPtr->keepaliveSet = false;                                      // defaults, application setting still takes precedence
+    return rslt;
+}
+
+
+
+/**
+ *	\brief Configure TCP keepalive, BGx probes idle connections so NAT timeouts and dead peers surface as a closed socket.
+ *  Applies to sockets opened after this call.
+ *
+ *	\param enable [in] - Enable keepalive probes.
+ *	\param idleMinutes [in] - Idle time before first probe (1-120 minutes).
+ *	\param intervalSeconds [in] - Interval between probes (25-100 seconds).
+ *	\param probeCnt [in] - Unanswered probes before the connection is dropped (3-10).
+ * 
+ *  \return Result code similar to http status code, OK = 200
+ */
+resultCode_t sckt_setKeepalive(bool enable, uint8_t idleMinutes, uint8_t intervalSeconds, uint8_t probeCnt)
+{
+    char cfgCmd[SOCKETS_CMDBUF_SZ] = {0};
+
+    if (enable)
+    {
+        if (idleMinutes < 1 || idleMinutes > 120 || intervalSeconds < 25 || intervalSeconds > 100 || probeCnt < 3 || probeCnt > 10)
+            return RESULT_CODE_BADREQUEST;
+        snprintf(cfgCmd, SOCKETS_CMDBUF_SZ, "AT+QICFG=\"tcp/keepalive\",1,%d,%d,%d", idleMinutes, intervalSeconds, probeCnt);
+    }
+    else
+        strcpy(cfgCmd, "AT+QICFG=\"tcp/keepalive\",0");
+
+    if (!atcmd_tryInvoke(cfgCmd))
+        return RESULT_CODE_CONFLICT;
+    resultCode_t rslt = atcmd_awaitResult(true).statusCode;
+    scktPtr->keepaliveSet = (rslt == RESULT_CODE_SUCCESS);
+    return rslt;
+}
+
+
+
+/**
+ *	\brief Get the health of a socket, check before a send to avoid waiting on a dead connection.
+ *
+ *	\param socketId [in] - The socket to check.
+ * 
+ *  \return Socket health, socketHealth_ok if no failure detected.
+ */
+socketHealth_t sckt_getHealth(socketId_t socketId)
+{
+    if (socketId >= IOP_SOCKET_COUNT)
+        return socketHealth_notConnected;
+    return scktPtr->socketCtrls[socketId].health;
+}
+
+
+
 /**
  *	\brief Send data to an established endpoint via protocol used to open socket (TCP/UDP/TCP INCOMING).
  *
@@ -295,12 +382,17 @@ socketResult_t sckt_send(socketId_t socketId, const char *data, uint16_t dataSz)
     char sendCmd[DFLT_ATBUFSZ] = {0};
     atcmdResult_t atResult = { .statusCode = RESULT_CODE_SUCCESS };
 
-    if (scktPtr->socketCtrls[socketId].protocol > protocol_AnyIP || !scktPtr->socketCtrls[socketId].open)
-        return RESULT_CODE_BADREQUEST;
+    if (scktPtr->socketCtrls[socketId].protocol > protocol_ssl || !scktPtr->socketCtrls[socketId].open)
+        return RESULT_CODE_BADREQUEST;                     // service sockets: sckt_sendTo()
+    if (scktPtr->socketCtrls[socketId].health != socketHealth_ok)
+        return RESULT_CODE_GONE;                           // dead socket, fail fast
 
     // AT+QISEND command initiates send by signaling we plan to send dataSz bytes on a socket,
     // send has subcommand to actual transfer the bytes, so don't automatically close action cmd
-    snprintf(sendCmd, DFLT_ATBUFSZ, "AT+QISEND=%d,%d", socketId, dataSz);
+    if (scktPtr->socketCtrls[socketId].protocol == protocol_ssl)
+        snprintf(sendCmd, DFLT_ATBUFSZ, "AT+QSSLSEND=%d,%d", socketId, dataSz);     // BGx syntax different for TCP/UDP and SSL
+    else
+        snprintf(sendCmd, DFLT_ATBUFSZ, "AT+QISEND=%d,%d", socketId, dataSz);
 
     if (!atcmd_tryInvokeAdv(sendCmd, ACTION_TIMEOUTml, iop_txDataPromptParser))
         return RESULT_CODE_CONFLICT;
@@ -318,6 +410,39 @@ socketResult_t sckt_send(socketId_t socketId, const char *data, uint16_t dataSz)
 
 
 
+/**
+ *	\brief Send a datagram to a remote peer from a UDP service socket.
+ *
+ *	\param socketId [in] - The service socket returned from open.
+ *	\param rmtAddr [in] - The IP address of the remote peer (ex: from the datagram receiver).
+ *	\param rmtPort [in] - The port of the remote peer.
+ *	\param data [in] - A character pointer containing the data to send.
+ *  \param dataSz [in] - The size of the buffer (< 1501 bytes).
+ */
+socketResult_t sckt_sendTo(socketId_t socketId, const char *rmtAddr, uint16_t rmtPort, const char *data, uint16_t dataSz)
+{
+    char sendCmd[SOCKETS_CMDBUF_SZ] = {0};
+
+    if (socketId >= IOP_SOCKET_COUNT || scktPtr->socketCtrls[socketId].protocol != protocol_udpService || !scktPtr->socketCtrls[socketId].open)
+        return RESULT_CODE_BADREQUEST;
+    if (scktPtr->socketCtrls[socketId].health != socketHealth_ok)
+        return RESULT_CODE_GONE;
+
+    snprintf(sendCmd, SOCKETS_CMDBUF_SZ, "AT+QISEND=%d,%d,\"%s\",%d", socketId, dataSz, rmtAddr, rmtPort);
+    if (!atcmd_tryInvokeAdv(sendCmd, ACTION_TIMEOUTml, iop_txDataPromptParser))
+        return RESULT_CODE_CONFLICT;
+
+    atcmdResult_t atResult = atcmd_awaitResult(false);     // waiting for data prompt, leaving action open on return if sucessful
+    if (atResult.statusCode == RESULT_CODE_SUCCESS)
+    {
+        atcmd_sendRaw(data, dataSz, 0, s_socketSendCompleteParser);
+        atResult = atcmd_awaitResult(true);
+    }
+    return atResult.statusCode;
+}
+
+
+
 #define IRD_WAIT_CYCLES 4                                   ///< number of doWork cycles to wait between IRD flows (actual cycles is 1 less than defined)
 
 /**
@@ -332,6 +457,80 @@ void sckt_doWork()
     irdWait = (irdWait + (irdWait == 0 ? 0 : 1)) % IRD_WAIT_CYCLES;     // IRD fairness, if irdWait is non-zero don't open/initiate a new IRD flow
     //irdLastSckt = (++irdLastSckt) % iopDataPeer__SOCKET_CNT;            // last socket to initiate an IRD flow
 
+    /* Accept incoming connections reported by ISR (+QIURC: "incoming"), close refused connections
+    -------------------------------------------------------------------------------------------- */
+
+    if (scktPtr->incomingFull)
+    {
+        scktPtr->incomingFull = false;
+        ltem_notifyApp(ltemNotifType_scktError, "incoming full");
+    }
+    for (uint8_t bufIndx = 0; scktPtr->staleBufferMap && bufIndx < IOP_RX_DATABUFFERS_MAX; bufIndx++)
+    {
+        if (scktPtr->staleBufferMap & (0x01 << bufIndx))
+        {
+            scktPtr->staleBufferMap &= ~(0x01 << bufIndx);
+            iop_resetDataBuffer(bufIndx);
+        }
+    }
+    for (uint8_t connId = 0; scktPtr->refusedMap && connId < SOCKET_BGX_CONNECTCNT; connId++)
+    {
+        if ((scktPtr->refusedMap & (0x01 << connId)) && iopPtr->rxDataPeer == iopDataPeer__NONE)
+        {
+            char closeCmd[20] = {0};
+            snprintf(closeCmd, 20, "AT+QICLOSE=%d", connId);
+            if (!atcmd_tryInvoke(closeCmd))
+                break;                                              // action lock unavailable, retried next doWork
+            atcmd_awaitResult(true);
+            scktPtr->refusedMap &= ~(0x01 << connId);
+            ltem_notifyApp(ltemNotifType_scktError, "incoming refused, no socket");
+        }
+    }
+    for (uint8_t sckt = 0; sckt < IOP_SOCKET_COUNT; sckt++)
+    {
+        if (scktPtr->socketCtrls[sckt].acceptPending)
+        {
+            socketCtrl_t *accepted = (socketCtrl_t *)&scktPtr->socketCtrls[sckt];
+            socketCtrl_t *listener = (socketCtrl_t *)&scktPtr->socketCtrls[accepted->listenerId];
+
+            accepted->acceptPending = false;
+            if (listener->accept_func == NULL || !listener->accept_func(accepted->listenerId, sckt, accepted->rmtAddr, accepted->rmtPort))
+            {
+                accepted->flushing = true;                          // refused, discard any data until closed
+                accepted->closePending = true;
+            }
+        }
+        if (scktPtr->socketCtrls[sckt].closePending && iopPtr->rxDataPeer == iopDataPeer__NONE)
+            sckt_close(sckt);                                       // if action lock unavailable, retried next doWork
+    }
+
+    /* Socket health: report dead sockets once, after data received ahead of the failure is delivered
+    -------------------------------------------------------------------------------------------- */
+
+    if (scktPtr->healthCheckPeriod > 0 && 
+        iopPtr->peerTypeMap.tcpudpSocket != 0 && 
+        iopPtr->rxDataPeer == iopDataPeer__NONE &&
+        lTimerExpired(scktPtr->healthCheckAt, scktPtr->healthCheckPeriod))
+    {
+        s_queryStates();                                            // if action lock unavailable, retried next doWork
+    }
+    for (uint8_t sckt = 0; sckt < IOP_SOCKET_COUNT; sckt++)
+    {
+        socketCtrl_t *scktCtrl = (socketCtrl_t *)&scktPtr->socketCtrls[sckt];
+
+        if (scktCtrl->health != socketHealth_ok && !scktCtrl->healthReported && !scktCtrl->dataPending && iopPtr->rxDataPeer != sckt)
+        {
+            scktCtrl->healthReported = true;
+            PRINTF(dbgColor_warn, "SCKT-dead sckt=%d health=%d\r", sckt, scktCtrl->health);
+            if (scktCtrl->closed_func != NULL)
+                scktCtrl->closed_func(sckt, scktCtrl->health);
+            else if (scktPtr->health_func != NULL)
+                scktPtr->health_func(sckt, scktCtrl->health);
+            else
+                ltem_notifyApp(ltemNotifType_scktError, "socket closed");
+        }
+    }
+
     /* Push data pipeline forward for existing data buffers */
     /* Service an open IRD data flow: parse the first block (from data buffer), check for flow 
      * complete, close out resources.
@@ -352,14 +551,18 @@ void sckt_doWork()
 
             if (buf->dataPeer < iopDataPeer__SOCKET_CNT &&          // open "socket" data peer
                 buf->irdSz == 0 &&                                  // irdSz not yet set for this IRD data peer flow
-                buf->head > buf->buffer)                            // data RX buffer has at least 1 data chunk (UART FIFO buffer)
+                buf->head > buf->buffer + 2 &&                      // data RX buffer has at least 1 data chunk (UART FIFO buffer)
+                memchr(buf->buffer + 2, ASCII_cLF, buf->head - buf->buffer - 2) != NULL)  // IRD header line complete (UDP service header carries sender address)
             {                                                       // -- 1st data chuck has data header with size of data BGx is ready to send
                 // char dbg[65] = {0};
                 // strncpy(dbg, buf->buffer, 64);
                 // PRINTF(0,"SdWrcv>>%s<<\r", dbg);
 
-                char *irdSzAt = buf->buffer + 9;                        // data prefix from BGx:  len("\r\n+QIRD: ") == 9
+                char *irdSzAt = memchr(buf->buffer, ':', buf->head - buf->buffer);      // data prefix from BGx: \r\n+QIRD: or \r\n+QSSLRECV:
+                irdSzAt = (irdSzAt != NULL) ? irdSzAt + 1 : buf->buffer + 9;
                 buf->irdSz = strtol(irdSzAt, &buf->tail, 10);           // parse out data size from IRD response:  \r\n+QIRD: <dataSz>
+                if (buf->tail[0] == ASCII_cCOMMA)                       // UDP service:  \r\n+QIRD: <dataSz>,"<rmtAddr>",<rmtPort>
+                    buf->tail = s_parseRmtAddr((socketCtrl_t *)&scktPtr->socketCtrls[buf->dataPeer], buf->tail + 1);
 
                 if (buf->irdSz > 0)                                     // test for data complete
                 {
@@ -400,7 +603,10 @@ void sckt_doWork()
                 {
                     // data ready event, send to application
                     // invoke application socket receiver_func: socket number, data pointer, number of bytes in buffer
-                    scktPtr->socketCtrls[buf->dataPeer].receiver_func(sckt.socketId, buf->tail, buf->irdSz);
+                    if (sckt.protocol == protocol_udpService)
+                        sckt.datagramRcvr_func(sckt.socketId, buf->tail, buf->irdSz, sckt.rmtAddr, sckt.rmtPort);
+                    else
+                        scktPtr->socketCtrls[buf->dataPeer].receiver_func(sckt.socketId, buf->tail, buf->irdSz);
                 }
 
                 /* close out IRD request resulting with data */
@@ -415,16 +621,26 @@ void sckt_doWork()
                 // PRINTF(DBGCOLOR_dGreen, "SCKT-nextIRD sckt=%d\r", sckt.socketId);
                 // s_requestIrdData(sckt.socketId, false);                             // check the data pipeline for more data
             }
+        }
+    }
 
-            if (lTimerExpired(irdReqstAt, ACTION_TIMEOUTml))                // if check for IRD timeout
-            {
-                irdReqstAt = 0;                                                             // no longer waiting for IRD response
-                atcmd_close();                                                             // release action lock
-                // irdWait = 1;                                                                // signal IRD fairness wait started
-                // signal application socket maybe unstable
-                ltem_notifyApp(ltemNotifType_scktError, "IRD timeout");
-            }
+    /* IRD timeout: release the IRD buffer (only if a socket owns the IOP data peer) and the action lock, socket dataPending retries
+    -------------------------------------------------------------------------------------------- */
+
+    if (lTimerExpired(irdReqstAt, ACTION_TIMEOUTml))
+    {
+        irdReqstAt = 0;                                                     // no longer waiting for IRD response
+        if (iopPtr->rxDataPeer < iopDataPeer__SOCKET_CNT)                   // MQTT\HTTP\FILE peers own their buffers, leave them alone
+        {
+            if (iopPtr->rxDataBufIndx != IOP_NO_BUFFER)
+                iop_resetDataBuffer(iopPtr->rxDataBufIndx);
+            iopPtr->rxDataBufIndx = IOP_NO_BUFFER;
+            iopPtr->rxDataPeer = iopDataPeer__NONE;
         }
+        atcmd_close();                                                      // release action lock
+        // irdWait = 1;                                                        // signal IRD fairness wait started
+        // signal application socket maybe unstable
+        ltem_notifyApp(ltemNotifType_scktError, "IRD timeout");
     }
 
 
@@ -462,6 +678,127 @@ void sckt_doWork()
 }
 
 
+
+
+/**
+ *	\brief URC handler (ISR context) for incoming connections on a TCP listener:
+ *      +QIURC: "incoming",<connectID>,<serverID>,"<rmtAddr>",<rmtPort>
+ *      +QIURC: "incoming full"
+ *
+ *  The connection ID is assigned by BGx, the socket is initialized as open TCP; accept function is invoked from doWork.
+ *
+ *  \param urcData [in] - Received chunk, starting at URC.
+ *  \param dataSz [in] - Size of chunk.
+ */
+void sckt__urcIncoming(const char *urcData, uint16_t dataSz)
+{
+    const char *urcAt = urcData + SOCKET_URC_INCOMINGSZ;
+    char *endPtr;
+
+    if (dataSz <= SOCKET_URC_INCOMINGSZ + 2)
+        return;
+    if (*urcAt == ASCII_cSPACE)                                             // "incoming full"
+    {
+        scktPtr->incomingFull = true;
+        return;
+    }
+
+    socketId_t socketId = strtol(urcAt + 2, &endPtr, 10);                   // past closing quote and comma
+    socketId_t listenerId = strtol(endPtr + 1, &endPtr, 10);
+    if (socketId >= SOCKET_BGX_CONNECTCNT)
+        return;
+    if (socketId >= IOP_SOCKET_COUNT || listenerId >= IOP_SOCKET_COUNT || scktPtr->socketCtrls[listenerId].protocol != protocol_tcpListener)
+    {
+        scktPtr->refusedMap |= 0x01 << socketId;                            // no socket control for connection, BGx holds it until closed
+        return;
+    }
+
+    socketCtrl_t *sckt = (socketCtrl_t *)&scktPtr->socketCtrls[socketId];
+    if (sckt->dataBufferIndx != IOP_NO_BUFFER)                              // BGx assigned ID, drop any stale state
+        scktPtr->staleBufferMap |= 0x01 << sckt->dataBufferIndx;            // buffer reset deferred to doWork (not in ISR)
+    s_clearSocketCtrl(socketId);
+    s_parseRmtAddr(sckt, endPtr + 1);
+    sckt->protocol = protocol_tcp;
+    sckt->open = true;
+    sckt->pdpContextId = scktPtr->socketCtrls[listenerId].pdpContextId;
+    sckt->receiver_func = scktPtr->socketCtrls[listenerId].receiver_func;
+    sckt->listenerId = listenerId;
+    sckt->acceptPending = true;
+    iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | (0x01 << socketId);
+}
+
+
+/**
+ *	\brief URC handler (ISR context) for a connection closed by the remote peer:  +QIURC: "closed",<connectID>  (or +QSSLURC:)
+ *
+ *  \param socketId [in] - Connection ID from the URC.
+ */
+void sckt__urcClosed(socketId_t socketId)
+{
+    if (socketId < IOP_SOCKET_COUNT && scktPtr->socketCtrls[socketId].open)
+        scktPtr->socketCtrls[socketId].health = socketHealth_peerClosed;
+}
+
+
+/**
+ *	\brief Register a protocol module (ex: HTTP session) as owner of an open socket, the module is notified (from doWork) when the 
+ *  socket is found dead instead of the application health callback. Cleared when the socket is closed.
+ *
+ *  \param socketId [in] - Open socket.
+ *  \param closed_func [in] - Module notification, invoked once for each failure after received data is delivered.
+ */
+void sckt__setClosedFunc(socketId_t socketId, socketHealth_func_t closed_func)
+{
+    if (socketId < IOP_SOCKET_COUNT && scktPtr->socketCtrls[socketId].open)
+        scktPtr->socketCtrls[socketId].closed_func = closed_func;
+}
+
+
+/**
+ *	\brief State query capture (ISR context), records and removes complete +QISTATE lines from the response leaving the 
+ *  command result (OK) for the command parser.
+ *      +QISTATE: <connectID>,"<serviceType>","<rmtAddr>",<rmtPort>,<lclPort>,<socketState>,<contextID>,<serverID>,<accessMode>,"<ATport>"
+ *
+ *  \param respData [in] - Command response received so far.
+ *  \param respSz [in] - Size of response.
+ * 
+ *  \return Size of response remaining after captured lines are removed.
+ */
+uint16_t sckt__stateCapture(char *respData, uint16_t respSz)
+{
+    char *respEnd = respData + respSz;
+    char *lineAt = respData;
+
+    while ((lineAt = memchr(lineAt, '+', respEnd - lineAt)) != NULL)
+    {
+        char *lineEnd = memchr(lineAt, ASCII_cLF, respEnd - lineAt);
+        if (lineEnd == NULL)                                                // partial line, captured when complete
+            break;
+        lineEnd++;
+        if (memcmp(lineAt, SOCKET_STATE_LANDMARK, SOCKET_STATE_LANDMARKSZ) != 0)
+        {
+            lineAt = lineEnd;
+            continue;
+        }
+
+        char *fieldAt;
+        uint8_t socketId = strtol(lineAt + SOCKET_STATE_LANDMARKSZ, &fieldAt, 10);
+        for (uint8_t field = 0; field < 4 && fieldAt != NULL; field++)      // skip to <socketState>
+            fieldAt = memchr(fieldAt + 1, ASCII_cCOMMA, lineEnd - fieldAt - 1);
+        if (fieldAt != NULL && socketId < IOP_SOCKET_COUNT)
+        {
+            uint8_t socketState = strtol(fieldAt + 1, NULL, 10);
+            if (socketState >= 1 && socketState <= 3)                       // opening, connected, listening
+                scktPtr->stateSeenMap |= 0x01 << socketId;
+        }
+
+        memmove(lineAt, lineEnd, respEnd - lineEnd);                        // remove captured line
+        respEnd -= lineEnd - lineAt;
+    }
+    return respEnd - respData;
+}
+
+
 #pragma endregion
 
 
@@ -471,6 +808,209 @@ void sckt_doWork()
  * --------------------------------------------------------------------------------------------- */
 
 
+/**
+ *	\brief [private] Open a socket to a remote host (address or name), see sckt_open().
+ */
+static socketResult_t s_openSocket(socketId_t socketId, protocol_t protocol, const char *host, uint16_t rmtPort, uint16_t lclPort, bool cleanSession, receiver_func_t rcvr_func)
+{
+    char openCmd[SOCKETS_CMDBUF_SZ] = {0};
+    char protoName[13] = {0};
+
+    if (socketId >= IOP_SOCKET_COUNT ||
+        scktPtr->socketCtrls[socketId].protocol != protocol_void ||
+        protocol > protocol_AnyIP
+        )
+    return RESULT_CODE_BADREQUEST;
+
+    uint8_t socketBitMap = 0x01 << socketId;
+
+    switch (protocol)
+    {
+    case protocol_udp:
+        strcpy(protoName, "UDP");
+        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | socketBitMap;
+        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
+        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_tcpudpOpenCompleteParser);
+        break;
+
+    case protocol_tcp:
+        strcpy(protoName, "TCP");
+        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | socketBitMap;
+        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
+        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_tcpudpOpenCompleteParser);
+        break;
+
+    case protocol_ssl:
+        if (scktPtr->socketCtrls[socketId].tlsContextId == TLS_CONTEXT_NONE)      // none set by application, default context (reacquire of equal options resumes TLS session)
+        {
+            tlsOptions_t tlsOptions;
+            tls_initOptions(&tlsOptions, sslVersion_any);
+            scktPtr->socketCtrls[socketId].tlsContextId = tls_acquireContext(&tlsOptions);
+            if (scktPtr->socketCtrls[socketId].tlsContextId == TLS_CONTEXT_NONE)
+                return RESULT_CODE_UNAVAILABLE;
+        }
+        socketBitMap = 0x01 << socketId;
+        iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket | socketBitMap;
+        // AT+QSSLOPEN=<pdpctxID>,<sslctxID>,<clientID>,<serverAddr>,<serverPort>
+        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QSSLOPEN=%d,%d,%d,\"%s\",%d", g_ltem->dataContext, scktPtr->socketCtrls[socketId].tlsContextId, socketId, host, rmtPort);
+        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_sslOpenCompleteParser);
+        break;
+
+    case protocol_udpService:
+    case protocol_tcpListener:
+        strcpy(protoName, protocol == protocol_udpService ? "UDP SERVICE" : "TCP LISTENER");
+        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket | socketBitMap;
+        // AT+QIOPEN=<contextID>,<connectID>,<"UDP SERVICE"|"TCP LISTENER">,"127.0.0.1",0,<localPort>,<accessMode>
+        snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",0,%d,0", g_ltem->dataContext, socketId, protoName, host, lclPort);
+        atcmd_tryInvokeAdv(openCmd, ACTION_TIMEOUTml, s_tcpudpOpenCompleteParser);
+        break;
+
+    default:
+        return RESULT_CODE_BADREQUEST;
+    }
+
+    // snprintf(openCmd, SOCKETS_CMDBUF_SZ, "AT+QIOPEN=%d,%d,\"%s\",\"%s\",%d", g_ltem->dataContext, socketId, protoName, host, rmtPort);
+    // atcmd_tryInvokeAdv(openCmd, ACTION_LOCKRETRIES, ACTION_TIMEOUT_DEFAULTmillis, s_tcpudpOpenCompleteParser);
+
+    // await result of open from inside switch() above
+    atcmdResult_t atResult = atcmd_awaitResult(true);
+
+    // finish initialization and run background tasks to prime data pipeline
+    if (atResult.statusCode == RESULT_CODE_SUCCESS || atResult.statusCode == SOCKET_RESULT_PREVOPEN)
+    {
+        scktPtr->socketCtrls[socketId].protocol = protocol;
+        scktPtr->socketCtrls[socketId].socketId = socketId;
+        scktPtr->socketCtrls[socketId].open = true;
+        scktPtr->socketCtrls[socketId].receiver_func = rcvr_func;
+    }
+
+    else        // failed to open, reset peerMap bits and release TLS context
+    {
+        iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket & ~socketBitMap;
+        iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket & ~socketBitMap;
+        if (scktPtr->socketCtrls[socketId].tlsContextId != TLS_CONTEXT_NONE)
+        {
+            tls_releaseContext(scktPtr->socketCtrls[socketId].tlsContextId);
+            scktPtr->socketCtrls[socketId].tlsContextId = TLS_CONTEXT_NONE;
+        }
+    }
+
+    if (atResult.statusCode == SOCKET_RESULT_PREVOPEN)
+    {
+        scktPtr->socketCtrls[socketId].flushing = cleanSession;
+        scktPtr->socketCtrls[socketId].dataPending = true;
+        PRINTF(DBGCOLOR_white, "Priming rxStream sckt=%d\r", socketId);
+        sckt_doWork();
+    }
+    return atResult.statusCode;
+}
+
+
+/**
+ *  \brief [private] Parse a remote peer into socket control:  "<rmtAddr>",<rmtPort>  (UDP service IRD header, incoming URC)
+ * 
+ *  \return Pointer to the char following the port (IRD header: the CRLF, same as TCP/UDP header parse position).
+*/
+static char *s_parseRmtAddr(socketCtrl_t *socketCtrl, const char *addrField)
+{
+    const char *addrAt = addrField + 1;                                 // past opening quote
+    char *addrEnd = strchr(addrAt, ASCII_cDBLQUOTE);
+    if (addrEnd == NULL)
+        return (char *)addrField;
+
+    uint8_t addrSz = MIN(addrEnd - addrAt, SOCKET_ADDRSZ - 1);
+    memcpy(socketCtrl->rmtAddr, addrAt, addrSz);
+    socketCtrl->rmtAddr[addrSz] = ASCII_cNULL;
+
+    char *endPtr;
+    socketCtrl->rmtPort = strtol(addrEnd + 2, &endPtr, 10);            // past closing quote and comma
+    return endPtr;
+}
+
+
+/**
+ *  \brief [private] Reset socket control to closed, releasing any IRD data buffer held for the socket.
+*/
+static void s_resetSocketCtrl(socketId_t socketId)
+{
+    socketCtrl_t *sckt = (socketCtrl_t *)&scktPtr->socketCtrls[socketId];
+
+    if (sckt->dataBufferIndx != IOP_NO_BUFFER)                  // connection churn: don't strand a data buffer on a closed socket
+        iop_resetDataBuffer(sckt->dataBufferIndx);
+    if (sckt->tlsContextId != TLS_CONTEXT_NONE)                 // context keeps options\session cache, reacquire with equal options resumes
+    {
+        tls_releaseContext(sckt->tlsContextId);
+        sckt->tlsContextId = TLS_CONTEXT_NONE;
+    }
+    s_clearSocketCtrl(socketId);
+}
+
+
+/**
+ *  \brief [private] Clear socket control to closed, without releasing an IOP data buffer (safe in ISR context).
+*/
+static void s_clearSocketCtrl(socketId_t socketId)
+{
+    uint8_t socketBitMap = 0x01 << socketId;
+    socketCtrl_t *sckt = (socketCtrl_t *)&scktPtr->socketCtrls[socketId];
+
+    iopPtr->peerTypeMap.tcpudpSocket = iopPtr->peerTypeMap.tcpudpSocket & ~socketBitMap;
+    iopPtr->peerTypeMap.sslSocket = iopPtr->peerTypeMap.sslSocket & ~socketBitMap;
+
+    sckt->protocol = protocol_void;
+    sckt->socketId = socketId;
+    sckt->open = false;
+    sckt->flushing = false;
+    sckt->dataPending = false;
+    sckt->dataBufferIndx = IOP_NO_BUFFER;
+    sckt->receiver_func = NULL;
+    sckt->datagramRcvr_func = NULL;
+    sckt->accept_func = NULL;
+    sckt->listenerId = SOCKET_NOLISTENER;
+    sckt->acceptPending = false;
+    sckt->closePending = false;
+    sckt->rmtAddr[0] = ASCII_cNULL;
+    sckt->rmtPort = 0;
+    sckt->health = socketHealth_ok;
+    sckt->healthReported = false;
+    sckt->closed_func = NULL;
+}
+
+
+/**
+ *  \brief [private] Query state of all TCP/UDP sockets on the data context, open sockets not reported connected are dead.
+ *  Response lines are captured by the ISR (sckt__stateCapture), the command buffer can't hold a full response.
+*/
+static void s_queryStates()
+{
+    char stateCmd[DFLT_ATBUFSZ] = {0};
+
+    snprintf(stateCmd, DFLT_ATBUFSZ, "AT+QISTATE=0,%d", g_ltem->dataContext);
+    scktPtr->stateSeenMap = 0;
+    iopPtr->peerTypeMap.socketState = 1;
+    if (!atcmd_tryInvoke(stateCmd))
+    {
+        iopPtr->peerTypeMap.socketState = 0;
+        return;
+    }
+    atcmdResult_t atResult = atcmd_awaitResult(true);
+    iopPtr->peerTypeMap.socketState = 0;
+    scktPtr->healthCheckAt = lMillis();
+    if (atResult.statusCode != RESULT_CODE_SUCCESS)
+        return;
+
+    for (uint8_t sckt = 0; sckt < IOP_SOCKET_COUNT; sckt++)
+    {
+        if ((iopPtr->peerTypeMap.tcpudpSocket & (0x01 << sckt)) && 
+            !(scktPtr->stateSeenMap & (0x01 << sckt)) &&
+            scktPtr->socketCtrls[sckt].health == socketHealth_ok)
+        {
+            scktPtr->socketCtrls[sckt].health = socketHealth_notConnected;
+        }
+    }
+}
+
+
 /**
  *  \brief [private] Invoke IRD command to request BGx for socket (read) data
 */
@@ -31,15 +31,16 @@
 #include "ltemc.h"
 
 
-/* future may support incoming connections, network carriers do not support this without premium plans or VPNs
- * today LooUQ Cloud supports this via an alternate pattern. 
- * typedef void (*receiver_func_t)(socketId_t scktId, const char * data, uint16_t dataSz, const char * rmtHost, const char * rmtPort);
-*/
-
 #define SOCKET_COUNT 6
 #define SOCKET_CLOSED 255
 #define SOCKET_RESULT_PREVOPEN 563
 #define SOCKET_SEND_RETRIES 3
+#define SOCKET_ADDRSZ 40                    ///< Remote IP address string (IPv6 max 39 chars)
+#define SOCKET_NOLISTENER 255               ///< Socket is not an accepted (incoming) connection
+#define SOCKET_BGX_CONNECTCNT 12            ///< BGx connection IDs (0-11), incoming connections above SOCKET_COUNT are refused
+#define SOCKET_KEEPALIVE_IDLEmin 2          ///< TCP keepalive defaults: idle time before first probe (BGx 1-120 minutes)
+#define SOCKET_KEEPALIVE_INTERVALsec 30     ///< probe interval (BGx 25-100 seconds)
+#define SOCKET_KEEPALIVE_PROBES 3           ///< unanswered probes before connection is dropped (BGx 3-10)
 
 typedef uint8_t socketId_t; 
 typedef uint16_t socketResult_t;
@@ -49,6 +50,32 @@ typedef uint16_t socketResult_t;
 */
 typedef void (*receiver_func_t)(socketId_t scktId, void *data, uint16_t dataSz);
 
+/** 
+ *  \brief typedef for the UDP service data receiver function, invoked for each datagram with the sender's address.
+*/
+typedef void (*datagramReceiver_func_t)(socketId_t scktId, void *data, uint16_t dataSz, const char *rmtAddr, uint16_t rmtPort);
+
+/** 
+ *  \brief typedef for the TCP listener accept function, invoked (from doWork) for each incoming connection. Return false to refuse (close) it.
+*/
+typedef bool (*acceptConnection_func_t)(socketId_t listenerId, socketId_t scktId, const char *rmtAddr, uint16_t rmtPort);
+
+
+/** 
+ *  \brief Health of an open socket, as reported by BGx (URC) or found by the health monitor state query.
+*/
+typedef enum socketHealth_tag
+{
+    socketHealth_ok = 0,                ///< No failure detected.
+    socketHealth_peerClosed = 1,        ///< Remote peer closed the connection (+QIURC\+QSSLURC "closed").
+    socketHealth_notConnected = 2       ///< Periodic state query found socket not connected (silent drop: NAT timeout, keepalive failure).
+} socketHealth_t;
+
+/** 
+ *  \brief typedef for the socket health callback, invoked (from doWork) once when an open socket is found dead. Application should close the socket.
+*/
+typedef void (*socketHealth_func_t)(socketId_t scktId, socketHealth_t health);
+
 
 /** 
  *  \brief Struct representing the state of a TCP/UDP/SSL socket connection.
@@ -62,7 +89,18 @@ typedef struct socketCtrl_tag
     bool dataPending;               ///< The data pipeline has data (or the likelihood of data), triggered when BGx reports data pending (URC "recv").
     uint8_t dataBufferIndx;         ///< buffer indx holding data 
     uint8_t pdpContextId;           ///< Which network context is this data flow associated with.
+    uint8_t tlsContextId;           ///< SSL context (tls manager) for SSL sockets, held across reopen for session resumption.
     receiver_func_t receiver_func;  ///< Data receive function for socket data. This func is invoked for every receive event.
+    datagramReceiver_func_t datagramRcvr_func;  ///< UDP service: data receive function, with sender address.
+    acceptConnection_func_t accept_func;        ///< TCP listener: application accept function for incoming connections.
+    socketId_t listenerId;          ///< Accepted connection: listener the connection arrived on, SOCKET_NOLISTENER for other sockets.
+    bool acceptPending;             ///< Accepted connection: reported by BGx, application accept function not yet invoked.
+    bool closePending;              ///< Socket refused\dropped, close retried from doWork until action lock is available.
+    socketHealth_t health;          ///< Socket failure detected by URC or health monitor, sends fail fast (410) until closed.
+    bool healthReported;            ///< Application health callback invoked for current failure.
+    socketHealth_func_t closed_func;            ///< Protocol module (HTTP session) owning the socket, notified of failure in place of the application.
+    char rmtAddr[SOCKET_ADDRSZ];    ///< UDP service: sender of datagram being received (parsed from IRD header). Accepted connection: remote peer.
+    uint16_t rmtPort;               ///< UDP service: sender port. Accepted connection: remote peer port.
 } socketCtrl_t;
 
 
@@ -72,6 +110,14 @@ typedef struct socketCtrl_tag
 typedef volatile struct sockets_tag
 {
     socketCtrl_t socketCtrls[SOCKET_COUNT];   ///< Array of socket connections.
+    bool incomingFull;                        ///< BGx refused an incoming connection, no free connection IDs.
+    uint16_t refusedMap;                      ///< Bit-map of BGx connection IDs accepted by BGx without a socket control (ID >= SOCKET_COUNT, no listener), pending close.
+    uint8_t staleBufferMap;                   ///< Bit-map of IOP data buffers held by a replaced socket, released in doWork.
+    socketHealth_func_t health_func;          ///< Application callback for dead sockets.
+    uint32_t healthCheckPeriod;               ///< Health monitor state query period (millis), 0 = URC notifications only.
+    uint32_t healthCheckAt;                   ///< Tick count of last state query.
+    uint8_t stateSeenMap;                     ///< Bit-map of sockets reported connected\listening by current state query.
+    bool keepaliveSet;                        ///< TCP keepalive configured (sckt_setKeepalive), defaults not applied by health monitor.
 } sockets_t;
 
 
@@ -82,17 +128,30 @@ extern "C"
 
 
 void sckt_create();
+void sckt_setTlsContext(socketId_t socketId, uint8_t tlsContextId);
 
 socketResult_t sckt_open(socketId_t socketId, protocol_t protocol, const char *host, uint16_t rmtPort, uint16_t lclPort, bool cleanSession, receiver_func_t rcvr_func);
+socketResult_t sckt_openService(socketId_t socketId, protocol_t protocol, uint16_t lclPort, datagramReceiver_func_t rcvr_func);
+socketResult_t sckt_listen(socketId_t socketId, uint16_t lclPort, acceptConnection_func_t accept_func, receiver_func_t rcvr_func);
 void sckt_close(uint8_t socketId);
 bool sckt_flush(uint8_t socketId);
 void sckt_closeAll(uint8_t contxtId);
 
 bool sckt_getState(uint8_t socketId);
+resultCode_t sckt_setHealthMonitor(uint16_t checkPeriodSec, socketHealth_func_t health_func);
+resultCode_t sckt_setKeepalive(bool enable, uint8_t idleMinutes, uint8_t intervalSeconds, uint8_t probeCnt);
+socketHealth_t sckt_getHealth(socketId_t socketId);
 
 socketResult_t sckt_send(socketId_t socketId, const char *data, uint16_t dataSz);
+socketResult_t sckt_sendTo(socketId_t socketId, const char *rmtAddr, uint16_t rmtPort, const char *data, uint16_t dataSz);
 void sckt_doWork();
 
+// semi-private functions, not intended for most application but not static for special needs
+void sckt__urcIncoming(const char *urcData, uint16_t dataSz);
+void sckt__urcClosed(socketId_t socketId);
+void sckt__setClosedFunc(socketId_t socketId, socketHealth_func_t closed_func);
+uint16_t sckt__stateCapture(char *respData, uint16_t respSz);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,265 @@
+/******************************************************************************
+ *  \file ltemc-tls.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * TLS (SSL) context manager: assigns and reuses BGx SSL contexts, configures
+ * security options and session resumption, stores certificates in UFS.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-tls.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define TLS_CMD_SZ 81
+#define TLS_SESSIONCFG "session_cache"      ///< QSSLCFG session resumption option, rejected by firmware without support
+
+static tlsContext_t tlsContexts[TLS_CONTEXT_CNT];
+
+
+// private local declarations
+static resultCode_t s_configure(uint8_t contextId);
+static resultCode_t s_sendCfg(const char *cfgCmd);
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Initialize TLS options to defaults: no authentication, ignore local time, session resumption enabled.
+ *
+ *  \param options [out] - Options struct, cleared so options can be compared for context sharing.
+ *  \param version [in] - SSL\TLS protocol version.
+ */
+void tls_initOptions(tlsOptions_t *options, sslVersion_t version)
+{
+    memset(options, 0, sizeof(tlsOptions_t));
+    options->version = version;
+    options->secLevel = tlsSecurityLevel_none;
+    options->ignoreLocalTime = true;
+    options->sessionResume = true;
+}
+
+
+/**
+ *	\brief Get a BGx SSL context for the options. A context previously assigned equal options is reused (BGx session cache 
+ *  is retained with the context), otherwise a free context is assigned and configured.
+ *
+ *  \param options [in] - TLS options, from tls_initOptions().
+ * 
+ *  \return SSL context ID (sslctxID) for QSSLOPEN\QMTCFG\QHTTPCFG, TLS_CONTEXT_NONE if no context available or configure failed.
+ */
+uint8_t tls_acquireContext(const tlsOptions_t *options)
+{
+    uint8_t contextId = TLS_CONTEXT_NONE;
+
+    for (size_t i = 0; i < TLS_CONTEXT_CNT; i++)                        // reuse context with equal options
+    {
+        if (tlsContexts[i].assigned && memcmp(&tlsContexts[i].options, options, sizeof(tlsOptions_t)) == 0)
+        {
+            contextId = i;
+            break;
+        }
+    }
+    for (size_t i = 0; i < TLS_CONTEXT_CNT && contextId == TLS_CONTEXT_NONE; i++)    // unassigned context
+    {
+        if (!tlsContexts[i].assigned)
+            contextId = i;
+    }
+    for (size_t i = 0; i < TLS_CONTEXT_CNT && contextId == TLS_CONTEXT_NONE; i++)    // released context, options replaced
+    {
+        if (tlsContexts[i].useCnt == 0)
+            contextId = i;
+    }
+    if (contextId == TLS_CONTEXT_NONE)
+        return TLS_CONTEXT_NONE;
+
+    tlsContext_t *context = &tlsContexts[contextId];
+    if (!context->assigned || memcmp(&context->options, options, sizeof(tlsOptions_t)) != 0)
+    {
+        memcpy(&context->options, options, sizeof(tlsOptions_t));
+        context->assigned = true;
+        context->configured = false;
+    }
+    if (!context->configured && s_configure(contextId) != RESULT_CODE_SUCCESS)
+        return TLS_CONTEXT_NONE;
+
+    context->useCnt++;
+    return contextId;
+}
+
+
+/**
+ *	\brief Release a context acquired with tls_acquireContext(). The context keeps its options (and BGx session cache) and is 
+ *  reused by a later acquire with equal options unless it is needed for other options.
+ */
+void tls_releaseContext(uint8_t contextId)
+{
+    if (contextId < TLS_CONTEXT_CNT && tlsContexts[contextId].useCnt > 0)
+        tlsContexts[contextId].useCnt--;
+}
+
+
+/**
+ *	\brief Test if BGx accepted session resumption for the context.
+ */
+bool tls_isSessionResume(uint8_t contextId)
+{
+    return contextId < TLS_CONTEXT_CNT && tlsContexts[contextId].sessionResume;
+}
+
+
+/**
+ *	\brief Store a certificate (or key) in BGx UFS for use in TLS options. A file with the same name and size is assumed 
+ *  current and is not rewritten, so certificates compiled into the application are written to flash once.
+ *
+ *  \param fileName [in] - UFS file name.
+ *  \param certData [in] - Certificate (PEM) content.
+ *  \param certSz [in] - Size of certificate content.
+ * 
+ *  \return 200 if stored, 202 if already stored, otherwise file error code.
+ */
+resultCode_t tls_storeCert(const char *fileName, const char *certData, uint16_t certSz)
+{
+    fileListResult_t listResult = filsys_list(fileName);
+    if (listResult.resultCode == RESULT_CODE_SUCCESS && listResult.fileCnt == 1 && listResult.fileList[0].fileSize == certSz)
+        return RESULT_CODE_ACCEPTED;
+
+    fileOpenResult_t openResult = filsys_open(fileName, fileOpenMode_clearRdWr, NULL);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+
+    resultCode_t rslt = RESULT_CODE_SUCCESS;
+    for (uint16_t writtenSz = 0; writtenSz < certSz && rslt == RESULT_CODE_SUCCESS; )
+    {
+        fileWriteResult_t writeResult = filsys_write(openResult.fileHandle, certData + writtenSz, MIN(TLS_CERT_WRITESZ, certSz - writtenSz));
+        rslt = writeResult.resultCode;
+        writtenSz += writeResult.writtenSz;
+        if (rslt == RESULT_CODE_SUCCESS && writeResult.writtenSz == 0)
+            rslt = RESULT_CODE_ERROR;
+    }
+    filsys_close(openResult.fileHandle);
+
+    if (rslt != RESULT_CODE_SUCCESS)
+        filsys_delete(fileName);                                        // partial certificate would otherwise be taken as current
+    return rslt;
+}
+
+
+/**
+ *	\brief Mark all contexts as not configured, BGx SSL configuration is lost when BGx restarts. Contexts are reconfigured on 
+ *  next acquire.
+ */
+void tls__resetContexts()
+{
+    for (size_t i = 0; i < TLS_CONTEXT_CNT; i++)
+    {
+        tlsContexts[i].configured = false;
+        tlsContexts[i].sessionResume = false;
+    }
+}
+
+#pragma endregion
+
+
+/* private functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief [private] Send context options to BGx (QSSLCFG). Session resumption is optional, failure leaves full handshakes.
+ */
+static resultCode_t s_configure(uint8_t contextId)
+{
+    char cfgCmd[TLS_CMD_SZ] = {0};
+    tlsContext_t *context = &tlsContexts[contextId];
+    tlsOptions_t *options = &context->options;
+
+    snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"sslversion\",%d,%d", contextId, options->version);
+    resultCode_t rslt = s_sendCfg(cfgCmd);
+
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"seclevel\",%d,%d", contextId, options->secLevel);
+        rslt = s_sendCfg(cfgCmd);
+    }
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"ignorelocaltime\",%d,%d", contextId, options->ignoreLocalTime);
+        rslt = s_sendCfg(cfgCmd);
+    }
+    if (rslt == RESULT_CODE_SUCCESS && options->caCert[0] != ASCII_cNULL)
+    {
+        snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"cacert\",%d,\"UFS:%s\"", contextId, options->caCert);
+        rslt = s_sendCfg(cfgCmd);
+    }
+    if (rslt == RESULT_CODE_SUCCESS && options->clientCert[0] != ASCII_cNULL)
+    {
+        snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"clientcert\",%d,\"UFS:%s\"", contextId, options->clientCert);
+        rslt = s_sendCfg(cfgCmd);
+    }
+    if (rslt == RESULT_CODE_SUCCESS && options->clientKey[0] != ASCII_cNULL)
+    {
+        snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"clientkey\",%d,\"UFS:%s\"", contextId, options->clientKey);
+        rslt = s_sendCfg(cfgCmd);
+    }
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    snprintf(cfgCmd, TLS_CMD_SZ, "AT+QSSLCFG=\"%s\",%d,%d", TLS_SESSIONCFG, contextId, options->sessionResume);
+    context->sessionResume = s_sendCfg(cfgCmd) == RESULT_CODE_SUCCESS && options->sessionResume;
+    PRINTF(dbgColor_info, "tls: ctx=%d configured, resume=%d\r", contextId, context->sessionResume);
+
+    context->configured = true;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief [private] Send a QSSLCFG command and await result.
+ */
+static resultCode_t s_sendCfg(const char *cfgCmd)
+{
+    if (atcmd_tryInvoke(cfgCmd))
+        return atcmd_awaitResult(true).statusCode;
+    return RESULT_CODE_CONFLICT;
+}
+
+#pragma endregion
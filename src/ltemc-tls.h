@@ -0,0 +1,111 @@
+/******************************************************************************
+ *  \file ltemc-tls.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * TLS (SSL) context manager: assigns and reuses BGx SSL contexts, configures
+ * security options and session resumption, stores certificates in UFS.
+ *****************************************************************************/
+
+#ifndef __LTEMC_TLS_H__
+#define __LTEMC_TLS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TLS_CONTEXT_CNT 6                   ///< BGx SSL contexts (sslctxID 0-5)
+#define TLS_CONTEXT_NONE 255                ///< No context assigned
+#define TLS_CERTNAME_SZ 41                  ///< Max certificate\key UFS file name
+#define TLS_CERT_WRITESZ 1024               ///< Certificate is written to UFS in chunks of this size
+
+
+/** 
+ *  \brief Enum of available SSL version options for an SSL connection. 
+*/
+typedef enum sslVersion_tag 
+{
+    sslVersion_none = 255,          ///< Not set
+    sslVersion_ssl30 = 0,           ///< Require SSL v3.0 
+    sslVersion_tls10 = 1,           ///< Require TLS v1.0
+    sslVersion_tls11 = 2,           ///< Require TLS v1.1
+    sslVersion_tls12 = 3,           ///< Require TLS v1.2
+    sslVersion_any = 4              ///< Any SSL/TLS version is acceptable.
+} sslVersion_t;
+
+
+/** 
+ *  \brief Enum of TLS authentication (BGx seclevel) options.
+*/
+typedef enum tlsSecurityLevel_tag
+{
+    tlsSecurityLevel_none = 0,              ///< No authentication
+    tlsSecurityLevel_server = 1,            ///< Verify server certificate (caCert required)
+    tlsSecurityLevel_mutual = 2             ///< Verify server and present client certificate (all certificates required)
+} tlsSecurityLevel_t;
+
+
+/** 
+ *  \brief Struct of options for a TLS context. Initialize with tls_initOptions(), contexts are shared by connections with equal options.
+*/
+typedef struct tlsOptions_tag
+{
+    sslVersion_t version;                   ///< SSL\TLS protocol version
+    tlsSecurityLevel_t secLevel;            ///< Authentication level
+    char caCert[TLS_CERTNAME_SZ];           ///< UFS file name of trusted CA certificate, empty if not used
+    char clientCert[TLS_CERTNAME_SZ];       ///< UFS file name of client certificate, empty if not used
+    char clientKey[TLS_CERTNAME_SZ];        ///< UFS file name of client private key, empty if not used
+    bool ignoreLocalTime;                   ///< Ignore certificate validity dates (BGx clock may not be set)
+    bool sessionResume;                     ///< Cache TLS session (ID\ticket) for abbreviated handshake on reconnect
+} tlsOptions_t;
+
+
+/** 
+ *  \brief Struct for the state of a BGx SSL context.
+*/
+typedef struct tlsContext_tag
+{
+    tlsOptions_t options;                   ///< Options assigned to context
+    bool assigned;                          ///< Context has options, retained after release for reuse with equal options
+    uint8_t useCnt;                         ///< Connections holding the context (acquire\release)
+    bool configured;                        ///< Options sent to BGx, since BGx start
+    bool sessionResume;                     ///< BGx accepted session resumption option
+} tlsContext_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void tls_initOptions(tlsOptions_t *options, sslVersion_t version);
+uint8_t tls_acquireContext(const tlsOptions_t *options);
+void tls_releaseContext(uint8_t contextId);
+bool tls_isSessionResume(uint8_t contextId);
+resultCode_t tls_storeCert(const char *fileName, const char *certData, uint16_t certSz);
+
+// semi-private functions, not intended for most application but not static for special needs
+void tls__resetContexts();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_TLS_H__
@@ -0,0 +1,409 @@
+/******************************************************************************
+ *  \file ltemc-tracklog.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * GNSS track log: fixes are delta/varint encoded into blocks and stored in a
+ * BGx UFS file, blocks are streamed to the application for upload.
+ *****************************************************************************/
+
+#define _DEBUG 0                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+#include "ltemc.h"
+#include "ltemc-tracklog.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+static trklog_t trklog;
+
+
+// private local declarations
+static void s_fileRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz);
+static uint32_t s_locationTime(const gnssLocation_t *location);
+static uint8_t s_encodeVarint(uint32_t value, char *dest);
+static const char *s_decodeVarint(const char *src, const char *srcEnd, uint32_t *value);
+
+
+/* public functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region public functions
+
+
+/**
+ *	\brief Open (or create) the track log file in BGx UFS.
+ *
+ *  \param fileName [in] - UFS file name for the log.
+ *  \param append [in] - Add points to existing log content, otherwise the log is cleared.
+ * 
+ *  \return 200 if opened, otherwise error code (HTTP status type).
+ */
+resultCode_t trklog_open(const char *fileName, bool append)
+{
+    memset(&trklog, 0, sizeof(trklog_t));
+    trklog.blockSz = TRKLOG_BLOCKHDRSZ;
+
+    fileOpenResult_t openResult = filsys_open(fileName, append ? fileOpenMode_normalRdWr : fileOpenMode_clearRdWr, s_fileRecvr);
+    if (openResult.resultCode != RESULT_CODE_SUCCESS)
+        return openResult.resultCode;
+    trklog.fileHandle = openResult.fileHandle;
+    trklog.isOpen = true;
+
+    resultCode_t rslt = filsys_seek(trklog.fileHandle, 0, fileSeekMode_seekFromEnd);
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        filePositionResult_t posResult = filsys_getPosition(trklog.fileHandle);
+        trklog.fileSz = posResult.fileOffset;
+        rslt = posResult.resultCode;
+    }
+    if (rslt != RESULT_CODE_SUCCESS)                                    // size unknown, appends would misplace blocks
+    {
+        filsys_close(trklog.fileHandle);
+        trklog.isOpen = false;
+    }
+    return rslt;
+}
+
+
+/**
+ *	\brief Append a GNSS fix to the log. The point is encoded into the current block, the block is written to the file when full.
+ *
+ *  \param location [in] - GNSS fix (gnss_getLocation() or streamed), fixes without statusCode 200 are ignored.
+ * 
+ *  \return 200 if appended (or ignored), 412 if log not open, otherwise the file write error code.
+ */
+resultCode_t trklog_append(const gnssLocation_t *location)
+{
+    if (!trklog.isOpen)
+        return RESULT_CODE_PRECONDFAILED;
+    if (location->statusCode != RESULT_CODE_SUCCESS)
+        return RESULT_CODE_SUCCESS;
+
+    if (trklog.blockSz + TRKLOG_POINT_MAXSZ > TRKLOG_BLOCKSZ)
+    {
+        resultCode_t rslt = trklog_flush();
+        if (rslt != RESULT_CODE_SUCCESS)
+            return rslt;
+    }
+
+    trklogPoint_t point;
+    point.time = s_locationTime(location);
+    point.lat = location->lat.val;
+    point.lon = location->lon.val;
+    point.speedkm = location->speedkm;
+    point.course = location->course;
+
+    trklog.blockSz += trklog__encodePoint(&point, &trklog.prevPoint, trklog.block + trklog.blockSz);
+    trklog.prevPoint = point;
+    trklog.pointCnt++;
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief Write the current (partial) block to the log file. The next point starts a new block.
+ *
+ *  \return 200 if written (or block empty), otherwise the file write error code.
+ */
+resultCode_t trklog_flush()
+{
+    if (!trklog.isOpen)
+        return RESULT_CODE_PRECONDFAILED;
+    if (trklog.blockSz == TRKLOG_BLOCKHDRSZ)
+        return RESULT_CODE_SUCCESS;
+
+    uint16_t payloadSz = trklog.blockSz - TRKLOG_BLOCKHDRSZ;
+    trklog.block[0] = payloadSz & 0xFF;
+    trklog.block[1] = payloadSz >> 8;
+
+    fileWriteResult_t writeResult = filsys_write(trklog.fileHandle, trklog.block, trklog.blockSz);
+    if (writeResult.resultCode != RESULT_CODE_SUCCESS)
+        return writeResult.resultCode;
+
+    trklog.fileSz += writeResult.writtenSz;
+    trklog.blockSz = TRKLOG_BLOCKHDRSZ;
+    memset(&trklog.prevPoint, 0, sizeof(trklogPoint_t));                // next point is a keyframe
+    return RESULT_CODE_SUCCESS;
+}
+
+
+/**
+ *	\brief Stream the log to the application send function, one block per send. Each block is independently decodable 
+ *  (trklog_decode) by the receiver. The current block is flushed first.
+ * 
+ *  The send function is invoked between file reads (no AT action is open), so it can send with sckt_send() or mqtt_publishBin().
+ *
+ *  \param sendFunc [in] - Application function to send a block.
+ * 
+ *  \return 200 if all blocks sent, otherwise the send or file error code. Log content is retained, see trklog_clear().
+ */
+resultCode_t trklog_stream(trklogSend_func sendFunc)
+{
+    resultCode_t rslt = trklog_flush();
+    if (rslt != RESULT_CODE_SUCCESS)
+        return rslt;
+
+    rslt = filsys_seek(trklog.fileHandle, 0, fileSeekMode_seekFromBegin);
+    uint32_t streamedSz = 0;
+
+    while (rslt == RESULT_CODE_SUCCESS && streamedSz < trklog.fileSz)
+    {
+        trklog.readSz = 0;
+        rslt = filsys_read(trklog.fileHandle, TRKLOG_BLOCKHDRSZ);       // block header
+        if (rslt != RESULT_CODE_SUCCESS)
+            break;
+
+        uint16_t payloadSz = (uint8_t)trklog.readBuf[0] | ((uint8_t)trklog.readBuf[1] << 8);
+        if (trklog.readSz != TRKLOG_BLOCKHDRSZ || payloadSz > TRKLOG_BLOCKSZ - TRKLOG_BLOCKHDRSZ)
+        {
+            rslt = RESULT_CODE_ERROR;                                   // corrupt log
+            break;
+        }
+        rslt = filsys_read(trklog.fileHandle, payloadSz);
+        if (rslt != RESULT_CODE_SUCCESS)
+            break;
+        if (trklog.readSz != TRKLOG_BLOCKHDRSZ + payloadSz)
+        {
+            rslt = RESULT_CODE_ERROR;
+            break;
+        }
+        rslt = sendFunc(trklog.readBuf, trklog.readSz);
+        streamedSz += trklog.readSz;
+    }
+
+    resultCode_t seekRslt = filsys_seek(trklog.fileHandle, 0, fileSeekMode_seekFromEnd);   // restore append position
+    return (rslt == RESULT_CODE_SUCCESS) ? seekRslt : rslt;
+}
+
+
+/**
+ *	\brief Clear the log content (typically following a successful trklog_stream()).
+ *
+ *  \return 200 if cleared, otherwise the file error code.
+ */
+resultCode_t trklog_clear()
+{
+    if (!trklog.isOpen)
+        return RESULT_CODE_PRECONDFAILED;
+
+    resultCode_t rslt = filsys_seek(trklog.fileHandle, 0, fileSeekMode_seekFromBegin);
+    if (rslt == RESULT_CODE_SUCCESS)
+        rslt = filsys_truncate(trklog.fileHandle);
+    if (rslt == RESULT_CODE_SUCCESS)
+    {
+        trklog.fileSz = 0;
+        trklog.blockSz = TRKLOG_BLOCKHDRSZ;
+        memset(&trklog.prevPoint, 0, sizeof(trklogPoint_t));
+    }
+    return rslt;
+}
+
+
+/**
+ *	\brief Flush the current block and close the log file.
+ */
+resultCode_t trklog_close()
+{
+    if (!trklog.isOpen)
+        return RESULT_CODE_SUCCESS;
+
+    resultCode_t rslt = trklog_flush();
+    resultCode_t closeRslt = filsys_close(trklog.fileHandle);
+    trklog.isOpen = false;
+    return (rslt == RESULT_CODE_SUCCESS) ? closeRslt : rslt;
+}
+
+
+/**
+ *	\brief Get the number of points appended since the log was opened.
+ */
+uint32_t trklog_getPointCnt()
+{
+    return trklog.pointCnt;
+}
+
+
+/**
+ *	\brief Decode a block (as streamed, including header) into points. Portable C, intended for use by the receiving service as well.
+ *
+ *  \param blockData [in] - Block, starting with the size header.
+ *  \param blockSz [in] - Size of blockData.
+ *  \param points [out] - Array to receive decoded points.
+ *  \param pointMax [in] - Size of the points array.
+ * 
+ *  \return Number of points decoded.
+ */
+uint16_t trklog_decode(const char *blockData, uint16_t blockSz, trklogPoint_t *points, uint16_t pointMax)
+{
+    if (blockSz < TRKLOG_BLOCKHDRSZ)
+        return 0;
+
+    uint16_t payloadSz = (uint8_t)blockData[0] | ((uint8_t)blockData[1] << 8);
+    const char *src = blockData + TRKLOG_BLOCKHDRSZ;
+    const char *srcEnd = src + MIN(payloadSz, blockSz - TRKLOG_BLOCKHDRSZ);
+    trklogPoint_t prevPoint = {0};
+    uint32_t fields[5];
+    uint16_t pointCnt = 0;
+
+    while (src < srcEnd && pointCnt < pointMax)
+    {
+        for (size_t i = 0; i < 5 && src != NULL; i++)
+        {
+            src = s_decodeVarint(src, srcEnd, &fields[i]);
+        }
+        if (src == NULL)                                                // truncated point
+            break;
+
+        prevPoint.time += fields[0];                                    // zigzag decode for signed fields: (n >> 1) ^ -(n & 1)
+        prevPoint.lat += (int32_t)((fields[1] >> 1) ^ -(fields[1] & 1));
+        prevPoint.lon += (int32_t)((fields[2] >> 1) ^ -(fields[2] & 1));
+        prevPoint.speedkm += (int32_t)((fields[3] >> 1) ^ -(fields[3] & 1));
+        prevPoint.course += (int32_t)((fields[4] >> 1) ^ -(fields[4] & 1));
+        points[pointCnt++] = prevPoint;
+    }
+    return pointCnt;
+}
+
+
+/**
+ *	\brief Encode a point as deltas from the previous point.
+ *
+ *  \param point [in] - Point to encode.
+ *  \param prevPoint [in] - Previous point, zeroed for a keyframe.
+ *  \param dest [out] - Destination, must have TRKLOG_POINT_MAXSZ available.
+ * 
+ *  \return Encoded size.
+ */
+uint8_t trklog__encodePoint(const trklogPoint_t *point, const trklogPoint_t *prevPoint, char *dest)
+{
+    int32_t deltas[4];
+    deltas[0] = (int32_t)((uint32_t)point->lat - (uint32_t)prevPoint->lat);
+    deltas[1] = (int32_t)((uint32_t)point->lon - (uint32_t)prevPoint->lon);
+    deltas[2] = (int32_t)point->speedkm - prevPoint->speedkm;
+    deltas[3] = (int32_t)point->course - prevPoint->course;
+
+    uint8_t encodedSz = s_encodeVarint(point->time - prevPoint->time, dest);
+    for (size_t i = 0; i < 4; i++)
+    {
+        uint32_t zigzag = ((uint32_t)deltas[i] << 1) ^ (uint32_t)(deltas[i] >> 31);
+        encodedSz += s_encodeVarint(zigzag, dest + encodedSz);
+    }
+    return encodedSz;
+}
+
+
+#pragma endregion
+
+
+/* private (static) functions
+ * --------------------------------------------------------------------------------------------- */
+#pragma region private functions
+
+
+/**
+ *	\brief [private] File read receiver, collects block read from file into readBuf.
+ */
+static void s_fileRecvr(uint16_t fileHandle, void *fileData, uint16_t dataSz)
+{
+    (void)fileHandle;
+    uint16_t copySz = MIN(dataSz, TRKLOG_BLOCKSZ - trklog.readSz);
+    memcpy(trklog.readBuf + trklog.readSz, fileData, copySz);
+    trklog.readSz += copySz;
+}
+
+
+/**
+ *	\brief [private] Get a location's time as seconds from TRKLOG_EPOCH_YEAR; time of day if the location has no date.
+ * 
+ *  UTC format: hhmmss.sss, date format: ddmmyy (2000-2099).
+ */
+static uint32_t s_locationTime(const gnssLocation_t *location)
+{
+    const char *utc = location->utc;
+    uint32_t seconds = ((utc[0] - '0') * 10 + (utc[1] - '0')) * 3600 + 
+                       ((utc[2] - '0') * 10 + (utc[3] - '0')) * 60 + 
+                       ((utc[4] - '0') * 10 + (utc[5] - '0'));
+
+    const char *date = location->date;
+    if (strlen(date) < 6)
+        return seconds;
+
+    static const uint16_t monthDays[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    uint16_t day = (date[0] - '0') * 10 + (date[1] - '0');
+    uint16_t month = (date[2] - '0') * 10 + (date[3] - '0');
+    uint16_t years = (date[4] - '0') * 10 + (date[5] - '0');            // years from 2000
+    if (month < 1 || month > 12)
+        return seconds;
+
+    uint32_t days = years * 365 + (years + 3) / 4 + monthDays[month - 1] + (day - 1);
+    if (month > 2 && years % 4 == 0)
+        days++;
+    return days * 86400 + seconds;
+}
+
+
+/**
+ *	\brief [private] Encode an unsigned varint, 7 bits per byte LSB group first.
+ */
+static uint8_t s_encodeVarint(uint32_t value, char *dest)
+{
+    uint8_t encodedSz = 0;
+    while (value >= 0x80)
+    {
+        dest[encodedSz++] = (char)((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    dest[encodedSz++] = (char)value;
+    return encodedSz;
+}
+
+
+/**
+ *	\brief [private] Decode an unsigned varint.
+ * 
+ *  \return Pointer to char following the varint, NULL if varint is truncated.
+ */
+static const char *s_decodeVarint(const char *src, const char *srcEnd, uint32_t *value)
+{
+    *value = 0;
+    for (uint8_t shift = 0; src < srcEnd && shift < 35; shift += 7)
+    {
+        uint8_t encoded = (uint8_t)*src++;
+        *value |= (uint32_t)(encoded & 0x7F) << shift;
+        if ((encoded & 0x80) == 0)
+            return src;
+    }
+    return NULL;
+}
+
+#pragma endregion
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *  \file ltemc-tracklog.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * GNSS track log: fixes are delta/varint encoded into blocks and stored in a
+ * BGx UFS file, blocks are streamed to the application for upload.
+ *****************************************************************************/
+
+#ifndef __LTEMC_TRACKLOG_H__
+#define __LTEMC_TRACKLOG_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TRKLOG_BLOCKSZ 200                  ///< Block size (with header), a block is written\streamed as a unit
+#define TRKLOG_BLOCKHDRSZ 2                 ///< Block header: payload size, uint16 little-endian
+#define TRKLOG_POINT_MAXSZ 21               ///< Worst case encoded point: 3 x 5 byte varint + 2 x 3 byte varint
+#define TRKLOG_EPOCH_YEAR 2000              ///< Point time is seconds from 2000-01-01 00:00:00 UTC (time of day if no date)
+
+/*  File layout: sequence of blocks, each [size lo][size hi][point]...[point]
+ *  The first point of a block is a keyframe (deltas from 0), following points are deltas from the previous point. Each field
+ *  is a varint (7 bits per byte, LSB group first, high bit = more); signed deltas are zigzag encoded. Field order:
+ *      time (unsigned, seconds), lat (signed, degrees x 1e7), lon (signed, degrees x 1e7), speedkm (signed, Km/h x 100), course (signed, degrees x 100)
+ *  A typical point (1-10 seconds apart, vehicle speeds) encodes in 6-10 bytes vs 60 bytes for a gnssLocation_t.
+ */
+
+
+/** 
+ *  \brief Struct for a track log point, the subset of gnssLocation_t stored in the log.
+*/
+typedef struct trklogPoint_tag
+{
+    uint32_t time;                          ///< Seconds from TRKLOG_EPOCH_YEAR (time of day if fix had no date)
+    int32_t lat;                            ///< Fixed-point degrees x 1e7
+    int32_t lon;                            ///< Fixed-point degrees x 1e7
+    uint16_t speedkm;                       ///< Km/h x 100
+    uint16_t course;                        ///< Degrees x 100
+} trklogPoint_t;
+
+
+/** 
+ *  \brief Typedef for the application's send function, used by trklog_stream(). Typically wraps sckt_send() or mqtt_publishBin().
+ *  \return 200 to continue streaming, otherwise streaming stops and the result is returned by trklog_stream().
+*/
+typedef resultCode_t (*trklogSend_func)(const char *blockData, uint16_t blockSz);
+
+
+/** 
+ *  \brief Struct for the track log state.
+*/
+typedef struct trklog_tag
+{
+    uint16_t fileHandle;                    ///< BGx UFS file handle
+    bool isOpen;
+    char block[TRKLOG_BLOCKSZ];             ///< Block being filled, written to file when full (or flushed)
+    uint16_t blockSz;                       ///< Block bytes used, including header
+    trklogPoint_t prevPoint;                ///< Delta reference, zeroed at block start (keyframe)
+    uint32_t pointCnt;                      ///< Points appended, since open
+    uint32_t fileSz;                        ///< File size, flushed blocks
+    char readBuf[TRKLOG_BLOCKSZ];           ///< Stream: block read from file
+    uint16_t readSz;
+} trklog_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+resultCode_t trklog_open(const char *fileName, bool append);
+resultCode_t trklog_append(const gnssLocation_t *location);
+resultCode_t trklog_flush();
+resultCode_t trklog_stream(trklogSend_func sendFunc);
+resultCode_t trklog_clear();
+resultCode_t trklog_close();
+uint32_t trklog_getPointCnt();
+
+uint16_t trklog_decode(const char *blockData, uint16_t blockSz, trklogPoint_t *points, uint16_t pointMax);
+
+// semi-private functions, not intended for most application but not static for special needs
+uint8_t trklog__encodePoint(const trklogPoint_t *point, const trklogPoint_t *prevPoint, char *dest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // !__LTEMC_TRACKLOG_H__
@@ -48,6 +48,16 @@
 ltemDevice_t *g_ltem;
 
 
+#pragma region private functions
+/* --------------------------------------------------------------------------------------------- */
+
+static void s_bootDoWork();
+static void s_setBootState(ltemBootState_t bootState);
+static void s_bootFailed(const char *failMsg);
+
+#pragma endregion
+
+
 #pragma region public functions
 
 
@@ -80,7 +90,6 @@ void ltem_create(const ltemPinConfig_t ltem_config, appNotify_func appNotifyCB)
     g_ltem->dataContext = 1;
 
     g_ltem->atcmd = calloc(1, sizeof(atcmd_t));
-    g_ltem->atcmd->lastActionError = calloc(1, sizeof(atcmdHistory_t));
     g_ltem->atcmd->isOpen = false;
     g_ltem->cancellationRequest = false;
     g_ltem->appNotifyCB = appNotifyCB;
@@ -94,11 +103,31 @@ void ltem_create(const ltemPinConfig_t ltem_config, appNotify_func appNotifyCB)
 
 
 /**
- *	\brief Power on and start the modem (perform component init).
+ *	\brief Power on and start the modem (perform component init), blocking until the start sequence completes.
  * 
  *  \param protocolBitMap [in] - Binary-OR'd list of expected protocol services to validate inclusion and start.
  */
 void ltem_start(uint16_t protocolBitMap)
+{
+    ltem_startAsync(protocolBitMap, NULL);
+    while (g_ltem->bootState != ltemBootState_ready && g_ltem->bootState != ltemBootState_failed)
+    {
+        s_bootDoWork();
+        lYield();
+    }
+}
+
+
+
+/**
+ *	\brief Begin power on and start of the modem, returning immediately. The sequence is advanced by ltem_doWork().
+ * 
+ *  BGx readiness is signaled by events (status pin edge ISR, APP RDY URC) rather than polled, the host can sleep between steps.
+ * 
+ *  \param protocolBitMap [in] - Binary-OR'd list of expected protocol services to validate inclusion and start.
+ *  \param readyCB [in] - If supplied (not NULL), invoked when the start sequence completes: true=ready, false=BGx failed to start.
+ */
+void ltem_startAsync(uint16_t protocolBitMap, ltemReady_func readyCB)
 {
     // validate create
     if (protocolBitMap != pdpProtocol_none)
@@ -109,22 +138,39 @@ void ltem_start(uint16_t protocolBitMap)
         if (protocolBitMap & pdpProtocol_mqtt && g_ltem->mqtt == NULL)
             ltem_notifyApp(ltemNotifType_hardFault, "No mqtt_create()");
 
-        // if (protos & ltem1Proto_http && g_ltem->http == NULL)
-        //     ltem_notifyApp(ltemNotifType_hardFault, "HTTP noCreate");
+        if (protocolBitMap & pdpProtocol_http && g_ltem->http == NULL)
+            ltem_notifyApp(ltemNotifType_hardFault, "No http_create()");
     }
+    g_ltem->readyCB = readyCB;
+    g_ltem->bootRestarted = false;
+    tls__resetContexts();                                       // BGx SSL configuration is not retained across BGx restart
 
     ltem__initIo();                                             // set host GPIO pins and SPI interface to operating state
     spi_start(g_ltem->spi);
 
-    if (qbg_powerOn())                                          // power on BGx, returning prior power-state
+    if (gpio_readPin(g_ltem->pinConfig.statusPin))
     {
 		PRINTF(DBGCOLOR_info, "LTEm1 found powered on.\r\n");
         g_ltem->qbgReadyState = qbg_readyState_appReady;        // if already "ON", assume running and check for IRQ latched
+        s_setBootState(ltemBootState_powerOn);
+    }
+    else
+    {
+        PRINTF(DBGCOLOR_dGreen, "Powering LTEm1 On...\r");
+        g_ltem->qbgReadyState = qbg_readyState_powerOff;
+        gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_high);
+        s_setBootState(ltemBootState_powerKey);                 // power key released by s_bootDoWork() after QBG_POWERON_DELAY
     }
-    sc16is741a_start();                                         // start (resets previously powered on) NXP SPI-UART bridge
-    iop_start();
-    iop_awaitAppReady();                                        // wait for BGx to signal out firmware ready
-    qbg_start();                                                // initialize BGx operating settings
+}
+
+
+
+/**
+ *	\brief Get the progress of the LTEm start sequence.
+ */
+ltemBootState_t ltem_getBootState()
+{
+    return g_ltem->bootState;
 }
 
 
@@ -167,8 +213,9 @@ qbgReadyState_t ltem_getReadyState()
  */
 void ltem_stop()
 {
+    g_ltem->bootState = ltemBootState_idle;
+    qbg_powerOff();
     g_ltem->qbgReadyState = qbg_readyState_powerOff;
-    bg96_powerOff();
 }
 
 
@@ -180,6 +227,7 @@ void ltem_destroy()
 {
 	ltem_stop();
 
+    gpio_detachIsr(g_ltem->pinConfig.statusPin);
 	gpio_pinClose(g_ltem->pinConfig.irqPin);
 	gpio_pinClose(g_ltem->pinConfig.powerkeyPin);
 	gpio_pinClose(g_ltem->pinConfig.resetPin);
@@ -199,9 +247,34 @@ void ltem_destroy()
  */
 void ltem_doWork()
 {
-    if (!ltem_chkHwReady())
+    if (g_ltem->bootState != ltemBootState_ready)               // starting (or not started): no services, no HW ready check
+    {
+        s_bootDoWork();
+        return;
+    }
+
+    if (g_ltem->pwrWork_func != NULL)
+    {
+        g_ltem->pwrWork_func();                                 // power manager tracks sleep\wake, status low is expected in PSM
+    }
+    else if (!ltem_chkHwReady())
         ltem_notifyApp(ltemNotifType_hwNotReady, "LTEm1 I/O Error");
 
+    ntwk_doWork();
+
+    if (g_ltem->gnssWork_func != NULL)
+    {
+        g_ltem->gnssWork_func();
+    }
+    if (g_ltem->geoWork_func != NULL)
+    {
+        g_ltem->geoWork_func();
+    }
+    if (g_ltem->attachWork_func != NULL)
+    {
+        g_ltem->attachWork_func();
+    }
+
     if (g_ltem->scktWork_func != NULL)
     {
         g_ltem->scktWork_func();
@@ -210,6 +283,10 @@ void ltem_doWork()
     {
         g_ltem->mqttWork_func();
     }
+    if (g_ltem->httpdlWork_func != NULL)
+    {
+        g_ltem->httpdlWork_func();
+    }
 }
 
 
@@ -260,6 +337,8 @@ void ltem__initIo()
 
 	gpio_openPin(g_ltem->pinConfig.statusPin, gpioMode_input);
 	gpio_openPin(g_ltem->pinConfig.irqPin, gpioMode_inputPullUp);
+
+    gpio_attachIsr(g_ltem->pinConfig.statusPin, true, gpioIrqTriggerOn_change, qbg__statusIsr);     // BGx power state from status edges
 }
 
 
@@ -269,4 +348,97 @@ void ltem__initIo()
  * --------------------------------------------------------------------------------------------- */
 #pragma region private functions
 
+
+/**
+ *	\brief Advance the start sequence one step, each step waits on an event signaled by ISR (status edge or APP RDY URC).
+ */
+static void s_bootDoWork()
+{
+    switch (g_ltem->bootState)
+    {
+        case ltemBootState_powerKey:
+            if (lTimerExpired(g_ltem->bootStateAt, QBG_POWERON_DELAY))
+            {
+                gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_low);
+                s_setBootState(ltemBootState_powerOn);
+            }
+            break;
+
+        case ltemBootState_powerOn:
+            if (g_ltem->qbgReadyState != qbg_readyState_powerOff)          // status rising edge (qbg__statusIsr)
+            {
+                sc16is741a_start();                                         // start (resets previously powered on) NXP SPI-UART bridge
+                iop_start();
+                s_setBootState(ltemBootState_appReady);
+            }
+            else if (lTimerExpired(g_ltem->bootStateAt, QBG_STATUS_MILLISMAX))
+                s_bootFailed("qbg-BGx module failed to power on in the allowed time");
+            break;
+
+        case ltemBootState_appReady:
+            if (g_ltem->qbgReadyState == qbg_readyState_appReady)          // APP RDY URC (iop_rxParseImmediate)
+            {
+                if (qbg_start())                                            // initialize BGx operating settings
+                {
+                    s_setBootState(ltemBootState_ready);
+                    if (g_ltem->readyCB != NULL)
+                        g_ltem->readyCB(true);
+                }
+                else if (!g_ltem->bootRestarted)                            // init failed: power cycle BGx and retry once
+                {
+                    PRINTF(dbgColor_warn, "BGx restarting, init failed\r");
+                    g_ltem->bootRestarted = true;
+                    gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_high);
+                    s_setBootState(ltemBootState_restartKey);
+                }
+                else
+                    s_bootFailed("qbg-start() init sequence failed");
+            }
+            else if (lTimerExpired(g_ltem->bootStateAt, QBG_APPREADY_MILLISMAX))
+                s_bootFailed("qbg-BGx module failed to start in the allowed time");
+            break;
+
+        case ltemBootState_restartKey:
+            if (lTimerExpired(g_ltem->bootStateAt, QBG_POWEROFF_DELAY))
+            {
+                gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_low);
+                s_setBootState(ltemBootState_restartOff);
+            }
+            break;
+
+        case ltemBootState_restartOff:
+            if (g_ltem->qbgReadyState == qbg_readyState_powerOff)          // status falling edge (qbg__statusIsr)
+            {
+                gpio_writePin(g_ltem->pinConfig.powerkeyPin, gpioValue_high);
+                s_setBootState(ltemBootState_powerKey);                     // continue as power on
+            }
+            else if (lTimerExpired(g_ltem->bootStateAt, QBG_STATUS_MILLISMAX))
+                s_bootFailed("qbg-BGx module failed to power off for restart");
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static void s_setBootState(ltemBootState_t bootState)
+{
+    g_ltem->bootState = bootState;
+    g_ltem->bootStateAt = lMillis();
+}
+
+
+/**
+ *	\brief Start sequence failed, report to application ready callback if registered, otherwise notify (catastrophic).
+ */
+static void s_bootFailed(const char *failMsg)
+{
+    s_setBootState(ltemBootState_failed);
+    if (g_ltem->readyCB != NULL)
+        g_ltem->readyCB(false);
+    else
+        ltem_notifyApp(ltemNotifType_hwInitFailed, failMsg);
+}
+
 #pragma endregion
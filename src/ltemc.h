@@ -49,20 +49,45 @@ extern "C"
 #include "ltemc-atcmd.h"
 #include "ltemc-mdminfo.h"
 #include "ltemc-network.h"
+#include "ltemc-pwrmgmt.h"
+#include "ltemc-dns.h"
 
 /* Optional services
  ------------------------------------------------------------------------------------- */
+#include "ltemc-tls.h"
 #include "ltemc-sockets.h"
 #include "ltemc-mqtt.h"
-//#include "ltemc-http.h"
+#include "ltemc-http.h"
 
 #include "ltemc-gnss.h"
+#include "ltemc-attach.h"
 #include "ltemc-geo.h"
 
 #include <ltemc-filesys.h>
+#include "ltemc-tracklog.h"
+#include "ltemc-httpdl.h"
 /* ----------------------------------------------------------------------------------- */
 
 
+/** 
+ *  \brief Enum describing the progress of the (async) LTEm start sequence, advanced by ltem_doWork().
+*/
+typedef enum ltemBootState_tag
+{
+    ltemBootState_idle = 0,             ///< Not started, or stopped.
+    ltemBootState_powerKey = 1,         ///< Power key pulse in progress.
+    ltemBootState_powerOn = 2,          ///< Waiting for BGx status signal (status pin rising edge).
+    ltemBootState_appReady = 3,         ///< Waiting for BGx firmware ready (APP RDY URC).
+    ltemBootState_ready = 4,            ///< BGx initialized, ready for application/services.
+    ltemBootState_failed = 5,           ///< BGx did not signal within the allowed time, or init failed after restart.
+    ltemBootState_restartKey = 6,       ///< Init failed, power key pulse to power off BGx for a restart.
+    ltemBootState_restartOff = 7        ///< Waiting for BGx power off (status pin falling edge), then power on again.
+} ltemBootState_t;
+
+
+typedef void (*ltemReady_func)(bool ready);     ///< App callback signaling completion of ltem_startAsync()
+
+
 /** 
  *  \brief Struct representing the LTEmC model. The struct behind the g_ltem1 global variable with all driver controls.
  * 
@@ -73,7 +98,11 @@ typedef struct ltemDevice_tag
     // ltem1Functionality_t funcLevel;  ///< Enum value indicating services enabled during ltemC startup.
 	ltemPinConfig_t pinConfig;          ///< GPIO pin configuration for required GPIO and SPI interfacing.
     spiDevice_t *spi;                   ///< SPI device (methods signatures compatible with Arduino).
-    qbgReadyState_t qbgReadyState;      ///< Ready state of the BGx module
+    volatile qbgReadyState_t qbgReadyState; ///< Ready state of the BGx module (updated by status ISR and APP RDY URC)
+    ltemBootState_t bootState;          ///< Progress of the start sequence
+    uint32_t bootStateAt;               ///< Time (millis) boot state entered, for step timeouts
+    bool bootRestarted;                 ///< Start sequence has restarted the BGx after an init failure (once)
+    ltemReady_func readyCB;             ///< Application callback on start sequence completion (success or failure)
     appNotify_func appNotifyCB;         ///< Notification callback to application
     uint8_t dataContext;                ///< The primary APN context with the network carrier for application transfers.
     volatile iop_t *iop;                ///< IOP subsystem controls.
@@ -87,6 +116,14 @@ typedef struct ltemDevice_tag
     void (*scktWork_func)();            ///< Sockets background do work function
     void *mqtt;                         ///< MQTT protocol subsystem.
     void (*mqttWork_func)();            ///< MQTT background do work function
+    void *http;                         ///< HTTP(S) client subsystem.
+    void *pwrMgmt;                      ///< Power management (PSM\eDRX) subsystem.
+    void (*pwrWork_func)();             ///< Power management background do work function, tracks BGx sleep\wake
+    bool (*pwrWake_func)();             ///< Power management wake BGx (from PSM), invoked prior to sending an AT command
+    void (*gnssWork_func)();            ///< GNSS NMEA stream parser background do work function
+    void (*geoWork_func)();             ///< Host geo-fence evaluation background do work function
+    void (*attachWork_func)();          ///< Startup orchestration (network attach, GNSS first fix) background do work function
+    void (*httpdlWork_func)();          ///< HTTP download manager background do work function, fetches one chunk per invoke
 } ltemDevice_t;
 
 
@@ -102,6 +139,8 @@ void ltem_create(const ltemPinConfig_t ltem_config, appNotify_func appNotifyCB);
 void ltem_destroy();
 
 void ltem_start(uint16_t protocolBitMap);
+void ltem_startAsync(uint16_t protocolBitMap, ltemReady_func readyCB);
+ltemBootState_t ltem_getBootState();
 void ltem_stop();
 void ltem_reset();
 bool ltem_chkHwReady();
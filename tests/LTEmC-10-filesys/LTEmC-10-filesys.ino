@@ -39,14 +39,19 @@
 
 #define ASSERT(expected_true, failMsg)  if(!(expected_true))  indicateFailure(failMsg)
 #define ASSERT_NOTEMPTY(string, failMsg)  if(string[0] == '\0') indicateFailure(failMsg)
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
 
 // test setup
 #define CYCLE_INTERVAL 5000
+#define TEST_FILESZ 8192                // bytes written\read each cycle, throughput is reported in KB/s
+#define TEST_WRITECHUNK 1024
 uint16_t loopCnt = 1;
 uint32_t lastCycle;
 
-uint16_t fileHandle;
+char writeBuf[TEST_WRITECHUNK];
+uint32_t readCnt;
+uint32_t readErrCnt;
 
 
 void setup() {
@@ -64,6 +69,14 @@ void setup() {
 
     ltem_create(ltem_pinConfig, NULL);
     ltem_start(pdpProtocol_none);
+
+    for (size_t i = 0; i < TEST_WRITECHUNK; i++)                    // test pattern, position recoverable from content
+    {
+        writeBuf[i] = (char)(i & 0xFF);
+    }
+    fileInfoResult_t info = filsys_info();
+    ASSERT(info.resultCode == RESULT_CODE_SUCCESS, "filsys_info() failed");
+    PRINTF(DBGCOLOR_info, "UFS free=%lu, total=%lu, files=%d\r", info.freeSz, info.totalSz, info.filesCnt);
 }
 
 
@@ -76,16 +89,61 @@ void loop()
 
         // open (create) file
         snprintf(testFile, 12, "test%d.txt", loopCnt);
-        filsys_open(testFile, fileOpenMode_normalRdWr, fileReadReceiver);
+        fileOpenResult_t openResult = filsys_open(testFile, fileOpenMode_clearRdWr, fileReadReceiver);
+        ASSERT(openResult.resultCode == RESULT_CODE_SUCCESS, "filsys_open() failed");
+
         // write to it
+        uint32_t startAt = lMillis();
+        for (size_t i = 0; i < TEST_FILESZ / TEST_WRITECHUNK; i++)
+        {
+            fileWriteResult_t writeResult = filsys_write(openResult.fileHandle, writeBuf, TEST_WRITECHUNK);
+            ASSERT(writeResult.resultCode == RESULT_CODE_SUCCESS && writeResult.writtenSz == TEST_WRITECHUNK, "filsys_write() failed");
+        }
+        uint32_t writeDuration = lMillis() - startAt;
+
+        // read it back
+        ASSERT(filsys_seek(openResult.fileHandle, 0, fileSeekMode_seekFromBegin) == RESULT_CODE_SUCCESS, "filsys_seek() failed");
+        readCnt = 0;
+        readErrCnt = 0;
+        startAt = lMillis();
+        ASSERT(filsys_read(openResult.fileHandle, TEST_FILESZ) == RESULT_CODE_SUCCESS, "filsys_read() failed");
+        uint32_t readDuration = lMillis() - startAt;
+
+        ASSERT(readCnt == TEST_FILESZ, "Read size mismatch");
+        ASSERT(readErrCnt == 0, "Read data mismatch");
+        PRINTF(DBGCOLOR_info, "Write %d bytes: %lums (%lu KB/s)\r", TEST_FILESZ, writeDuration, TEST_FILESZ / MAX(writeDuration, 1));
+        PRINTF(DBGCOLOR_info, "Read %d bytes: %lums (%lu KB/s)\r", TEST_FILESZ, readDuration, TEST_FILESZ / MAX(readDuration, 1));
+
+        filsys_close(openResult.fileHandle);
+
+        fileListResult_t listResult = filsys_list("test*");
+        ASSERT(listResult.resultCode == RESULT_CODE_SUCCESS, "filsys_list() failed");
+        for (size_t i = 0; i < listResult.fileCnt; i++)
+        {
+            PRINTF(DBGCOLOR_dCyan, "  %s  %lu\r", listResult.fileList[i].filename, listResult.fileList[i].fileSize);
+        }
+
+        // upload\download: content from source function, verified by checksum
+        startAt = lMillis();
+        fileUploadResult_t uploadResult = filsys_upload("upload.bin", TEST_FILESZ, NULL, uploadSource, xferProgress);
+        ASSERT(uploadResult.resultCode == RESULT_CODE_SUCCESS && uploadResult.size == TEST_FILESZ, "filsys_upload() failed");
+        PRINTF(DBGCOLOR_info, "Upload %d bytes: %lums, checksum=%04X\r", TEST_FILESZ, lMillis() - startAt, uploadResult.checksum);
+
+        readCnt = 0;
+        readErrCnt = 0;
+        startAt = lMillis();
+        fileDownloadResult_t downloadResult = filsys_download("upload.bin", NULL, fileReadReceiver, xferProgress);
+        ASSERT(downloadResult.resultCode == RESULT_CODE_SUCCESS && downloadResult.size == TEST_FILESZ, "filsys_download() failed");
+        ASSERT(downloadResult.checksum == uploadResult.checksum && readErrCnt == 0, "Download checksum mismatch");
+        PRINTF(DBGCOLOR_info, "Download %d bytes: %lums\r", TEST_FILESZ, lMillis() - startAt);
 
         if (loopCnt > 1)
         {
-            // open previous file
-            // get file pointer
+            // remove previous file
+            snprintf(testFile, 12, "test%d.txt", loopCnt - 1);
+            ASSERT(filsys_delete(testFile) == RESULT_CODE_SUCCESS, "filsys_delete() failed");
         }
 
-
         loopCnt++;
         PRINTF(DBGCOLOR_magenta, "\rFreeMem=%u  <<Loop=%d>>\r", getFreeMemory(), loopCnt);
     }
@@ -98,6 +156,29 @@ void loop()
 
 void fileReadReceiver(uint16_t fileHandle, void *fileData, uint16_t dataSz)
 {
+    char *readData = (char *)fileData;
+    for (size_t i = 0; i < dataSz; i++)
+    {
+        if (readData[i] != (char)((readCnt + i) & 0xFF))
+            readErrCnt++;
+    }
+    readCnt += dataSz;
+}
+
+
+uint16_t uploadSource(uint32_t offset, char *chunkBuf, uint16_t chunkSz)
+{
+    for (size_t i = 0; i < chunkSz; i++)
+    {
+        chunkBuf[i] = (char)((offset + i) & 0xFF);
+    }
+    return chunkSz;
+}
+
+
+void xferProgress(uint32_t xferSz, uint32_t fileSz)
+{
+    PRINTF(DBGCOLOR_dCyan, "  xfer %lu of %lu\r", xferSz, fileSz);
 }
 
 
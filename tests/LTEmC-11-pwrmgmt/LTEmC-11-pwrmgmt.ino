@@ -0,0 +1,214 @@
+/******************************************************************************
+ *  \file LTEmC-11-pwrmgmt.ino
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Test 11: power management. PSM timer (T3412\T3324) and eDRX cycle encoding
+ * is verified against 3GPP 24.008 values (no BGx required), then PSM is
+ * requested and the BGx is exercised through sleep\wake cycles.
+ *
+ * The sketch is designed for debug output to observe results.
+ *****************************************************************************/
+
+#define _DEBUG 2                        // set to non-zero value for PRINTF debugging output,
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+// define options for how to assemble this build
+#define HOST_FEATHER_UXPLOR             // specify the pin configuration
+
+#include <ltemc.h>
+
+#define PSM_TAU_SECONDS 3600
+#define PSM_ACTIVE_SECONDS 60
+
+typedef struct timerVector_tag
+{
+    uint32_t value;
+    uint8_t encoded;
+} timerVector_t;
+
+// GPRS timer octet: bits 8-6 unit, bits 5-1 multiplier; values round up to next representable, saturate at max
+const timerVector_t t3412Vectors[] = { {60, 0x7E}, {3600, 0x06}, {86400, 0x38}, {34560000, 0xDE}, {40000000, 0xDF} };
+const timerVector_t t3324Vectors[] = { {10, 0x05}, {60, 0x1E}, {120, 0x22}, {3600, 0x4A}, {20000, 0x5F} };
+const timerVector_t edrxVectors[] = { {5120, 0}, {20000, 2}, {20000000, 15} };
+
+
+void setup()
+{
+    #ifdef SERIAL_OPT
+        Serial.begin(115200);
+        #if (SERIAL_OPT > 0)
+        while (!Serial) {}      // force wait for serial ready
+        #else
+        delay(5000);            // just give it some time
+        #endif
+    #endif
+
+    PRINTF(DBGCOLOR_dRed, "LTEmC test11: Power Management\r");
+    gpio_openPin(LED_BUILTIN, gpioMode_output);
+
+    /* encoders: pure functions, no BGx traffic */
+    for (size_t i = 0; i < sizeof(t3412Vectors) / sizeof(timerVector_t); i++)
+    {
+        uint8_t encoded = pwr__encodeT3412(t3412Vectors[i].value);
+        PRINTF(DBGCOLOR_none, "T3412 %lu=%02X\r", t3412Vectors[i].value, encoded);
+        if (encoded != t3412Vectors[i].encoded)
+            indicateFailure("T3412 (periodic TAU) encoding failed.");
+    }
+    for (size_t i = 0; i < sizeof(t3324Vectors) / sizeof(timerVector_t); i++)
+    {
+        uint8_t encoded = pwr__encodeT3324(t3324Vectors[i].value);
+        PRINTF(DBGCOLOR_none, "T3324 %lu=%02X\r", t3324Vectors[i].value, encoded);
+        if (encoded != t3324Vectors[i].encoded)
+            indicateFailure("T3324 (active time) encoding failed.");
+    }
+    for (size_t i = 0; i < sizeof(edrxVectors) / sizeof(timerVector_t); i++)
+    {
+        uint8_t encoded = pwr__encodeEdrx(edrxVectors[i].value);
+        PRINTF(DBGCOLOR_none, "eDRX %lu=%d\r", edrxVectors[i].value, encoded);
+        if (encoded != edrxVectors[i].encoded)
+            indicateFailure("eDRX cycle encoding failed.");
+    }
+    PRINTF(DBGCOLOR_info, "Encoders passed\r");
+
+    ltem_create(ltem_pinConfig, appNotifyCB);
+    pwr_create();
+    ltem_start(pdpProtocol_none);
+
+    resultCode_t rslt = pwr_setPsm(true, PSM_TAU_SECONDS, PSM_ACTIVE_SECONDS);
+    PRINTF(DBGCOLOR_info, "PSM request=%d\r", rslt);
+    if (rslt != RESULT_CODE_SUCCESS)
+        indicateFailure("PSM request failed.");
+}
+
+
+int loopCnt = 0;
+uint32_t lastCmdAt = 0;
+
+void loop()
+{
+    ltem_doWork();                                          // advances wake (power key pulse, APP RDY) and restores session after PSM
+
+    if (lTimerExpired(lastCmdAt, PERIOD_FROM_SECONDS(PSM_ACTIVE_SECONDS * 2)) || lastCmdAt == 0)
+    {
+        PRINTF(DBGCOLOR_none, "State=%d, invoking ATI\r", pwr_getState());
+        if (atcmd_tryInvoke("ATI"))                         // wakes BGx if in PSM: not sent until BGx is awake
+        {
+            atcmdResult_t atResult = atcmd_awaitResult(true);
+            PRINTF(DBGCOLOR_info, "ATI=%d\r", atResult.statusCode);
+            lastCmdAt = lMillis();
+            loopCnt++;
+            indicateLoop(loopCnt, 0);
+        }
+        else
+            PRINTF(DBGCOLOR_warn, "BGx waking (or action lock busy), retry.\r");
+    }
+    lDelay(100);
+}
+
+
+/* test helpers
+========================================================================================================================= */
+
+
+void appNotifyCB(uint8_t notifType, const char *notifMsg)
+{
+    if (notifType > 200)
+    {
+        PRINTF(DBGCOLOR_error, "LQCloud-HardFault: %s\r", notifMsg);
+        while (1) {}
+    }
+    PRINTF(DBGCOLOR_info, "LQCloud Info: %s\r", notifMsg);
+    return;
+}
+
+
+void indicateFailure(char failureMsg[])
+{
+	PRINTF(DBGCOLOR_error, "\r\n** %s \r", failureMsg);
+    PRINTF(DBGCOLOR_error, "** Test Assertion Failed. \r");
+
+    #if 1
+    PRINTF(DBGCOLOR_error, "** Halting Execution \r\n");
+    bool halt = true;
+    while (halt)
+    {
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_high);
+        lDelay(1000);
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_low);
+        lDelay(100);
+    }
+    #endif
+}
+
+
+void indicateLoop(int loopCnt, int waitNext)
+{
+    PRINTF(DBGCOLOR_info, "\r\nLoop=%i \r\n", loopCnt);
+
+    for (int i = 0; i < 6; i++)
+    {
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_high);
+        lDelay(50);
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_low);
+        lDelay(50);
+    }
+
+    PRINTF(DBGCOLOR_magenta, "FreeMem=%u\r\n", getFreeMemory());
+    PRINTF(DBGCOLOR_none, "NextTest (millis)=%i\r\r", waitNext);
+    lDelay(waitNext);
+}
+
+
+/* Check free memory (stack-heap)
+ * - Remove if not needed for production
+--------------------------------------------------------------------------------- */
+
+#ifdef __arm__
+// should use uinstd.h to define sbrk but Due causes a conflict
+extern "C" char* sbrk(int incr);
+#else  // __ARM__
+extern char *__brkval;
+#endif  // __arm__
+
+int getFreeMemory()
+{
+    char top;
+    #ifdef __arm__
+    return &top - reinterpret_cast<char*>(sbrk(0));
+    #elif defined(CORE_TEENSY) || (ARDUINO > 103 && ARDUINO != 151)
+    return &top - __brkval;
+    #else  // __arm__
+    return __brkval ? &top - __brkval : &top - __malloc_heap_start;
+    #endif  // __arm__
+}
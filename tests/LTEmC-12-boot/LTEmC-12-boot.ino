@@ -0,0 +1,269 @@
+/******************************************************************************
+ *  \file LTEmC-12-boot.ino
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Test 12: async start sequence (ltem_startAsync) with simulated BGx pin
+ * edges. The BGx status and power key signals are moved to spare host pins
+ * jumpered to pins driven\read by the sketch:
+ *      SIM_STATUS_PIN (LTEmC status input)  <-- jumper -->  SIM_STATUS_DRIVE
+ *      SIM_POWERKEY_PIN (LTEmC power key)   <-- jumper -->  SIM_POWERKEY_SENSE
+ *
+ * APP RDY is simulated, BGx never answers so init (qbg_start) fails: the
+ * sequence must power cycle the BGx once (restart states) then fail. Each
+ * power key\status step is checked for timing and non-blocking doWork.
+ *
+ * The sketch is designed for debug output to observe results.
+ *****************************************************************************/
+
+#define _DEBUG 2                        // set to non-zero value for PRINTF debugging output,
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+// define options for how to assemble this build
+#define HOST_FEATHER_UXPLOR             // specify the pin configuration
+
+#include <ltemc.h>
+
+#define SIM_STATUS_PIN      15          // A1
+#define SIM_STATUS_DRIVE    16          // A2
+#define SIM_POWERKEY_PIN    17          // A3
+#define SIM_POWERKEY_SENSE  18          // A4
+
+#define SIM_DOWORK_MAXml    20          // doWork in a pin step (no AT traffic) must return within this
+#define SIM_PULSE_TOLml     100         // power key pulse width tolerance
+
+int readyResult = -1;
+
+
+void setup()
+{
+    #ifdef SERIAL_OPT
+        Serial.begin(115200);
+        #if (SERIAL_OPT > 0)
+        while (!Serial) {}      // force wait for serial ready
+        #else
+        delay(5000);            // just give it some time
+        #endif
+    #endif
+
+    PRINTF(DBGCOLOR_dRed, "LTEmC test12: Async Start (simulated pins)\r");
+    gpio_openPin(LED_BUILTIN, gpioMode_output);
+
+    gpio_writePin(SIM_STATUS_DRIVE, gpioValue_low);                     // BGx powered off
+    gpio_openPin(SIM_STATUS_DRIVE, gpioMode_output);
+    gpio_openPin(SIM_POWERKEY_SENSE, gpioMode_input);
+
+    ltemPinConfig_t simPinConfig = ltem_pinConfig;
+    simPinConfig.statusPin = SIM_STATUS_PIN;
+    simPinConfig.powerkeyPin = SIM_POWERKEY_PIN;
+    ltem_create(simPinConfig, appNotifyCB);
+}
+
+
+int loopCnt = 0;
+
+void loop()
+{
+    readyResult = -1;
+    gpio_writePin(SIM_STATUS_DRIVE, gpioValue_low);
+    lDelay(10);
+
+    ltem_startAsync(pdpProtocol_none, readyCB);
+    if (ltem_getBootState() != ltemBootState_powerKey || !gpio_readPin(SIM_POWERKEY_SENSE))
+        indicateFailure("Power key not asserted at start.");
+
+    /* power on: key pulse, status rising edge, APP RDY */
+    powerOnSteps();
+
+    /* init fails (no BGx response): restart, key held for power off */
+    if (!pumpUntil(ltemBootState_restartKey, 60000, false))
+        indicateFailure("Init failure did not restart BGx.");
+    if (!gpio_readPin(SIM_POWERKEY_SENSE))
+        indicateFailure("Power key not asserted for restart.");
+    uint32_t keyAt = lMillis();
+    if (!pumpUntil(ltemBootState_restartOff, QBG_POWEROFF_DELAY + SIM_PULSE_TOLml, true))
+        indicateFailure("Restart power key not released.");
+    checkPulse(keyAt, QBG_POWEROFF_DELAY);
+
+    gpio_writePin(SIM_STATUS_DRIVE, gpioValue_low);                     // status falling edge: BGx off
+    if (!pumpUntil(ltemBootState_powerKey, SIM_PULSE_TOLml, true) || !gpio_readPin(SIM_POWERKEY_SENSE))
+        indicateFailure("Restart power on not started.");
+
+    powerOnSteps();
+
+    /* second init failure ends the sequence */
+    if (!pumpUntil(ltemBootState_failed, 60000, false) || readyResult != 0)
+        indicateFailure("Start sequence did not fail after restart.");
+    if (gpio_readPin(SIM_POWERKEY_SENSE))
+        indicateFailure("Power key left asserted.");
+
+    PRINTF(DBGCOLOR_info, "Start sequence passed\r");
+    loopCnt ++;
+    indicateLoop(loopCnt, 1000);
+}
+
+
+/*
+========================================================================================================================= */
+
+/**
+ *	\brief Power key pulse, status edge then (simulated) APP RDY.
+ */
+void powerOnSteps()
+{
+    uint32_t keyAt = lMillis();
+    if (!pumpUntil(ltemBootState_powerOn, QBG_POWERON_DELAY + SIM_PULSE_TOLml, true))
+        indicateFailure("Power on key not released.");
+    checkPulse(keyAt, QBG_POWERON_DELAY);
+
+    gpio_writePin(SIM_STATUS_DRIVE, gpioValue_high);                    // status rising edge: BGx on
+    if (!pumpUntil(ltemBootState_appReady, SIM_PULSE_TOLml, true))
+        indicateFailure("Status edge not detected.");
+
+    g_ltem->qbgReadyState = qbg_readyState_appReady;                    // APP RDY URC (set by IOP ISR)
+}
+
+
+/**
+ *	\brief Invoke ltem_doWork() until the boot state is reached, optionally checking each invoke returns promptly.
+ */
+bool pumpUntil(ltemBootState_t bootState, uint32_t timeout, bool timed)
+{
+    uint32_t startAt = lMillis();
+    while (ltem_getBootState() != bootState)
+    {
+        if (lTimerExpired(startAt, timeout))
+        {
+            PRINTF(DBGCOLOR_error, "Waiting for state=%d, in state=%d\r", bootState, ltem_getBootState());
+            return false;
+        }
+        uint32_t workAt = lMillis();
+        ltem_doWork();
+        if (timed && lMillis() - workAt > SIM_DOWORK_MAXml)
+            indicateFailure("ltem_doWork() blocked.");
+    }
+    return true;
+}
+
+
+void checkPulse(uint32_t keyAt, uint32_t pulseWidth)
+{
+    uint32_t width = lMillis() - keyAt;
+    PRINTF(DBGCOLOR_none, "Power key pulse=%lums\r", width);
+    if (gpio_readPin(SIM_POWERKEY_SENSE) || width < pulseWidth)
+        indicateFailure("Power key pulse width.");
+}
+
+
+void readyCB(bool ready)
+{
+    readyResult = ready;
+}
+
+
+
+/* test helpers
+========================================================================================================================= */
+
+
+void appNotifyCB(uint8_t notifType, const char *notifMsg)
+{
+    if (notifType > 200)
+    {
+        PRINTF(DBGCOLOR_error, "LQCloud-HardFault: %s\r", notifMsg);
+        while (1) {}
+    }
+    PRINTF(DBGCOLOR_info, "LQCloud Info: %s\r", notifMsg);
+    return;
+}
+
+
+void indicateFailure(char failureMsg[])
+{
+	PRINTF(DBGCOLOR_error, "\r\n** %s \r", failureMsg);
+    PRINTF(DBGCOLOR_error, "** Test Assertion Failed. \r");
+
+    #if 1
+    PRINTF(DBGCOLOR_error, "** Halting Execution \r\n");
+    bool halt = true;
+    while (halt)
+    {
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_high);
+        lDelay(1000);
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_low);
+        lDelay(100);
+    }
+    #endif
+}
+
+
+void indicateLoop(int loopCnt, int waitNext)
+{
+    PRINTF(DBGCOLOR_info, "\r\nLoop=%i \r\n", loopCnt);
+
+    for (int i = 0; i < 6; i++)
+    {
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_high);
+        lDelay(50);
+        gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_low);
+        lDelay(50);
+    }
+
+    PRINTF(DBGCOLOR_magenta, "FreeMem=%u\r\n", getFreeMemory());
+    PRINTF(DBGCOLOR_none, "NextTest (millis)=%i\r\r", waitNext);
+    lDelay(waitNext);
+}
+
+
+/* Check free memory (stack-heap)
+ * - Remove if not needed for production
+--------------------------------------------------------------------------------- */
+
+#ifdef __arm__
+// should use uinstd.h to define sbrk but Due causes a conflict
+extern "C" char* sbrk(int incr);
+#else  // __ARM__
+extern char *__brkval;
+#endif  // __arm__
+
+int getFreeMemory()
+{
+    char top;
+    #ifdef __arm__
+    return &top - reinterpret_cast<char*>(sbrk(0));
+    #elif defined(CORE_TEENSY) || (ARDUINO > 103 && ARDUINO != 151)
+    return &top - __brkval;
+    #else  // __arm__
+    return __brkval ? &top - __brkval : &top - __malloc_heap_start;
+    #endif  // __arm__
+}
@@ -62,6 +62,8 @@ void setup() {
     
     randomSeed(analogRead(0));
 
+    benchmarkLocationParse();
+
     ltem_create(ltem_pinConfig, appNotifyCB);
     ltem_start(pdpProtocol_none);
 
@@ -84,7 +86,8 @@ void loop() {
         char cLon[14];
         
         PRINTF(DBGCOLOR_none, "Location Information\r");
-        PRINTF(DBGCOLOR_cyan, "Lat=%4.4f, Lon=%4.4f \r", location.lat.val, location.lon.val);
+        PRINTF(DBGCOLOR_cyan, "Lat=%4.4f, Lon=%4.4f \r", gnss_toDegrees(location.lat.val), gnss_toDegrees(location.lon.val));
+        PRINTF(DBGCOLOR_cyan, "Lat(e7)=%ld, Lon(e7)=%ld, Alt(cm)=%ld \r", location.lat.val, location.lon.val, location.altitude);
     }
     else
         PRINTF(DBGCOLOR_warn, "Location is not available (GNSS not fixed)\r");
@@ -99,6 +102,44 @@ void loop() {
 /* test helpers
 ========================================================================================================================= */
 
+#define BENCH_ITERATIONS 1000
+char benchLocation[] = "121003.0,44.74769,-85.56535,1.1,189.0,2,95.45,0.0,0.0,250420,08\r\n";
+
+/* Compare fixed-point location parser (LTEmC) with the prior strtof() parse on this host MCU.
+ */
+void benchmarkLocationParse()
+{
+    gnssLocation_t location;
+    uint32_t startAt = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        gnss__parseLocation(benchLocation, &location);
+    }
+    uint32_t fixedDuration = micros() - startAt;
+
+    volatile float floatResult;
+    char *continueAt;
+    startAt = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        continueAt = strchr(benchLocation, ',') + 1;
+        floatResult = strtof(continueAt, &continueAt);              // lat
+        floatResult = strtof(++continueAt, &continueAt);            // lon
+        floatResult = strtof(++continueAt, &continueAt);            // hdop
+        floatResult = strtof(++continueAt, &continueAt);            // altitude
+        floatResult = strtol(++continueAt, &continueAt, 10);        // fix type
+        floatResult = strtof(++continueAt, &continueAt);            // course
+        floatResult = strtof(++continueAt, &continueAt);            // speed km
+        floatResult = strtof(++continueAt, &continueAt);            // speed kn
+    }
+    uint32_t floatDuration = micros() - startAt;
+
+    PRINTF(DBGCOLOR_info, "Location parse x%d: fixed-point=%luus, strtof=%luus\r", BENCH_ITERATIONS, fixedDuration, floatDuration);
+    if (location.lat.val != 447476900 || location.lon.val != -855653500 || location.altitude != 18900)
+        indicateFailure("Fixed-point location parse mismatch");
+}
+
+
 void appNotifyCB(uint8_t notifType, const char *notifMsg)
 {
     if (notifType > 200)
@@ -0,0 +1,213 @@
+/******************************************************************************
+ *  \file LTEmC-9-http.ino
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2021 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Test HTTP(S) client GET/POST, with response bodies streamed to a receiver.
+ * 
+ * The sketch is designed for debug output to observe results.
+ *****************************************************************************/
+
+#define _DEBUG 2                        // set to non-zero value for PRINTF debugging output, 
+// debugging output options             // LTEm1c will satisfy PRINTF references with empty definition if not already resolved
+#if defined(_DEBUG) && _DEBUG > 0
+    asm(".global _printf_float");       // forces build to link in float support for printf
+    #if _DEBUG == 1
+    #define SERIAL_DBG 1                // enable serial port output using devl host platform serial, 1=wait for port
+    #elif _DEBUG == 2
+    #include <jlinkRtt.h>               // output debug PRINTF macros to J-Link RTT channel
+    #endif
+#else
+#define PRINTF(c_, f_, ...) ;
+#endif
+
+
+// define options for how to assemble this build
+#define HOST_FEATHER_UXPLOR             // specify the pin configuration
+
+#include <ltemc.h>
+
+#define ASSERT(expected_true, failMsg)  if(!(expected_true))  appNotifRecvr(255, failMsg)
+
+// test setup
+#define CYCLE_INTERVAL 15000
+#define DEFAULT_NETWORK_CONTEXT 1
+#define HTTP_GET_URL "http://httpbin.org/bytes/4096"        // 4KB body with content-length, multiple receiver chunks
+#define HTTP_POST_URL "http://httpbin.org/post"             // echoes request
+#define POST_BODY_SZ 3000                                   // body larger than IOP TX buffer
+#define SESSION_HOST "httpbin.org"                          // keep-alive session, pipelined GETs
+#define SESSION_SOCKET 0
+#define SESSION_REQUESTS 3
+
+uint16_t loopCnt = 0;
+uint32_t lastCycle;
+
+uint32_t bodySz;
+uint16_t chunkCnt;
+char postBody[POST_BODY_SZ];
+uint8_t responseCnt;
+
+
+void setup() {
+    #ifdef SERIAL_OPT
+        Serial.begin(115200);
+        #if (SERIAL_OPT > 0)
+        while (!Serial) {}      // force wait for serial ready
+        #else
+        delay(5000);            // just give it some time
+        #endif
+    #endif
+
+    PRINTF(DBGCOLOR_error, "\rLTEmC Test: 9-HTTP\r\n");
+
+    ltem_create(ltem_pinConfig, appNotifRecvr);                     // create base modem object
+    http_create();                                                  // add optional services: here HTTP(S)
+    sckt_create();                                                  // sockets carry the keep-alive session
+    ltem_start(pdpProtocol_http | pdpProtocol_sockets);           // now start modem
+
+    PRINTF(DBGCOLOR_none, "Waiting on network...\r");
+    networkOperator_t networkOp = ntwk_awaitOperator(120 * 1000);
+    if (strlen(networkOp.operName) == 0)
+        appNotifRecvr(255, "Timeout (120s) waiting for cellular network.");
+
+    PRINTF(DBGCOLOR_info, "Network type is %s on %s\r", networkOp.ntwkMode, networkOp.operName);
+
+    uint8_t cntxtCnt = ntwk_getActivePdpCntxtCnt();
+    if (cntxtCnt == 0)
+    {
+        ntwk_activatePdpContext(DEFAULT_NETWORK_CONTEXT);
+    }
+
+    for (size_t i = 0; i < POST_BODY_SZ; i++)
+    {
+        postBody[i] = 'A' + (i % 26);
+    }
+}
+
+
+void loop() 
+{
+    if (lMillis() - lastCycle >= CYCLE_INTERVAL)
+    {
+        lastCycle = lMillis();
+
+        // GET: body streamed to receiver in chunks (HTTP_RECV_CHUNKSZ)
+        bodySz = 0;
+        chunkCnt = 0;
+        uint32_t startAt = lMillis();
+        resultCode_t rslt = http_get(HTTP_GET_URL, httpReceiver);
+        PRINTF(DBGCOLOR_cyan, "GET rslt=%d, contentLen=%lu, recvd=%lu in %d chunks, %lums\r", rslt, http_getContentLength(), bodySz, chunkCnt, lMillis() - startAt);
+        ASSERT(rslt == 200, "GET failed");
+        ASSERT(bodySz == http_getContentLength(), "GET body size mismatch");
+
+        // POST: body streamed from caller buffer
+        bodySz = 0;
+        chunkCnt = 0;
+        startAt = lMillis();
+        rslt = http_post(HTTP_POST_URL, postBody, POST_BODY_SZ, httpReceiver);
+        PRINTF(DBGCOLOR_cyan, "POST rslt=%d, response=%lu bytes, %lums\r", rslt, bodySz, lMillis() - startAt);
+        ASSERT(rslt == 200, "POST failed");
+
+        // SESSION: pipelined GETs on one connection, responses framed from socket stream
+        if (loopCnt == 0)
+        {
+            rslt = http_sessionOpen(SESSION_SOCKET, SESSION_HOST, 80, false, httpReceiver, httpResponse);
+            ASSERT(rslt == 200, "Session open failed");
+        }
+        responseCnt = 0;
+        startAt = lMillis();
+        for (size_t i = 0; i < SESSION_REQUESTS; i++)
+        {
+            rslt = http_sessionGet("/get");
+            ASSERT(rslt == 200, "Session GET send failed");
+        }
+        while (http_sessionPending() > 0 && lMillis() - startAt < 30000)
+        {
+            ltem_doWork();
+        }
+        PRINTF(DBGCOLOR_cyan, "SESSION responses=%d, %lums\r", responseCnt, lMillis() - startAt);
+        ASSERT(responseCnt == SESSION_REQUESTS, "Session responses missing");
+
+        loopCnt++;
+        PRINTF(DBGCOLOR_magenta, "FreeMem=%u  Loop=%d\r", getFreeMemory(), loopCnt);
+    }
+    ltem_doWork();
+}
+
+
+/**
+ *  \brief Application receiver for response body chunks.
+*/
+void httpReceiver(void *data, uint16_t dataSz)
+{
+    bodySz += dataSz;
+    chunkCnt++;
+    PRINTF(DBGCOLOR_info, "  chunk %d: %d bytes\r", chunkCnt, dataSz);
+}
+
+
+/**
+ *  \brief Application notification of a complete session response.
+*/
+void httpResponse(uint16_t httpStatus, uint32_t bodySz)
+{
+    responseCnt++;
+    PRINTF(DBGCOLOR_info, "  response %d: status=%d, body=%lu\r", responseCnt, httpStatus, bodySz);
+}
+
+
+/* test helpers
+========================================================================================================================= */
+
+void appNotifRecvr(uint8_t notifType, const char *notifMsg)
+{
+	PRINTF(DBGCOLOR_error, "\r\n** %s \r\n", notifMsg);
+    PRINTF(DBGCOLOR_error, "** Test Assertion Failed. \r\n");
+    gpio_writePin(LED_BUILTIN, gpioPinValue_t::gpioValue_high);
+
+    while (1) {}
+}
+
+
+/* Check free memory (stack-heap) 
+ * - Remove if not needed for production
+--------------------------------------------------------------------------------- */
+
+#ifdef __arm__
+// should use uinstd.h to define sbrk but Due causes a conflict
+extern "C" char* sbrk(int incr);
+#else  // __ARM__
+extern char *__brkval;
+#endif  // __arm__
+
+int getFreeMemory() 
+{
+    char top;
+    #ifdef __arm__
+    return &top - reinterpret_cast<char*>(sbrk(0));
+    #elif defined(CORE_TEENSY) || (ARDUINO > 103 && ARDUINO != 151)
+    return &top - __brkval;
+    #else  // __arm__
+    return __brkval ? &top - __brkval : &top - __malloc_heap_start;
+    #endif  // __arm__
+}
+